@@ -0,0 +1,1868 @@
+#include <JuceHeader.h>
+#include "../eclistarVST(main)/PluginProcessor.h"
+
+#include <iostream>
+
+using namespace compressor_parameters;
+
+//==============================================================================================
+// Benchmarks of the DSP of the plugin.
+//
+// The results are written as JSON, so they can be compared between builds and machines.
+// All times are given in nanoseconds per sample frame (all channels of one sample). The
+// benchmarks that compare against a reference are also tests: when one of their checks fails
+// (bit-identical fused and parallel output, the untouched passthrough, identical presets, the
+// bound of the gain computer), it is printed to stderr and the exit code is 1.
+//
+//  - processBlock: matrix of sample rates, block sizes, channels and band modes, with the
+//    time of every stage (the target is built with ECLISTAR_STAGE_TIMING);
+//  - fused: per-stage and fused engines, with the check of the bit-identical output;
+//  - silence: active processing against the idle sleep on a silent input;
+//  - passthrough: every band bypassed at 0 dB, with the check that the input is passed untouched;
+//  - bands: scaling of processBlock, the crossover and the compressors from 2 to 8 bands;
+//  - oversampling: cost and latency of every oversampling factor and quality;
+//  - lookahead: cost and latency of the lookahead, which must not grow with its length;
+//  - precision: processBlock with float and with double buffers, and their difference;
+//  - channels: cost per channel from mono to 16 channels, with and without linked detection;
+//  - parallel: wall-clock time per block with the bands compressed by 0 to 15 worker threads;
+//  - metering: cost of the meters of the editor (target: below 1% of processBlock);
+//  - analyzer: cost of the spectrum analyzer on the audio thread (one copy per block and tap);
+//  - tracing: cost of the block tracer off and on, with the latency percentiles it reports;
+//  - sidechain: processBlock and the split without a sidechain, with one and with keyed bands;
+//  - presets: scene change of many instances with the ValueTree state and the binary preset;
+//  - crossover: VstCrossover against the chain of five LinkwitzRileyFilter;
+//  - crossoverSweep: automated crossovers, with the shared tables of prewarped gains against
+//    std::tan (cost and error) and the cost of moving crossovers in VstCrossover and processBlock;
+//  - linearPhase: the linear-phase split against VstCrossover, with the error of its sum;
+//  - compressor: MultiBandCompressorSIMD against its scalar path and juce Compressor;
+//  - gainComputer: error of the fast log-domain gain computer against the exact curves (all
+//    ratios, thresholds and knees), and its throughput against the power law with std::pow.
+
+namespace
+{
+    const char* const usage =
+        "Usage: eclistarBenchmark [options]\n"
+        "\n"
+        "  --output <file>      write the JSON results to a file (default: standard output)\n"
+        "  --seconds <value>    length of the processed signal per measurement (default: 2)\n"
+        "  --quick              reduced matrix of sample rates and block sizes\n";
+
+    struct BenchmarkOptions
+    {
+        File output;
+        double seconds{ 2.0 };
+        bool quick{ false };
+    };
+
+    // Checks of the benchmarks (property true in the result, or in all entries of an array).
+
+    struct Check
+    {
+        const char* benchmark;
+        const char* property;
+    };
+
+    const Check checks[] =
+    {
+        { "fused", "bitIdentical" },
+        { "parallel", "bitIdentical" },
+        { "passthrough", "isPassthrough" },
+        { "presets", "identical" },
+        { "gainComputer", "withinBound" }
+    };
+
+    bool IsPassed(const var& result, const Identifier& property)
+    {
+        if (auto* entries = result.getArray())
+        {
+            for (const auto& entry : *entries)
+            {
+                if (!IsPassed(entry, property))
+                    return false;
+            }
+
+            return true;
+        }
+
+        return (bool)result.getProperty(property, false);
+    }
+
+    // Deterministic test signal: white noise at full scale.
+
+    AudioBuffer <float> MakeSignal(int numChannels, int numSamples)
+    {
+        AudioBuffer <float> signal(numChannels, numSamples);
+        Random random(20230515);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                signal.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+            }
+        }
+
+        return signal;
+    }
+
+    double NanosecondsPerSample(int64 ticks, int64 numSamples)
+    {
+        return Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / (double)jmax((int64)1, numSamples);
+    }
+
+    float MaxDifference(const AudioBuffer <float>& a, const AudioBuffer <float>& b)
+    {
+        auto difference = 0.0f;
+
+        for (int channel = 0; channel < a.getNumChannels(); ++channel)
+        {
+            for (int i = 0; i < a.getNumSamples(); ++i)
+            {
+                difference = jmax(difference, std::abs(a.getSample(channel, i) - b.getSample(channel, i)));
+            }
+        }
+
+        return difference;
+    }
+
+    var MachineDescription()
+    {
+        DynamicObject::Ptr machine = new DynamicObject();
+
+        machine->setProperty("cpu", SystemStats::getCpuModel());
+        machine->setProperty("cores", SystemStats::getNumPhysicalCpus());
+        machine->setProperty("os", SystemStats::getOperatingSystemName());
+        machine->setProperty("juce", SystemStats::getJUCEVersion());
+        machine->setProperty("simdLanes", (int)SIMDRegister <float>::size());
+        machine->setProperty("date", Time::getCurrentTime().toISO8601(true));
+
+        return var(machine.get());
+    }
+
+    //------------------------------------------------------------------
+    // Processor under test.
+
+    struct Configuration
+    {
+        const char* name;
+        vector <NamesOfParameters> enabledSwitches;
+    };
+
+    const vector <Configuration> configurations =
+    {
+        { "all bands", {} },
+        { "solo mid", { bandParameter(1, BandParameter::solo) } },
+        { "mute low and high", { bandParameter(0, BandParameter::mute), bandParameter(2, BandParameter::mute) } },
+        { "bypass all", { bandParameter(0, BandParameter::bypassed), bandParameter(1, BandParameter::bypassed),
+                          bandParameter(2, BandParameter::bypassed) } },
+    };
+
+    void SetParameter(EclistarVSTAudioProcessor& processor, NamesOfParameters name, float value)
+    {
+        auto* parameter = processor.apvts.getParameter(GetParameters().at(name));
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    unique_ptr <EclistarVSTAudioProcessor> MakeProcessor(double sampleRate, int blockSize, int numChannels,
+                                                         const Configuration& configuration,
+                                                         int numBands = (int)defaultNumBands,
+                                                         AudioProcessor::ProcessingPrecision precision
+                                                             = AudioProcessor::singlePrecision)
+    {
+        auto processor = make_unique <EclistarVSTAudioProcessor>();
+        auto channelSet = AudioChannelSet::canonicalChannelSet(numChannels);
+
+        AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.inputBuses.add(AudioChannelSet::disabled());
+        layout.outputBuses.add(channelSet);
+
+        processor->setBusesLayout(layout);
+        processor->setNonRealtime(true);
+
+        // Thresholds low enough that the gain computers work on the test signal.
+
+        for (size_t band = 0; band < maxNumBands; ++band)
+        {
+            SetParameter(*processor, bandParameter(band, BandParameter::threshold), -20.0f);
+        }
+
+        SetParameter(*processor, numberOfBands, (float)numBands);
+
+        for (auto name : configuration.enabledSwitches)
+        {
+            SetParameter(*processor, name, 1.0f);
+        }
+
+        processor->setProcessingPrecision(precision);
+        processor->prepareToPlay(sampleRate, blockSize);
+
+        return processor;
+    }
+
+    // Runs the whole signal through the processor, block by block.
+    // Returns the ticks spent in processBlock; the output is collected if asked.
+
+    template <typename SampleType>
+    int64 RunProcessor(EclistarVSTAudioProcessor& processor, const AudioBuffer <SampleType>& signal, int blockSize,
+                       AudioBuffer <SampleType>* output = nullptr)
+    {
+        AudioBuffer <SampleType> block(signal.getNumChannels(), blockSize);
+        MidiBuffer midiMessages;
+
+        int64 ticks = 0;
+
+        for (int start = 0; start < signal.getNumSamples(); start += blockSize)
+        {
+            auto numSamples = jmin(blockSize, signal.getNumSamples() - start);
+
+            block.setSize(signal.getNumChannels(), numSamples, false, false, true);
+
+            for (int channel = 0; channel < signal.getNumChannels(); ++channel)
+            {
+                block.copyFrom(channel, 0, signal, channel, start, numSamples);
+            }
+
+            auto startTicks = Time::getHighResolutionTicks();
+            processor.processBlock(block, midiMessages);
+            ticks += Time::getHighResolutionTicks() - startTicks;
+
+            if (output != nullptr)
+            {
+                for (int channel = 0; channel < signal.getNumChannels(); ++channel)
+                {
+                    output->copyFrom(channel, start, block, channel, 0, numSamples);
+                }
+            }
+        }
+
+        return ticks;
+    }
+
+    //------------------------------------------------------------------
+    // processBlock matrix with the time of every stage.
+
+    var BenchmarkProcessBlock(const BenchmarkOptions& options)
+    {
+        auto sampleRates = options.quick ? vector <double>{ 48000.0 }
+                                         : vector <double>{ 44100.0, 48000.0, 96000.0, 192000.0 };
+        auto blockSizes = options.quick ? vector <int>{ 64, 1024 }
+                                        : vector <int>{ 16, 64, 256, 1024, 4096 };
+
+        const char* stageNames[] = { "inputGain", "split", "resampling", "lookahead", "compressors", "sum", "outputGain" };
+        const char* bandNames[] = { "lowCompressor", "midCompressor", "highCompressor" };
+
+        Array <var> results;
+
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto blockSize : blockSizes)
+            {
+                for (auto numChannels : { 1, 2 })
+                {
+                    auto signal = MakeSignal(numChannels, (int)(sampleRate * options.seconds));
+
+                    for (const auto& configuration : configurations)
+                    {
+                        DynamicObject::Ptr result = new DynamicObject();
+                        DynamicObject::Ptr stages = new DynamicObject();
+
+                        result->setProperty("sampleRate", sampleRate);
+                        result->setProperty("blockSize", blockSize);
+                        result->setProperty("channels", numChannels);
+                        result->setProperty("configuration", configuration.name);
+
+                        // SIMD compressors, then the scalar path for the time of every band.
+
+                        for (auto scalar : { false, true })
+                        {
+                            auto processor = MakeProcessor(sampleRate, blockSize, numChannels, configuration);
+                            processor->setScalarCompression(scalar);
+
+                            RunProcessor(*processor, signal, blockSize);
+                            processor->resetStageTicks();
+
+                            auto ticks = RunProcessor(*processor, signal, blockSize);
+                            const auto& stageTicks = processor->getStageTicks();
+
+                            if (!scalar)
+                                result->setProperty("total", NanosecondsPerSample(ticks, signal.getNumSamples()));
+
+                            if (scalar)
+                            {
+                                for (size_t band = 0; band < defaultNumBands; ++band)
+                                {
+                                    stages->setProperty(bandNames[band],
+                                                        NanosecondsPerSample(processor->getBandTicks()[band],
+                                                                             signal.getNumSamples()));
+                                }
+
+                                continue;
+                            }
+
+                            for (int stage = 0; stage < EclistarVSTAudioProcessor::numStages; ++stage)
+                            {
+                                stages->setProperty(stageNames[stage],
+                                                    NanosecondsPerSample(stageTicks[(size_t)stage],
+                                                                         signal.getNumSamples()));
+                            }
+                        }
+
+                        result->setProperty("stages", var(stages.get()));
+                        results.add(var(result.get()));
+                    }
+                }
+            }
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Fused engine against the per-stage one.
+
+    var BenchmarkFused(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> results;
+
+        for (auto blockSize : { 32, 64, 256, 1024 })
+        {
+            AudioBuffer <float> perStageOutput(signal.getNumChannels(), signal.getNumSamples());
+            AudioBuffer <float> fusedOutput(signal.getNumChannels(), signal.getNumSamples());
+
+            auto perStage = MakeProcessor(sampleRate, blockSize, 2, configurations[0]);
+            auto fused = MakeProcessor(sampleRate, blockSize, 2, configurations[0]);
+
+            fused->setFusedProcessing(true);
+
+            auto perStageTicks = RunProcessor(*perStage, signal, blockSize, &perStageOutput);
+            auto fusedTicks = RunProcessor(*fused, signal, blockSize, &fusedOutput);
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("blockSize", blockSize);
+            result->setProperty("perStage", NanosecondsPerSample(perStageTicks, signal.getNumSamples()));
+            result->setProperty("fused", NanosecondsPerSample(fusedTicks, signal.getNumSamples()));
+            result->setProperty("bitIdentical", MaxDifference(perStageOutput, fusedOutput) == 0.0f);
+
+            results.add(var(result.get()));
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Idle sleep: the same processor on noise and, once its tail has passed, on silence.
+
+    var BenchmarkSilence(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        AudioBuffer <float> silence(signal.getNumChannels(), signal.getNumSamples());
+        silence.clear();
+
+        Array <var> results;
+
+        for (auto blockSize : { 64, 512 })
+        {
+            auto processor = MakeProcessor(sampleRate, blockSize, 2, configurations[0]);
+
+            auto activeTicks = RunProcessor(*processor, signal, blockSize);
+
+            RunProcessor(*processor, silence, blockSize);
+            auto idleTicks = RunProcessor(*processor, silence, blockSize);
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("blockSize", blockSize);
+            result->setProperty("tailSeconds", processor->getTailLengthSeconds());
+            result->setProperty("active", NanosecondsPerSample(activeTicks, signal.getNumSamples()));
+            result->setProperty("idle", NanosecondsPerSample(idleTicks, silence.getNumSamples()));
+            result->setProperty("sleeping", processor->isSleeping());
+
+            results.add(var(result.get()));
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // True passthrough: with every band bypassed at 0 dB (and no latency) the input is passed
+    // untouched once the crossfade is over, so the second run must give the signal itself.
+
+    var BenchmarkPassthrough(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> results;
+
+        for (auto blockSize : { 64, 512 })
+        {
+            AudioBuffer <float> output(signal.getNumChannels(), signal.getNumSamples());
+
+            auto processing = MakeProcessor(sampleRate, blockSize, 2, configurations[0]);
+            auto bypassed = MakeProcessor(sampleRate, blockSize, 2, configurations[3]);
+
+            auto processingTicks = RunProcessor(*processing, signal, blockSize);
+
+            RunProcessor(*bypassed, signal, blockSize);
+            auto passthroughTicks = RunProcessor(*bypassed, signal, blockSize, &output);
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("blockSize", blockSize);
+            result->setProperty("latencySamples", bypassed->getLatencySamples());
+            result->setProperty("processing", NanosecondsPerSample(processingTicks, signal.getNumSamples()));
+            result->setProperty("passthrough", NanosecondsPerSample(passthroughTicks, signal.getNumSamples()));
+            result->setProperty("isPassthrough", MaxDifference(signal, output) == 0.0f);
+
+            results.add(var(result.get()));
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Cost of the number of bands (2 to 8), with the stages that depend on it.
+
+    var BenchmarkBands(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        const auto blockSize = 256;
+
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> results;
+
+        for (auto numBands = (int)minNumBands; numBands <= (int)maxNumBands; ++numBands)
+        {
+            auto processor = MakeProcessor(sampleRate, blockSize, 2, configurations[0], numBands);
+
+            RunProcessor(*processor, signal, blockSize);
+            processor->resetStageTicks();
+
+            auto ticks = RunProcessor(*processor, signal, blockSize);
+            const auto& stageTicks = processor->getStageTicks();
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("bands", numBands);
+            result->setProperty("total", NanosecondsPerSample(ticks, signal.getNumSamples()));
+            result->setProperty("split", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::splitStage],
+                                                              signal.getNumSamples()));
+            result->setProperty("compressors", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::compressorsStage],
+                                                                    signal.getNumSamples()));
+            result->setProperty("sum", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::sumStage],
+                                                            signal.getNumSamples()));
+
+            results.add(var(result.get()));
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Oversampling of the compressors: every factor with every quality.
+
+    var BenchmarkOversampling(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        const auto blockSize = 256;
+
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> results;
+
+        for (size_t factorIndex = 0; factorIndex < oversamplingFactors.size(); ++factorIndex)
+        {
+            for (size_t quality = 0; quality < oversamplingQualities.size(); ++quality)
+            {
+                // Without oversampling the quality does not matter.
+
+                if (factorIndex == 0 && quality > 0)
+                    break;
+
+                auto processor = MakeProcessor(sampleRate, blockSize, 2, configurations[0]);
+
+                SetParameter(*processor, oversampling, (float)factorIndex);
+                SetParameter(*processor, oversamplingQuality, (float)quality);
+
+                // The latency of the new topology is reported when the processor is prepared.
+
+                processor->prepareToPlay(sampleRate, blockSize);
+
+                RunProcessor(*processor, signal, blockSize);
+                processor->resetStageTicks();
+
+                auto ticks = RunProcessor(*processor, signal, blockSize);
+                const auto& stageTicks = processor->getStageTicks();
+
+                DynamicObject::Ptr result = new DynamicObject();
+
+                result->setProperty("factor", (int)oversamplingFactors[factorIndex]);
+                result->setProperty("quality", oversamplingQualities[quality]);
+                result->setProperty("latencySamples", processor->getLatencySamples());
+                result->setProperty("total", NanosecondsPerSample(ticks, signal.getNumSamples()));
+                result->setProperty("resampling", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::resamplingStage],
+                                                                       signal.getNumSamples()));
+                result->setProperty("compressors", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::compressorsStage],
+                                                                        signal.getNumSamples()));
+
+                results.add(var(result.get()));
+            }
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Lookahead of the compressors: the sliding maximum costs the same for every window, and
+    // the latency is the same for all of them (none without lookahead).
+
+    var BenchmarkLookahead(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        const auto blockSize = 256;
+
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> results;
+
+        for (auto lookaheadMs : { 0.0f, 1.0f, 5.0f, 20.0f })
+        {
+            auto processor = MakeProcessor(sampleRate, blockSize, 2, configurations[0]);
+
+            for (size_t band = 0; band < maxNumBands; ++band)
+            {
+                SetParameter(*processor, bandParameter(band, BandParameter::lookahead), lookaheadMs);
+            }
+
+            RunProcessor(*processor, signal, blockSize);
+            processor->resetStageTicks();
+
+            auto ticks = RunProcessor(*processor, signal, blockSize);
+            const auto& stageTicks = processor->getStageTicks();
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("lookaheadMs", lookaheadMs);
+            result->setProperty("latencySamples", processor->getLatencySamples());
+            result->setProperty("total", NanosecondsPerSample(ticks, signal.getNumSamples()));
+            result->setProperty("lookahead", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::lookaheadStage],
+                                                                  signal.getNumSamples()));
+            result->setProperty("compressors", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::compressorsStage],
+                                                                    signal.getNumSamples()));
+
+            results.add(var(result.get()));
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Single against double precision: the same settings with float and double buffers.
+
+    var BenchmarkPrecision(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        AudioBuffer <double> doubleSignal;
+        doubleSignal.makeCopyOf(signal);
+
+        Array <var> results;
+
+        for (auto blockSize : { 64, 256, 1024 })
+        {
+            // Without oversampling and with 4x.
+
+            for (size_t factorIndex : { 0, 2 })
+            {
+                auto floatProcessor = MakeProcessor(sampleRate, blockSize, 2, configurations[0], (int)defaultNumBands,
+                                                    AudioProcessor::singlePrecision);
+                auto doubleProcessor = MakeProcessor(sampleRate, blockSize, 2, configurations[0], (int)defaultNumBands,
+                                                     AudioProcessor::doublePrecision);
+
+                SetParameter(*floatProcessor, oversampling, (float)factorIndex);
+                SetParameter(*doubleProcessor, oversampling, (float)factorIndex);
+
+                AudioBuffer <float> floatOutput(2, signal.getNumSamples());
+                AudioBuffer <double> doubleOutput(2, signal.getNumSamples());
+
+                RunProcessor(*floatProcessor, signal, blockSize);
+                RunProcessor(*doubleProcessor, doubleSignal, blockSize);
+
+                auto floatTicks = RunProcessor(*floatProcessor, signal, blockSize, &floatOutput);
+                auto doubleTicks = RunProcessor(*doubleProcessor, doubleSignal, blockSize, &doubleOutput);
+
+                AudioBuffer <float> convertedOutput;
+                convertedOutput.makeCopyOf(doubleOutput);
+
+                auto floatNs = NanosecondsPerSample(floatTicks, signal.getNumSamples());
+                auto doubleNs = NanosecondsPerSample(doubleTicks, signal.getNumSamples());
+
+                DynamicObject::Ptr result = new DynamicObject();
+
+                result->setProperty("blockSize", blockSize);
+                result->setProperty("oversampling", (int)oversamplingFactors[factorIndex]);
+                result->setProperty("float", floatNs);
+                result->setProperty("double", doubleNs);
+                result->setProperty("doubleToFloat", doubleNs / jmax(1.0e-9, floatNs));
+                result->setProperty("maxDifference", MaxDifference(floatOutput, convertedOutput));
+
+                results.add(var(result.get()));
+            }
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Layouts from mono to 16 channels: the channels are processed in SIMD chunks, so the
+    // cost per channel should fall as their number grows.
+
+    var BenchmarkChannels(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        const auto blockSize = 256;
+
+        Array <var> results;
+
+        for (auto numChannels : { 1, 2, 4, 6, 8, 12, 16 })
+        {
+            auto signal = MakeSignal(numChannels, (int)(sampleRate * options.seconds));
+
+            for (auto isLinked : { false, true })
+            {
+                auto processor = MakeProcessor(sampleRate, blockSize, numChannels, configurations[0]);
+
+                SetParameter(*processor, linkChannels, isLinked ? 1.0f : 0.0f);
+
+                RunProcessor(*processor, signal, blockSize);
+                processor->resetStageTicks();
+
+                auto ticks = RunProcessor(*processor, signal, blockSize);
+                const auto& stageTicks = processor->getStageTicks();
+
+                auto total = NanosecondsPerSample(ticks, signal.getNumSamples());
+                auto compressors = NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::compressorsStage],
+                                                        signal.getNumSamples());
+
+                DynamicObject::Ptr result = new DynamicObject();
+
+                result->setProperty("channels", numChannels);
+                result->setProperty("linked", isLinked);
+                result->setProperty("total", total);
+                result->setProperty("totalPerChannel", total / numChannels);
+                result->setProperty("split", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::splitStage],
+                                                                  signal.getNumSamples()));
+                result->setProperty("compressors", compressors);
+                result->setProperty("compressorsPerChannel", compressors / numChannels);
+
+                results.add(var(result.get()));
+            }
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Parallel processing of the bands: the wall-clock time of a block (its latency on the
+    // audio thread) with 0 to 15 workers, as far as the machine has cores. Blocks below the
+    // threshold of 1024 samples stay on the audio thread. Given in microseconds per block.
+
+    var BenchmarkParallel(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        const auto numBands = (int)maxNumBands;
+
+        struct Layout
+        {
+            int numChannels;
+            int oversamplingIndex;
+        };
+
+        auto maxNumWorkers = jmin((int)VstWorkerPool::maxNumWorkers, SystemStats::getNumCpus() - 1);
+
+        Array <var> results;
+
+        for (auto layout : { Layout{ 2, 2 }, Layout{ 16, 0 } })
+        {
+            auto signal = MakeSignal(layout.numChannels, (int)(sampleRate * options.seconds));
+
+            for (auto blockSize : { 512, 2048, 4096, 8192 })
+            {
+                AudioBuffer <float> singleOutput(signal.getNumChannels(), signal.getNumSamples());
+                AudioBuffer <float> parallelOutput(signal.getNumChannels(), signal.getNumSamples());
+
+                auto numBlocks = (signal.getNumSamples() + blockSize - 1) / blockSize;
+                auto singleTicks = (int64)0;
+
+                for (auto numWorkers : { 0, 1, 3, 7, 15 })
+                {
+                    if (numWorkers > maxNumWorkers)
+                        break;
+
+                    auto processor = MakeProcessor(sampleRate, blockSize, layout.numChannels, configurations[0], numBands);
+
+                    SetParameter(*processor, oversampling, (float)layout.oversamplingIndex);
+
+                    processor->setParallelProcessing(numWorkers > 0, numWorkers, 1024);
+                    processor->prepareToPlay(sampleRate, blockSize);
+
+                    auto* output = numWorkers == 0 ? &singleOutput : &parallelOutput;
+
+                    RunProcessor(*processor, signal, blockSize);
+
+                    auto ticks = RunProcessor(*processor, signal, blockSize, output);
+
+                    if (numWorkers == 0)
+                        singleTicks = ticks;
+
+                    DynamicObject::Ptr result = new DynamicObject();
+
+                    result->setProperty("channels", layout.numChannels);
+                    result->setProperty("bands", numBands);
+                    result->setProperty("oversampling", (int)oversamplingFactors[(size_t)layout.oversamplingIndex]);
+                    result->setProperty("blockSize", blockSize);
+                    result->setProperty("workers", numWorkers);
+                    result->setProperty("microsecondsPerBlock", Time::highResolutionTicksToSeconds(ticks) * 1.0e6 / numBlocks);
+                    result->setProperty("speedup", (double)singleTicks / (double)jmax((int64)1, ticks));
+                    result->setProperty("bitIdentical", numWorkers == 0 || MaxDifference(singleOutput, parallelOutput) == 0.0f);
+
+                    results.add(var(result.get()));
+                }
+            }
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Metering of the bands for the editor: processBlock with and without it. The bus is read
+    // after every run; within a run the full FIFO drops frames, as with a stalled editor.
+
+    var BenchmarkMetering(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> results;
+
+        for (auto numBands : { 3, 8 })
+        {
+            for (auto blockSize : { 64, 256, 1024 })
+            {
+                auto processor = MakeProcessor(sampleRate, blockSize, 2, configurations[0], numBands);
+
+                RunProcessor(*processor, signal, blockSize);
+
+                // Alternating runs, so that both see the same state of the machine.
+
+                int64 ticks[2] = {};
+
+                for (int run = 0; run < 4; ++run)
+                {
+                    auto isMetering = run % 2 == 1;
+
+                    processor->setMeteringEnabled(isMetering);
+                    ticks[isMetering ? 1 : 0] += RunProcessor(*processor, signal, blockSize);
+
+                    VstMeteringBus::Levels levels;
+                    processor->getMeteringBus().read(levels);
+                }
+
+                processor->setMeteringEnabled(false);
+
+                DynamicObject::Ptr result = new DynamicObject();
+
+                result->setProperty("bands", numBands);
+                result->setProperty("blockSize", blockSize);
+                result->setProperty("withoutMeters", NanosecondsPerSample(ticks[0], 2 * signal.getNumSamples()));
+                result->setProperty("withMeters", NanosecondsPerSample(ticks[1], 2 * signal.getNumSamples()));
+                result->setProperty("overheadPercent", 100.0 * (double)(ticks[1] - ticks[0]) / (double)jmax((int64)1, ticks[0]));
+
+                results.add(var(result.get()));
+            }
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Spectrum analyzer of the editor: processBlock with and without it. Its FFTs run on the
+    // shared background thread meanwhile, as with an open editor.
+
+    var BenchmarkAnalyzer(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> results;
+
+        for (auto blockSize : { 64, 256, 1024 })
+        {
+            auto processor = MakeProcessor(sampleRate, blockSize, 2, configurations[0], 3);
+            auto& analyzer = processor->getSpectrumAnalyzer();
+
+            RunProcessor(*processor, signal, blockSize);
+
+            // Alternating runs, so that both see the same state of the machine.
+
+            int64 ticks[2] = {};
+            auto numSpectra = 0;
+
+            for (int run = 0; run < 4; ++run)
+            {
+                auto isAnalyzing = run % 2 == 1;
+
+                analyzer.setEnabled(isAnalyzing);
+                ticks[isAnalyzing ? 1 : 0] += RunProcessor(*processor, signal, blockSize);
+
+                VstSpectrumAnalyzer::Spectrum spectrum;
+                numSpectra += analyzer.read(spectrum) ? 1 : 0;
+            }
+
+            analyzer.setEnabled(false);
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("blockSize", blockSize);
+            result->setProperty("withoutAnalyzer", NanosecondsPerSample(ticks[0], 2 * signal.getNumSamples()));
+            result->setProperty("withAnalyzer", NanosecondsPerSample(ticks[1], 2 * signal.getNumSamples()));
+            result->setProperty("overheadPercent", 100.0 * (double)(ticks[1] - ticks[0]) / (double)jmax((int64)1, ticks[0]));
+            result->setProperty("spectraRead", numSpectra);
+
+            results.add(var(result.get()));
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Tracing of the blocks: processBlock with the tracer off (one branch) and on (two reads
+    // of the clock and one record per block), and the report of the traced runs. Its
+    // aggregation runs on the shared background thread meanwhile.
+
+    var BenchmarkTracing(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> results;
+
+        for (auto blockSize : { 32, 64, 256, 1024 })
+        {
+            auto processor = MakeProcessor(sampleRate, blockSize, 2, configurations[0], 3);
+
+            RunProcessor(*processor, signal, blockSize);
+
+            // Alternating runs, so that both see the same state of the machine.
+
+            int64 ticks[2] = {};
+
+            for (int run = 0; run < 4; ++run)
+            {
+                auto isTracing = run % 2 == 1;
+
+                processor->setTracingEnabled(isTracing);
+                ticks[isTracing ? 1 : 0] += RunProcessor(*processor, signal, blockSize);
+            }
+
+            // The report of the last traced run (a new start restarts the aggregates) is
+            // complete when the tracing stops.
+
+            processor->setTracingEnabled(false);
+
+            VstBlockTracer::Report report;
+            processor->getBlockTracer().read(report);
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("blockSize", blockSize);
+            result->setProperty("withoutTracing", NanosecondsPerSample(ticks[0], 2 * signal.getNumSamples()));
+            result->setProperty("withTracing", NanosecondsPerSample(ticks[1], 2 * signal.getNumSamples()));
+            result->setProperty("overheadPercent", 100.0 * (double)(ticks[1] - ticks[0]) / (double)jmax((int64)1, ticks[0]));
+            result->setProperty("tracedBlocks", (int64)report.numBlocks);
+            result->setProperty("droppedBlocks", (int64)report.numDropped);
+            result->setProperty("p50Microseconds", report.p50Microseconds);
+            result->setProperty("p99Microseconds", report.p99Microseconds);
+            result->setProperty("maxMicroseconds", report.maxMicroseconds);
+            result->setProperty("meanLoad", report.meanLoad);
+
+            results.add(var(result.get()));
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Sidechain: the bus off, on without a keyed band (not split), and on with all bands keyed
+    // by it (split in the lanes after the input). The sidechain is the last two channels of the
+    // signal; the target of the split is less than one more crossover.
+
+    var BenchmarkSidechain(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(4, (int)(sampleRate * options.seconds));
+
+        struct Mode
+        {
+            const char* name;
+            bool isSidechainOn;
+            bool areBandsKeyed;
+        };
+
+        const Mode modes[] = { { "off", false, false }, { "on", true, false }, { "keyed", true, true } };
+
+        Array <var> results;
+
+        for (auto numBands : { 3, 8 })
+        {
+            for (auto blockSize : { 64, 256, 1024 })
+            {
+                for (const auto& mode : modes)
+                {
+                    auto processor = MakeProcessor(sampleRate, blockSize, 2, configurations[0], numBands);
+
+                    AudioProcessor::BusesLayout layout;
+                    layout.inputBuses.add(AudioChannelSet::stereo());
+                    layout.inputBuses.add(mode.isSidechainOn ? AudioChannelSet::stereo() : AudioChannelSet::disabled());
+                    layout.outputBuses.add(AudioChannelSet::stereo());
+
+                    processor->setBusesLayout(layout);
+
+                    for (size_t band = 0; band < (size_t)numBands; ++band)
+                    {
+                        SetParameter(*processor, bandParameter(band, BandParameter::sidechain), mode.areBandsKeyed ? 1.0f : 0.0f);
+                    }
+
+                    processor->prepareToPlay(sampleRate, blockSize);
+
+                    RunProcessor(*processor, signal, blockSize);
+                    processor->resetStageTicks();
+
+                    auto ticks = RunProcessor(*processor, signal, blockSize);
+                    const auto& stageTicks = processor->getStageTicks();
+
+                    DynamicObject::Ptr result = new DynamicObject();
+
+                    result->setProperty("bands", numBands);
+                    result->setProperty("blockSize", blockSize);
+                    result->setProperty("sidechain", mode.name);
+                    result->setProperty("total", NanosecondsPerSample(ticks, signal.getNumSamples()));
+                    result->setProperty("split", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::splitStage],
+                                                                      signal.getNumSamples()));
+                    result->setProperty("keys", NanosecondsPerSample(stageTicks[EclistarVSTAudioProcessor::lookaheadStage],
+                                                                     signal.getNumSamples()));
+
+                    results.add(var(result.get()));
+                }
+            }
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Presets: all instances switch between two presets, as at the scene changes of a session.
+    // The state is loaded as an older ValueTree blob, as a binary preset, and as a preset parsed
+    // once for all instances. Times are microseconds per instance and load.
+
+    var BenchmarkPresets(const BenchmarkOptions& options)
+    {
+        const auto numInstances = options.quick ? 50 : 200;
+        const auto numScenes = options.quick ? 4 : 20;
+
+        vector <unique_ptr <EclistarVSTAudioProcessor>> processors;
+
+        for (auto i = 0; i < numInstances; ++i)
+        {
+            processors.push_back(MakeProcessor(48000.0, 512, 2, configurations[0]));
+        }
+
+        // Two scenes that differ in every band and crossover.
+
+        auto& reference = *processors.front();
+
+        VstPreset presets[2];
+        MemoryBlock valueTreeBlobs[2];
+        MemoryBlock binaryBlobs[2];
+
+        for (auto scene = 0; scene < 2; ++scene)
+        {
+            for (size_t band = 0; band < maxNumBands; ++band)
+            {
+                SetParameter(reference, bandParameter(band, BandParameter::threshold), scene == 0 ? -20.0f : -32.0f);
+                SetParameter(reference, bandParameter(band, BandParameter::ratio), scene == 0 ? 3.0f : 7.0f);
+                SetParameter(reference, bandParameter(band, BandParameter::attack), scene == 0 ? 10.0f : 40.0f);
+                SetParameter(reference, bandParameter(band, BandParameter::release), scene == 0 ? 100.0f : 300.0f);
+            }
+
+            for (size_t crossover = 0; crossover < maxNumCrossovers; ++crossover)
+            {
+                SetParameter(reference, crossoverFreq(crossover), (float)(crossover + 1) * (scene == 0 ? 400.0f : 500.0f));
+            }
+
+            presets[scene] = reference.getPreset();
+            presets[scene].write(binaryBlobs[scene]);
+
+            MemoryOutputStream stream(valueTreeBlobs[scene], false);
+            reference.apvts.copyState().writeToStream(stream);
+        }
+
+        auto loadScenes = [&](auto&& load)
+        {
+            int64 ticks = 0;
+
+            for (auto scene = 0; scene < numScenes; ++scene)
+            {
+                auto startTicks = Time::getHighResolutionTicks();
+
+                for (auto& processor : processors)
+                {
+                    load(*processor, scene % 2);
+                }
+
+                ticks += Time::getHighResolutionTicks() - startTicks;
+            }
+
+            return Time::highResolutionTicksToSeconds(ticks) * 1.0e6 / (double)(numScenes * numInstances);
+        };
+
+        auto valueTree = loadScenes([&](EclistarVSTAudioProcessor& processor, int scene)
+        {
+            processor.setStateInformation(valueTreeBlobs[scene].getData(), (int)valueTreeBlobs[scene].getSize());
+        });
+
+        auto binary = loadScenes([&](EclistarVSTAudioProcessor& processor, int scene)
+        {
+            processor.setStateInformation(binaryBlobs[scene].getData(), (int)binaryBlobs[scene].getSize());
+        });
+
+        auto parsed = loadScenes([&](EclistarVSTAudioProcessor& processor, int scene)
+        {
+            processor.applyPreset(presets[scene]);
+        });
+
+        // Both formats must give the same parameters.
+
+        auto isIdentical = true;
+
+        for (auto scene = 0; scene < 2; ++scene)
+        {
+            reference.setStateInformation(valueTreeBlobs[scene].getData(), (int)valueTreeBlobs[scene].getSize());
+            auto fromValueTree = reference.getPreset();
+
+            reference.setStateInformation(binaryBlobs[1 - scene].getData(), (int)binaryBlobs[1 - scene].getSize());
+            reference.setStateInformation(binaryBlobs[scene].getData(), (int)binaryBlobs[scene].getSize());
+
+            isIdentical = isIdentical && fromValueTree.values == reference.getPreset().values;
+        }
+
+        DynamicObject::Ptr result = new DynamicObject();
+
+        result->setProperty("instances", numInstances);
+        result->setProperty("valueTreeBytes", (int)valueTreeBlobs[0].getSize());
+        result->setProperty("binaryBytes", (int)binaryBlobs[0].getSize());
+        result->setProperty("valueTree", valueTree);
+        result->setProperty("binary", binary);
+        result->setProperty("parsed", parsed);
+        result->setProperty("speedup", valueTree / jmax(1.0e-9, binary));
+        result->setProperty("identical", isIdentical);
+
+        return var(result.get());
+    }
+
+    //------------------------------------------------------------------
+    // VstCrossover against the five-filter chain it replaced.
+
+    struct FiveFilterCrossover
+    {
+        LinkwitzRileyFilter <float> lowPass1, highPass1, lowPass2, highPass2, allPass2;
+
+        void prepare(const ProcessSpec& spec, float lowMidCutoff, float midHighCutoff)
+        {
+            lowPass1.setType(LinkwitzRileyFilterType::lowpass);
+            highPass1.setType(LinkwitzRileyFilterType::highpass);
+            lowPass2.setType(LinkwitzRileyFilterType::lowpass);
+            highPass2.setType(LinkwitzRileyFilterType::highpass);
+            allPass2.setType(LinkwitzRileyFilterType::allpass);
+
+            for (auto* filter : { &lowPass1, &highPass1 })
+            {
+                filter->prepare(spec);
+                filter->setCutoffFrequency(lowMidCutoff);
+            }
+
+            for (auto* filter : { &lowPass2, &highPass2, &allPass2 })
+            {
+                filter->prepare(spec);
+                filter->setCutoffFrequency(midHighCutoff);
+            }
+        }
+
+        void process(const AudioBlock <const float>& input, AudioBlock <float>& low,
+                     AudioBlock <float>& mid, AudioBlock <float>& high)
+        {
+            lowPass1.process(ProcessContextNonReplacing <float>(input, low));
+            allPass2.process(ProcessContextReplacing <float>(low));
+
+            highPass1.process(ProcessContextNonReplacing <float>(input, mid));
+            highPass2.process(ProcessContextNonReplacing <float>(AudioBlock <const float>(mid), high));
+            lowPass2.process(ProcessContextReplacing <float>(mid));
+        }
+    };
+
+    var BenchmarkCrossover(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> results;
+
+        for (auto blockSize : { 64, 256, 1024 })
+        {
+            ProcessSpec spec{ sampleRate, (uint32)blockSize, 2 };
+
+            const float cutoffs[] = { 400.0f, 2000.0f };
+
+            VstCrossover <float> crossover;
+            crossover.prepare(spec);
+            crossover.setNumBands(3);
+            crossover.setCutoffFrequencies(cutoffs);
+
+            FiveFilterCrossover reference;
+            reference.prepare(spec, cutoffs[0], cutoffs[1]);
+
+            // VstCrossover writes all bands into one buffer (band b in the channels 2b, 2b + 1).
+
+            AudioBuffer <float> bands(6, signal.getNumSamples());
+            array <AudioBuffer <float>, 3> referenceBands;
+
+            for (size_t band = 0; band < 3; ++band)
+            {
+                referenceBands[band].setSize(2, signal.getNumSamples());
+            }
+
+            int64 ticks = 0, referenceTicks = 0;
+
+            for (int start = 0; start < signal.getNumSamples(); start += blockSize)
+            {
+                auto numSamples = (size_t)jmin(blockSize, signal.getNumSamples() - start);
+                auto input = AudioBlock <const float>(signal).getSubBlock((size_t)start, numSamples);
+
+                array <AudioBlock <float>, 3> referenceBlocks;
+
+                for (size_t band = 0; band < 3; ++band)
+                {
+                    referenceBlocks[band] = AudioBlock <float>(referenceBands[band]).getSubBlock((size_t)start, numSamples);
+                }
+
+                auto block = AudioBlock <float>(bands).getSubBlock((size_t)start, numSamples);
+
+                auto startTicks = Time::getHighResolutionTicks();
+                crossover.process(input, block);
+                ticks += Time::getHighResolutionTicks() - startTicks;
+
+                startTicks = Time::getHighResolutionTicks();
+                reference.process(input, referenceBlocks[0], referenceBlocks[1], referenceBlocks[2]);
+                referenceTicks += Time::getHighResolutionTicks() - startTicks;
+            }
+
+            auto difference = 0.0f;
+
+            for (int band = 0; band < 3; ++band)
+            {
+                AudioBuffer <float> bandChannels(bands.getArrayOfWritePointers() + 2 * band, 2, bands.getNumSamples());
+                difference = jmax(difference, MaxDifference(bandChannels, referenceBands[(size_t)band]));
+            }
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("blockSize", blockSize);
+            result->setProperty("vstCrossover", NanosecondsPerSample(ticks, signal.getNumSamples()));
+            result->setProperty("fiveFilters", NanosecondsPerSample(referenceTicks, signal.getNumSamples()));
+            result->setProperty("maxDifference", difference);
+
+            results.add(var(result.get()));
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // Automated crossover sweeps. The prewarped gains of the shared tables against std::tan
+    // (cost per crossover update and largest relative error on fractional cutoffs), VstCrossover
+    // with all its crossovers moving every 32 samples against static ones, processBlock with the
+    // crossover parameters swept every block, and the tables of 100 crossovers at one rate.
+
+    var BenchmarkCrossoverSweep(const BenchmarkOptions& options)
+    {
+        DynamicObject::Ptr results = new DynamicObject();
+
+        // Exponential sweep over 20 Hz ... 20 kHz with fractional cutoffs.
+
+        auto SweepCutoff = [](int step, int numSteps)
+        {
+            return (float)(20.0 * std::pow(1000.0, (double)(step % numSteps) / (double)numSteps));
+        };
+
+        Array <var> gains;
+
+        for (auto sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+        {
+            SharedResourcePointer <VstCrossoverTables> tables;
+            const auto& table = tables->getTable(sampleRate);
+
+            const auto numSteps = 100000;
+            auto error = 0.0;
+
+            for (int step = 0; step < numSteps; ++step)
+            {
+                auto cutoff = SweepCutoff(step, numSteps);
+                auto exact = VstCrossoverTables::exactGainOf(sampleRate, cutoff);
+
+                error = jmax(error, std::abs(table.gainOf(cutoff) - exact) / exact);
+            }
+
+            auto checksum = 0.0;
+
+            auto startTicks = Time::getHighResolutionTicks();
+
+            for (int step = 0; step < numSteps; ++step)
+            {
+                checksum += VstCrossoverTables::exactGainOf(sampleRate, SweepCutoff(step, numSteps));
+            }
+
+            auto exactTicks = Time::getHighResolutionTicks() - startTicks;
+
+            startTicks = Time::getHighResolutionTicks();
+
+            for (int step = 0; step < numSteps; ++step)
+            {
+                checksum += table.gainOf(SweepCutoff(step, numSteps));
+            }
+
+            auto tableTicks = Time::getHighResolutionTicks() - startTicks;
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("sampleRate", sampleRate);
+            result->setProperty("tan", NanosecondsPerSample(exactTicks, numSteps));
+            result->setProperty("table", NanosecondsPerSample(tableTicks, numSteps));
+            result->setProperty("maxRelativeError", error);
+            result->setProperty("tableKilobytes", (double)table.getSizeInBytes() / 1024.0);
+            result->setProperty("checksum", checksum);
+
+            gains.add(var(result.get()));
+        }
+
+        results->setProperty("gains", gains);
+
+        // VstCrossover with 8 bands: static cutoffs, and all seven swept every 32 samples.
+
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        Array <var> crossovers;
+
+        for (auto isSweeping : { false, true })
+        {
+            const size_t numBands = 8;
+            const int partSize = 32;
+
+            VstCrossover <float> crossover;
+            crossover.prepare({ sampleRate, (uint32)partSize, 2 });
+            crossover.setNumBands(numBands);
+
+            AudioBuffer <float> bands((int)(2 * numBands), partSize);
+            array <float, VstCrossover <float>::maxNumCrossovers> cutoffs{};
+
+            int64 ticks = 0;
+            auto numParts = signal.getNumSamples() / partSize;
+
+            for (int part = 0; part < numParts; ++part)
+            {
+                auto input = AudioBlock <const float>(signal).getSubBlock((size_t)(part * partSize), (size_t)partSize);
+                auto block = AudioBlock <float>(bands);
+
+                auto startTicks = Time::getHighResolutionTicks();
+
+                if (isSweeping || part == 0)
+                {
+                    for (size_t i = 0; i + 1 < numBands; ++i)
+                    {
+                        cutoffs[i] = SweepCutoff(part + (int)i * 1000, 8000) * (float)(i + 1) / (float)numBands;
+                    }
+
+                    sort(cutoffs.begin(), cutoffs.begin() + (ptrdiff_t)(numBands - 1));
+                    crossover.setCutoffFrequencies(cutoffs.data());
+                }
+
+                crossover.process(input, block);
+
+                ticks += Time::getHighResolutionTicks() - startTicks;
+            }
+
+            DynamicObject::Ptr result = new DynamicObject();
+
+            result->setProperty("bands", (int)numBands);
+            result->setProperty("sweeping", isSweeping);
+            result->setProperty("crossover", NanosecondsPerSample(ticks, (int64)numParts * partSize));
+
+            crossovers.add(var(result.get()));
+        }
+
+        results->setProperty("crossover", crossovers);
+
+        // processBlock with the crossover parameters automated: a new value every block, which
+        // the processor smoothes and applies every control period.
+
+        Array <var> automation;
+
+        for (auto numBands : { 3, 8 })
+        {
+            for (auto blockSize : { 64, 256 })
+            {
+                int64 ticks[2] = {};
+
+                for (auto isSweeping : { false, true })
+                {
+                    auto processor = MakeProcessor(sampleRate, blockSize, 2, configurations[0], numBands);
+
+                    AudioBuffer <float> block(2, blockSize);
+                    MidiBuffer midiMessages;
+                    auto numBlocks = signal.getNumSamples() / blockSize;
+
+                    for (int index = 0; index < numBlocks; ++index)
+                    {
+                        if (isSweeping)
+                        {
+                            for (size_t crossover = 0; crossover + 1 < (size_t)numBands; ++crossover)
+                            {
+                                SetParameter(*processor, crossoverFreq(crossover),
+                                             std::round(SweepCutoff(index + (int)crossover * 100, 2000)));
+                            }
+                        }
+
+                        for (int channel = 0; channel < 2; ++channel)
+                        {
+                            block.copyFrom(channel, 0, signal, channel, index * blockSize, blockSize);
+                        }
+
+                        auto startTicks = Time::getHighResolutionTicks();
+                        processor->processBlock(block, midiMessages);
+                        ticks[isSweeping ? 1 : 0] += Time::getHighResolutionTicks() - startTicks;
+                    }
+                }
+
+                auto numSamples = (int64)(signal.getNumSamples() / blockSize) * blockSize;
+
+                DynamicObject::Ptr result = new DynamicObject();
+
+                result->setProperty("bands", numBands);
+                result->setProperty("blockSize", blockSize);
+                result->setProperty("static", NanosecondsPerSample(ticks[0], numSamples));
+                result->setProperty("automated", NanosecondsPerSample(ticks[1], numSamples));
+                result->setProperty("overheadPercent", 100.0 * (double)(ticks[1] - ticks[0]) / (double)jmax((int64)1, ticks[0]));
+
+                automation.add(var(result.get()));
+            }
+        }
+
+        results->setProperty("automation", automation);
+
+        // 100 instances at one sample rate share one table.
+
+        vector <unique_ptr <VstCrossover <float>>> instances;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            instances.push_back(make_unique <VstCrossover <float>>());
+            instances.back()->prepare({ sampleRate, 512, 2 });
+        }
+
+        SharedResourcePointer <VstCrossoverTables> tables;
+
+        results->setProperty("instances", (int)instances.size());
+        results->setProperty("sharedTables", (int)tables->getNumTables());
+
+        return var(results.get());
+    }
+
+    //------------------------------------------------------------------
+    // Linear-phase split against the Linkwitz-Riley one (3 and 8 bands, blocks of 64 and 512
+    // samples): the average cost, the longest block (a partition is computed at once) and the
+    // largest error of the sum of the linear-phase bands against the delayed input.
+
+    var BenchmarkLinearPhase(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+
+        const float threeBandCutoffs[] = { 400.0f, 2000.0f };
+        const float eightBandCutoffs[] = { 100.0f, 250.0f, 600.0f, 1500.0f, 3500.0f, 7000.0f, 12000.0f };
+
+        Array <var> results;
+
+        for (auto numBands : { 3, 8 })
+        {
+            for (auto blockSize : { 64, 512 })
+            {
+                ProcessSpec spec{ sampleRate, (uint32)blockSize, 2 };
+                const auto* cutoffs = numBands == 3 ? threeBandCutoffs : eightBandCutoffs;
+
+                VstCrossover <float> crossover;
+                crossover.prepare(spec);
+                crossover.setNumBands((size_t)numBands);
+                crossover.setCutoffFrequencies(cutoffs);
+
+                VstLinearPhaseCrossover <float> linearCrossover;
+                linearCrossover.prepare(spec);
+                linearCrossover.setEnabled(true);
+                linearCrossover.setNumBands((size_t)numBands);
+                linearCrossover.setCutoffFrequencies(cutoffs);
+                linearCrossover.buildKernels();
+
+                AudioBuffer <float> bands(2 * numBands, blockSize);
+                AudioBuffer <float> sum(2, signal.getNumSamples());
+                sum.clear();
+
+                int64 ticks = 0, linearTicks = 0, longestTicks = 0, longestLinearTicks = 0;
+
+                for (int start = 0; start < signal.getNumSamples(); start += blockSize)
+                {
+                    auto numSamples = (size_t)jmin(blockSize, signal.getNumSamples() - start);
+                    auto input = AudioBlock <const float>(signal).getSubBlock((size_t)start, numSamples);
+                    auto block = AudioBlock <float>(bands).getSubBlock(0, numSamples);
+
+                    auto startTicks = Time::getHighResolutionTicks();
+                    crossover.process(input, block);
+                    auto blockTicks = Time::getHighResolutionTicks() - startTicks;
+
+                    ticks += blockTicks;
+                    longestTicks = jmax(longestTicks, blockTicks);
+
+                    startTicks = Time::getHighResolutionTicks();
+                    linearCrossover.process(input, block);
+                    blockTicks = Time::getHighResolutionTicks() - startTicks;
+
+                    linearTicks += blockTicks;
+                    longestLinearTicks = jmax(longestLinearTicks, blockTicks);
+
+                    for (int band = 0; band < numBands; ++band)
+                    {
+                        for (int channel = 0; channel < 2; ++channel)
+                        {
+                            sum.addFrom(channel, start, bands, 2 * band + channel, 0, (int)numSamples);
+                        }
+                    }
+                }
+
+                // The sum of the bands is the input delayed by the latency.
+
+                auto latency = linearCrossover.getLatencySamples();
+                auto error = 0.0f;
+
+                for (int channel = 0; channel < 2; ++channel)
+                {
+                    for (int i = latency; i < signal.getNumSamples(); ++i)
+                    {
+                        error = jmax(error, std::abs(sum.getSample(channel, i) - signal.getSample(channel, i - latency)));
+                    }
+                }
+
+                DynamicObject::Ptr result = new DynamicObject();
+
+                result->setProperty("bands", numBands);
+                result->setProperty("blockSize", blockSize);
+                result->setProperty("latencySamples", latency);
+                result->setProperty("iir", NanosecondsPerSample(ticks, signal.getNumSamples()));
+                result->setProperty("linearPhase", NanosecondsPerSample(linearTicks, signal.getNumSamples()));
+                result->setProperty("longestBlockIir", Time::highResolutionTicksToSeconds(longestTicks) * 1.0e6);
+                result->setProperty("longestBlockLinearPhase", Time::highResolutionTicksToSeconds(longestLinearTicks) * 1.0e6);
+                result->setProperty("sumErrorDecibels", Decibels::gainToDecibels(error, -200.0f));
+
+                results.add(var(result.get()));
+            }
+        }
+
+        return results;
+    }
+
+    //------------------------------------------------------------------
+    // SIMD band compressor against its scalar path and three juce Compressor objects.
+
+    var BenchmarkCompressor(const BenchmarkOptions& options)
+    {
+        const auto sampleRate = 48000.0;
+        const auto blockSize = 256;
+        const float ratios[] = { 3.0f, 4.0f, 10.0f };
+
+        auto signal = MakeSignal(2, (int)(sampleRate * options.seconds));
+        ProcessSpec spec{ sampleRate, (uint32)blockSize, 2 };
+
+        MultiBandCompressorSIMD <float> simd, scalar;
+        array <Compressor <float>, 3> reference;
+
+        for (auto* compressor : { &simd, &scalar })
+        {
+            compressor->prepare(spec);
+            compressor->setNumBands(3);
+
+            for (size_t band = 0; band < 3; ++band)
+            {
+                compressor->setBandParameters(band, 5.0f, 250.0f, -20.0f, ratios[band], false);
+            }
+        }
+
+        for (size_t band = 0; band < 3; ++band)
+        {
+            reference[band].prepare(spec);
+            reference[band].setAttack(5.0f);
+            reference[band].setRelease(250.0f);
+            reference[band].setThreshold(-20.0f);
+            reference[band].setRatio(ratios[band]);
+        }
+
+        // The same signal is given to all three bands of every engine
+        // (band b in the channels 2b, 2b + 1 of one buffer).
+
+        AudioBuffer <float> simdBands(6, signal.getNumSamples()), scalarBands(6, signal.getNumSamples());
+        array <AudioBuffer <float>, 3> referenceBands;
+
+        for (int band = 0; band < 3; ++band)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                simdBands.copyFrom(2 * band + channel, 0, signal, channel, 0, signal.getNumSamples());
+                scalarBands.copyFrom(2 * band + channel, 0, signal, channel, 0, signal.getNumSamples());
+            }
+
+            referenceBands[(size_t)band].makeCopyOf(signal);
+        }
+
+        int64 simdTicks = 0, scalarTicks = 0, referenceTicks = 0;
+
+        for (int start = 0; start < signal.getNumSamples(); start += blockSize)
+        {
+            auto numSamples = (size_t)jmin(blockSize, signal.getNumSamples() - start);
+
+            auto block = AudioBlock <float>(simdBands).getSubBlock((size_t)start, numSamples);
+            auto startTicks = Time::getHighResolutionTicks();
+            simd.process(block);
+            simdTicks += Time::getHighResolutionTicks() - startTicks;
+
+            block = AudioBlock <float>(scalarBands).getSubBlock((size_t)start, numSamples);
+            startTicks = Time::getHighResolutionTicks();
+            scalar.processScalar(block);
+            scalarTicks += Time::getHighResolutionTicks() - startTicks;
+
+            startTicks = Time::getHighResolutionTicks();
+
+            for (size_t band = 0; band < 3; ++band)
+            {
+                auto referenceBlock = AudioBlock <float>(referenceBands[band]).getSubBlock((size_t)start, numSamples);
+                reference[band].process(ProcessContextReplacing <float>(referenceBlock));
+            }
+
+            referenceTicks += Time::getHighResolutionTicks() - startTicks;
+        }
+
+        auto scalarDifference = 0.0f, referenceDifference = 0.0f;
+
+        scalarDifference = MaxDifference(simdBands, scalarBands);
+
+        for (int band = 0; band < 3; ++band)
+        {
+            AudioBuffer <float> bandChannels(simdBands.getArrayOfWritePointers() + 2 * band, 2, simdBands.getNumSamples());
+            referenceDifference = jmax(referenceDifference, MaxDifference(bandChannels, referenceBands[(size_t)band]));
+        }
+
+        DynamicObject::Ptr result = new DynamicObject();
+
+        result->setProperty("blockSize", blockSize);
+        result->setProperty("simd", NanosecondsPerSample(simdTicks, signal.getNumSamples()));
+        result->setProperty("scalar", NanosecondsPerSample(scalarTicks, signal.getNumSamples()));
+        result->setProperty("juceCompressors", NanosecondsPerSample(referenceTicks, signal.getNumSamples()));
+        result->setProperty("maxDifferenceScalar", scalarDifference);
+        result->setProperty("maxDifferenceJuce", referenceDifference);
+
+        return var(result.get());
+    }
+
+    //------------------------------------------------------------------
+    // Gain computer of MultiBandCompressorSIMD (VstFastMath log2 and exp2) against the exact
+    // curves in double: the power law of Compressor with a hard knee, the quadratic soft knee
+    // otherwise. Every ratio choice, every threshold of the parameter (-60 to 12 dB) and
+    // envelopes from -100 to 24 dB; the error must stay below maxGainErrorDecibels, the bound
+    // documented by the compressor.
+
+    template <typename SampleType>
+
+    double GainComputerError(float kneeDecibels)
+    {
+        MultiBandCompressorSIMD <SampleType> compressor;
+        compressor.prepare(ProcessSpec{ 48000.0, 512, 1 });
+        compressor.setNumBands(1);
+        compressor.setKnee(kneeDecibels);
+
+        auto error = 0.0;
+
+        for (auto ratio : ratioValues)
+        {
+            for (auto threshold = -60; threshold <= 12; ++threshold)
+            {
+                compressor.setBandParameters(0, 5.0f, 100.0f, (float)threshold, ratio, false);
+
+                auto slope = 1.0 / (double)ratio - 1.0;
+
+                for (auto level = -100.0; level <= 24.0; level += 0.05)
+                {
+                    auto envelope = (SampleType)Decibels::decibelsToGain(level, -300.0);
+                    auto overshoot = Decibels::gainToDecibels((double)envelope, -300.0) - threshold;
+                    auto halfKnee = kneeDecibels / 2.0;
+
+                    auto expected = 0.0;
+
+                    if (kneeDecibels == 0.0f)
+                    {
+                        expected = overshoot < 0.0 ? 0.0
+                            : Decibels::gainToDecibels(std::pow((double)envelope / Decibels::decibelsToGain((double)threshold), slope), -300.0);
+                    }
+                    else if (overshoot > halfKnee)
+                    {
+                        expected = slope * overshoot;
+                    }
+                    else if (overshoot > -halfKnee)
+                    {
+                        expected = slope * square(overshoot + halfKnee) / (2.0 * kneeDecibels);
+                    }
+
+                    auto gain = Decibels::gainToDecibels((double)compressor.getGain(0, envelope), -300.0);
+
+                    error = jmax(error, std::abs(gain - expected));
+                }
+            }
+        }
+
+        return error;
+    }
+
+    var BenchmarkGainComputer(const BenchmarkOptions& options)
+    {
+        const auto errorBoundDecibels = MultiBandCompressorSIMD <float>::maxGainErrorDecibels;
+        const float knees[] = { 0.0f, 6.0f, 12.0f, 24.0f };
+
+        DynamicObject::Ptr result = new DynamicObject();
+
+        // Accuracy.
+
+        Array <var> accuracy;
+        auto isWithinBound = true;
+
+        for (auto knee : knees)
+        {
+            auto floatError = GainComputerError <float>(knee);
+            auto doubleError = GainComputerError <double>(knee);
+
+            DynamicObject::Ptr entry = new DynamicObject();
+
+            entry->setProperty("kneeDecibels", knee);
+            entry->setProperty("maxErrorDecibelsFloat", floatError);
+            entry->setProperty("maxErrorDecibelsDouble", doubleError);
+
+            accuracy.add(var(entry.get()));
+
+            isWithinBound = isWithinBound && floatError < errorBoundDecibels && doubleError < errorBoundDecibels;
+        }
+
+        result->setProperty("errorBoundDecibels", errorBoundDecibels);
+        result->setProperty("withinBound", isWithinBound);
+        result->setProperty("accuracy", accuracy);
+
+        // The gain law alone, for 8 stereo bands above their thresholds: std::pow per lane
+        // (the previous gain computer) against the fast log-domain one.
+
+        constexpr size_t numLanes = 16;
+        const auto numFrames = (int)(48000.0 * options.seconds);
+
+        auto signal = MakeSignal((int)numLanes, numFrames);
+
+        array <float, numLanes> thresholds{}, thresholdsInverse{}, thresholdsLog2{}, slopes{};
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            auto thresholdDecibels = -60.0f + 2.0f * (float)lane;
+
+            thresholds[lane] = Decibels::decibelsToGain(thresholdDecibels);
+            thresholdsInverse[lane] = 1.0f / thresholds[lane];
+            thresholdsLog2[lane] = VstFastMath::decibelsToLog2(thresholdDecibels);
+            slopes[lane] = 1.0f / ratioValues[lane % ratioValues.size()] - 1.0f;
+        }
+
+        // The checksum of the gains keeps the loops from being optimized away.
+
+        array <float, numLanes> envelopes{}, gains{};
+        auto checksum = 0.0f;
+
+        int64 powTicks = 0, fastTicks = 0;
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                envelopes[lane] = std::abs(signal.getSample((int)lane, i));
+            }
+
+            auto startTicks = Time::getHighResolutionTicks();
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                gains[lane] = envelopes[lane] < thresholds[lane]
+                    ? 1.0f : std::pow(envelopes[lane] * thresholdsInverse[lane], slopes[lane]);
+            }
+
+            powTicks += Time::getHighResolutionTicks() - startTicks;
+            checksum += gains[0];
+
+            startTicks = Time::getHighResolutionTicks();
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                auto overshoot = VstFastMath::positivePart(VstFastMath::log2(envelopes[lane]) - thresholdsLog2[lane]);
+                gains[lane] = VstFastMath::exp2(slopes[lane] * overshoot);
+            }
+
+            fastTicks += Time::getHighResolutionTicks() - startTicks;
+            checksum += gains[0];
+        }
+
+        result->setProperty("powLaw", NanosecondsPerSample(powTicks, numFrames));
+        result->setProperty("fastLaw", NanosecondsPerSample(fastTicks, numFrames));
+
+        // The whole compressor (8 stereo bands, all compressing), with a hard and a soft knee.
+
+        for (auto knee : { 0.0f, 12.0f })
+        {
+            MultiBandCompressorSIMD <float> compressor;
+            compressor.prepare(ProcessSpec{ 48000.0, 256, 2 });
+            compressor.setNumBands(8);
+            compressor.setKnee(knee);
+
+            for (size_t band = 0; band < 8; ++band)
+            {
+                compressor.setBandParameters(band, 5.0f, 100.0f, -60.0f, ratioValues[band + 2], false);
+            }
+
+            AudioBuffer <float> bands(signal);
+            int64 ticks = 0;
+
+            for (int start = 0; start < numFrames; start += 256)
+            {
+                auto block = AudioBlock <float>(bands).getSubBlock((size_t)start, (size_t)jmin(256, numFrames - start));
+
+                auto startTicks = Time::getHighResolutionTicks();
+                compressor.process(block);
+                ticks += Time::getHighResolutionTicks() - startTicks;
+            }
+
+            result->setProperty(knee == 0.0f ? "compressorHardKnee" : "compressorSoftKnee", NanosecondsPerSample(ticks, numFrames));
+        }
+
+        result->setProperty("checksum", checksum);
+
+        return var(result.get());
+    }
+}
+
+//==============================================================================================
+
+int main(int argc, char* argv[])
+{
+    // The message manager is needed by the parameters of the processor (APVTS timer).
+
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    BenchmarkOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        auto argument = String(CharPointer_UTF8(argv[i]));
+        auto hasValue = i + 1 < argc;
+
+        if (argument == "--output" && hasValue)
+            options.output = File::getCurrentWorkingDirectory().getChildFile(String(CharPointer_UTF8(argv[++i])));
+        else if (argument == "--seconds" && hasValue)
+            options.seconds = String(argv[++i]).getDoubleValue();
+        else if (argument == "--quick")
+            options.quick = true;
+        else
+        {
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    if (options.seconds <= 0.0)
+    {
+        std::cerr << usage;
+        return 1;
+    }
+
+    DynamicObject::Ptr results = new DynamicObject();
+
+    results->setProperty("machine", MachineDescription());
+    results->setProperty("processBlock", BenchmarkProcessBlock(options));
+    results->setProperty("fused", BenchmarkFused(options));
+    results->setProperty("silence", BenchmarkSilence(options));
+    results->setProperty("passthrough", BenchmarkPassthrough(options));
+    results->setProperty("bands", BenchmarkBands(options));
+    results->setProperty("oversampling", BenchmarkOversampling(options));
+    results->setProperty("lookahead", BenchmarkLookahead(options));
+    results->setProperty("precision", BenchmarkPrecision(options));
+    results->setProperty("channels", BenchmarkChannels(options));
+    results->setProperty("parallel", BenchmarkParallel(options));
+    results->setProperty("metering", BenchmarkMetering(options));
+    results->setProperty("analyzer", BenchmarkAnalyzer(options));
+    results->setProperty("tracing", BenchmarkTracing(options));
+    results->setProperty("sidechain", BenchmarkSidechain(options));
+    results->setProperty("presets", BenchmarkPresets(options));
+    results->setProperty("crossover", BenchmarkCrossover(options));
+    results->setProperty("crossoverSweep", BenchmarkCrossoverSweep(options));
+    results->setProperty("linearPhase", BenchmarkLinearPhase(options));
+    results->setProperty("compressor", BenchmarkCompressor(options));
+    results->setProperty("gainComputer", BenchmarkGainComputer(options));
+
+    auto json = JSON::toString(var(results.get()));
+
+    if (options.output == File())
+    {
+        std::cout << json << "\n";
+    }
+    else if (!options.output.replaceWithText(json))
+    {
+        std::cerr << "Cannot write " << options.output.getFullPathName() << "\n";
+        return 1;
+    }
+
+    auto isPassed = true;
+
+    for (const auto& check : checks)
+    {
+        if (!IsPassed(results->getProperty(check.benchmark), check.property))
+        {
+            std::cerr << "Check failed: " << check.benchmark << "." << check.property << "\n";
+            isPassed = false;
+        }
+    }
+
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,355 @@
+#include <JuceHeader.h>
+#include "../eclistarVST(main)/PluginProcessor.h"
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+//==============================================================================================
+// Offline renderer: streams audio files from disk through EclistarVSTAudioProcessor.
+//
+// Every worker thread owns its processor, the files are taken from a shared queue.
+// The processed file gets the "_eclistar" suffix and keeps the format of the input.
+
+namespace
+{
+    const char* const usage =
+        "Usage: eclistarRender [options] <input files...>\n"
+        "\n"
+        "  --preset <file>      state of the plugin (.state1) to load\n"
+        "  --output <dir>       directory of the processed files (default: next to the input)\n"
+        "  --block <samples>    size of the processed blocks (default: 8192)\n"
+        "  --jobs <number>      number of worker threads (default: number of CPUs)\n"
+        "  --band-workers <n>   extra threads compressing the bands of every file (default: 0)\n"
+        "  --oversampling <n>   oversampling of the compressors: 1, 2, 4 or 8 (default: from the preset)\n"
+        "  --linear-phase       linear-phase split of the bands (default: from the preset)\n"
+        "  --trace <dir>        trace the blocks of every worker into <dir>/trace-<worker>.json\n";
+
+    // Options of the command line.
+
+    struct RenderOptions
+    {
+        File preset;
+        File outputDirectory;
+
+        int blockSize{ 8192 };
+        int numJobs{ SystemStats::getNumCpus() };
+
+        // Threads of the parallel processing of the bands, besides the worker of the file.
+
+        int numBandWorkers{ 0 };
+
+        // Index of the factor in compressor_parameters::oversamplingFactors, -1 keeps the preset.
+
+        int oversampling{ -1 };
+
+        bool linearPhase{ false };
+
+        // Directory of the block traces (none: no tracing).
+
+        File traceDirectory;
+
+        Array <File> inputs;
+    };
+
+    // Result of the rendering of one file.
+
+    struct RenderResult
+    {
+        String error;
+
+        double audioSeconds{ 0.0 };
+        double processingSeconds{ 0.0 };
+        double totalSeconds{ 0.0 };
+    };
+
+    bool ParseOptions(const StringArray& arguments, RenderOptions& options)
+    {
+        for (int i = 0; i < arguments.size(); ++i)
+        {
+            const auto& argument = arguments[i];
+            auto hasValue = i + 1 < arguments.size();
+
+            if (argument == "--preset" && hasValue)
+                options.preset = File::getCurrentWorkingDirectory().getChildFile(arguments[++i]);
+            else if (argument == "--output" && hasValue)
+                options.outputDirectory = File::getCurrentWorkingDirectory().getChildFile(arguments[++i]);
+            else if (argument == "--block" && hasValue)
+                options.blockSize = arguments[++i].getIntValue();
+            else if (argument == "--jobs" && hasValue)
+                options.numJobs = arguments[++i].getIntValue();
+            else if (argument == "--band-workers" && hasValue)
+                options.numBandWorkers = arguments[++i].getIntValue();
+            else if (argument == "--oversampling" && hasValue)
+            {
+                const auto& factors = compressor_parameters::oversamplingFactors;
+                auto factor = (size_t)jmax(0, arguments[++i].getIntValue());
+                auto found = find(factors.begin(), factors.end(), factor);
+
+                if (found == factors.end())
+                    return false;
+
+                options.oversampling = (int)(found - factors.begin());
+            }
+            else if (argument == "--linear-phase")
+                options.linearPhase = true;
+            else if (argument == "--trace" && hasValue)
+                options.traceDirectory = File::getCurrentWorkingDirectory().getChildFile(arguments[++i]);
+            else if (argument.startsWith("--"))
+                return false;
+            else
+                options.inputs.add(File::getCurrentWorkingDirectory().getChildFile(argument));
+        }
+
+        return !options.inputs.isEmpty() && options.blockSize > 0 && options.numJobs > 0 && options.numBandWorkers >= 0;
+    }
+
+    //------------------------------------------------------------------
+    // Rendering of one file.
+
+    RenderResult RenderFile(EclistarVSTAudioProcessor& processor,
+                            AudioFormatManager& formats,
+                            const File& input,
+                            const RenderOptions& options)
+    {
+        RenderResult result;
+        auto startTime = Time::getMillisecondCounterHiRes();
+
+        unique_ptr <AudioFormatReader> reader(formats.createReaderFor(input));
+
+        if (reader == nullptr)
+        {
+            result.error = "unsupported or unreadable file";
+            return result;
+        }
+
+        auto numChannels = (int)reader->numChannels;
+        auto channelSet = AudioChannelSet::canonicalChannelSet(numChannels);
+
+        AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.inputBuses.add(AudioChannelSet::disabled());
+        layout.outputBuses.add(channelSet);
+
+        if (!processor.setBusesLayout(layout))
+        {
+            result.error = "unsupported number of channels: " + String(numChannels);
+            return result;
+        }
+
+        // Writer of the same format and bit depth as the input.
+
+        auto* format = formats.findFormatForFileExtension(input.getFileExtension());
+
+        if (format == nullptr)
+        {
+            result.error = "no writer for the extension " + input.getFileExtension();
+            return result;
+        }
+
+        auto bitDepths = format->getPossibleBitDepths();
+        auto bitsPerSample = bitDepths.contains((int)reader->bitsPerSample) ? (int)reader->bitsPerSample
+                                                                            : bitDepths.getLast();
+
+        auto directory = options.outputDirectory == File() ? input.getParentDirectory()
+                                                           : options.outputDirectory;
+        auto output = directory.getChildFile(input.getFileNameWithoutExtension()
+                                             + "_eclistar" + input.getFileExtension());
+
+        output.deleteFile();
+
+        auto stream = output.createOutputStream();
+        unique_ptr <AudioFormatWriter> writer;
+
+        if (stream != nullptr)
+        {
+            writer.reset(format->createWriterFor(stream.get(), reader->sampleRate, (unsigned int)numChannels,
+                                                 bitsPerSample, reader->metadataValues, 0));
+        }
+
+        if (writer == nullptr)
+        {
+            result.error = "cannot write " + output.getFullPathName();
+            return result;
+        }
+
+        stream.release();
+
+        // Streaming through the processor.
+
+        processor.setNonRealtime(true);
+        processor.prepareToPlay(reader->sampleRate, options.blockSize);
+
+        AudioBuffer <float> buffer(numChannels, options.blockSize);
+        MidiBuffer midiMessages;
+
+        // The latency of the processor (linear phase, oversampling) is compensated: its first samples are
+        // dropped and the input is extended with silence (the reader gives zeros past its end),
+        // so the output is aligned with the input and has the same length.
+
+        auto latency = (int64)processor.getLatencySamples();
+        auto samplesToSkip = latency;
+        auto length = reader->lengthInSamples + latency;
+
+        for (int64 position = 0; position < length; position += options.blockSize)
+        {
+            auto numSamples = (int)jmin((int64)options.blockSize, length - position);
+
+            buffer.setSize(numChannels, numSamples, false, false, true);
+            reader->read(&buffer, 0, numSamples, position, true, true);
+
+            auto blockStart = Time::getMillisecondCounterHiRes();
+            processor.processBlock(buffer, midiMessages);
+            result.processingSeconds += (Time::getMillisecondCounterHiRes() - blockStart) / 1000.0;
+
+            auto skipped = (int)jmin(samplesToSkip, (int64)numSamples);
+            samplesToSkip -= skipped;
+
+            writer->writeFromAudioSampleBuffer(buffer, skipped, numSamples - skipped);
+        }
+
+        processor.releaseResources();
+
+        result.audioSeconds = (double)reader->lengthInSamples / reader->sampleRate;
+        result.totalSeconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+        return result;
+    }
+}
+
+//==============================================================================================
+
+int main(int argc, char* argv[])
+{
+    // The message manager is needed by the parameters of the processor (APVTS timer).
+
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    RenderOptions options;
+    StringArray arguments;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        arguments.add(CharPointer_UTF8(argv[i]));
+    }
+
+    if (!ParseOptions(arguments, options))
+    {
+        std::cerr << usage;
+        return 1;
+    }
+
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    // One processor for every worker, all of them with the same preset.
+
+    MemoryBlock presetData;
+
+    if (options.preset != File() && !options.preset.loadFileAsData(presetData))
+    {
+        std::cerr << "Cannot read the preset " << options.preset.getFullPathName() << "\n";
+        return 1;
+    }
+
+    auto numWorkers = jmin(options.numJobs, options.inputs.size());
+    vector <unique_ptr <EclistarVSTAudioProcessor>> processors;
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        processors.push_back(make_unique <EclistarVSTAudioProcessor>());
+
+        if (presetData.getSize() > 0)
+        {
+            processors.back()->setStateInformation(presetData.getData(), (int)presetData.getSize());
+        }
+
+        if (options.oversampling >= 0)
+        {
+            auto* parameter = processors.back()->apvts.getParameter(
+                compressor_parameters::GetParameters().at(compressor_parameters::oversampling));
+
+            parameter->setValueNotifyingHost(parameter->convertTo0to1((float)options.oversampling));
+        }
+
+        if (options.linearPhase)
+        {
+            auto* parameter = processors.back()->apvts.getParameter(
+                compressor_parameters::GetParameters().at(compressor_parameters::linearPhase));
+
+            parameter->setValueNotifyingHost(1.0f);
+        }
+
+        processors.back()->setParallelProcessing(options.numBandWorkers > 0, options.numBandWorkers);
+
+        if (options.traceDirectory != File())
+        {
+            options.traceDirectory.createDirectory();
+            processors.back()->setTracingEnabled(true, options.traceDirectory.getChildFile("trace-" + String(i) + ".json"));
+        }
+    }
+
+    // Workers take the files one by one and report every file when it is done.
+
+    atomic <int> nextFile{ 0 };
+    atomic <int> numFailures{ 0 };
+    mutex reportMutex;
+
+    auto Worker = [&](EclistarVSTAudioProcessor& processor)
+    {
+        for (auto index = nextFile++; index < options.inputs.size(); index = nextFile++)
+        {
+            const auto& input = options.inputs.getReference(index);
+            auto result = RenderFile(processor, formats, input, options);
+
+            lock_guard <mutex> lock(reportMutex);
+
+            if (result.error.isNotEmpty())
+            {
+                ++numFailures;
+                std::cerr << input.getFileName() << ": " << result.error << "\n";
+            }
+            else
+            {
+                std::cout << input.getFileName() << ": "
+                          << String(result.audioSeconds, 2) << " s of audio, "
+                          << String(result.audioSeconds / jmax(result.processingSeconds, 1.0e-9), 1)
+                          << "x realtime (DSP), "
+                          << String(result.audioSeconds / jmax(result.totalSeconds, 1.0e-9), 1)
+                          << "x realtime (with disk I/O)\n";
+            }
+        }
+    };
+
+    vector <thread> workers;
+
+    for (auto& processor : processors)
+    {
+        workers.emplace_back(Worker, std::ref(*processor));
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    // The traces are complete when the tracing stops (the last report is written then).
+
+    if (options.traceDirectory != File())
+    {
+        for (size_t i = 0; i < processors.size(); ++i)
+        {
+            auto& tracer = processors[i]->getBlockTracer();
+            VstBlockTracer::Report report;
+
+            processors[i]->setTracingEnabled(false);
+
+            if (tracer.read(report))
+            {
+                std::cout << "worker " << i << ": " << report.toString() << "\n";
+            }
+        }
+    }
+
+    return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+#include "AllocationTrap.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//==============================================================================================
+// State of the trap.
+
+namespace allocation_trap
+{
+    namespace
+    {
+        std::atomic<int> numberOfViolations{ 0 };
+
+#if JUCE_DEBUG
+        thread_local int trapDepth = 0;
+        thread_local bool isReporting = false;
+
+        // The assertion itself may allocate (logging), so the trap is switched off
+        // while the violation is being reported.
+
+        void CheckAllocation() noexcept
+        {
+            if (trapDepth == 0 || isReporting)
+                return;
+
+            isReporting = true;
+            numberOfViolations.fetch_add(1, std::memory_order_relaxed);
+
+            // Heap allocation or deallocation on the audio thread!
+            jassertfalse;
+
+            isReporting = false;
+        }
+#endif
+    }
+
+#if JUCE_DEBUG
+    ScopedAudioThreadTrap::ScopedAudioThreadTrap() noexcept
+    {
+        ++trapDepth;
+    }
+
+    ScopedAudioThreadTrap::~ScopedAudioThreadTrap() noexcept
+    {
+        --trapDepth;
+    }
+#endif
+
+    int getNumberOfViolations() noexcept
+    {
+        return numberOfViolations.load(std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================================
+// Replacement of the global allocation functions (debug builds only).
+// The array and nothrow forms of the standard library forward to these ones.
+
+#if JUCE_DEBUG
+
+namespace
+{
+    void* AlignedAllocate(size_t size, size_t alignment) noexcept
+    {
+#if JUCE_WINDOWS
+        return _aligned_malloc(size, alignment);
+#else
+        void* pointer = nullptr;
+        return posix_memalign(&pointer, alignment, size) == 0 ? pointer : nullptr;
+#endif
+    }
+
+    void AlignedFree(void* pointer) noexcept
+    {
+#if JUCE_WINDOWS
+        _aligned_free(pointer);
+#else
+        std::free(pointer);
+#endif
+    }
+}
+
+void* operator new(size_t size)
+{
+    allocation_trap::CheckAllocation();
+
+    if (auto* pointer = std::malloc(size != 0 ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    allocation_trap::CheckAllocation();
+
+    if (auto* pointer = AlignedAllocate(size != 0 ? size : 1, static_cast<size_t>(alignment)))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        allocation_trap::CheckAllocation();
+
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    if (pointer != nullptr)
+        allocation_trap::CheckAllocation();
+
+    AlignedFree(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+#endif
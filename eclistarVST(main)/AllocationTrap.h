@@ -0,0 +1,25 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================================
+// Debug trap for heap allocations on the audio thread.
+//
+// While a ScopedAudioThreadTrap is alive on the current thread, every call of the global
+// operator new/delete is counted as a violation and stops in the debugger. In release
+// builds the trap is an empty object and costs nothing.
+
+namespace allocation_trap
+{
+    struct ScopedAudioThreadTrap
+    {
+#if JUCE_DEBUG
+        ScopedAudioThreadTrap() noexcept;
+        ~ScopedAudioThreadTrap() noexcept;
+#endif
+    };
+
+    // Number of allocations caught since the start of the process (always 0 in release).
+
+    int getNumberOfViolations() noexcept;
+}
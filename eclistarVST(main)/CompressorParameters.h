@@ -0,0 +1,173 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+using namespace std;
+
+//==============================================================================================
+// Namespace of compressor parameters.
+//
+// The parameters of the bands and of the crossovers are generated for the largest number
+// of bands. The first three bands and the first two crossovers keep the IDs of the
+// three-band version, so its presets and automation are still found.
+
+namespace compressor_parameters
+{
+    // Number of bands.
+
+    constexpr size_t minNumBands = 2;
+    constexpr size_t maxNumBands = 8;
+    constexpr size_t defaultNumBands = 3;
+
+    constexpr size_t maxNumCrossovers = maxNumBands - 1;
+
+    // Parameters of every band.
+
+    enum class BandParameter
+    {
+        ratio,
+        attack,
+        release,
+        threshold,
+
+        solo,
+        mute,
+        bypassed,
+
+        lookahead,
+
+        sidechain,
+
+        numBandParameters
+    };
+
+    constexpr size_t numBandParameters = (size_t)BandParameter::numBandParameters;
+
+    // New parameters are added at the end: the binary presets (VstPreset) keep this order.
+
+    enum NamesOfParameters
+    {
+        // Names of additional parameters and channels.
+
+        gainInput,
+        gainOutput,
+
+        numberOfBands,
+
+        // Crossovers (maxNumCrossovers of them), then the bands one after another.
+
+        firstCrossoverFreq,
+        firstBandParameter = firstCrossoverFreq + maxNumCrossovers,
+
+        // Oversampling of the compressors (choices of oversamplingFactors, then of the quality).
+
+        oversampling = firstBandParameter + maxNumBands * numBandParameters,
+        oversamplingQuality,
+
+        // One detector for all channels of a band.
+
+        linkChannels,
+
+        // Linear-phase crossover instead of the Linkwitz-Riley filters.
+
+        linearPhase,
+
+        // Width of the soft knee of all bands in decibels.
+
+        knee,
+
+        // Number of parameters.
+
+        numOfParameters
+    };
+
+    constexpr NamesOfParameters crossoverFreq(size_t crossover)
+    {
+        return (NamesOfParameters)(firstCrossoverFreq + crossover);
+    }
+
+    constexpr NamesOfParameters bandParameter(size_t band, BandParameter parameter)
+    {
+        return (NamesOfParameters)(firstBandParameter + band * numBandParameters + (size_t)parameter);
+    }
+
+    // Correlation of parameters and their names when determining on the layout.
+
+    inline const map<NamesOfParameters, String>& GetParameters()
+    {
+        static const map <NamesOfParameters, String> parameters = []
+        {
+            // IDs of the three-band version (note the spelling of the high band ratio);
+            // the lookahead and the sidechain came later, but their IDs follow the same pattern.
+
+            const char* const legacyBandIds[numBandParameters][3] =
+            {
+                { "ratio low band", "ratio mid band", "Ratio high Band" },
+                { "attack low band", "attack mid band", "attack high band" },
+                { "release low band", "release mid band", "release high band" },
+                { "threshold low band", "threshold mid band", "threshold high band" },
+                { "solo low band", "solo mid band", "solo high band" },
+                { "mute low band", "mute mid band", "mute high band" },
+                { "bypassed low band", "bypassed mid band", "bypassed high band" },
+                { "lookahead low band", "lookahead mid band", "lookahead high band" },
+                { "sidechain low band", "sidechain mid band", "sidechain high band" }
+            };
+
+            const char* const bandParameterNames[numBandParameters] =
+            {
+                "ratio", "attack", "release", "threshold", "solo", "mute", "bypassed", "lookahead", "sidechain"
+            };
+
+            const char* const legacyCrossoverIds[2] =
+            {
+                "low-mid crossover frequency", "mid-high crossover frequency"
+            };
+
+            map <NamesOfParameters, String> names;
+
+            names[gainInput] = "gain in";
+            names[gainOutput] = "gain out";
+            names[numberOfBands] = "number of bands";
+            names[oversampling] = "oversampling";
+            names[oversamplingQuality] = "oversampling quality";
+            names[linkChannels] = "link channels";
+            names[linearPhase] = "linear phase";
+            names[knee] = "knee";
+
+            for (size_t crossover = 0; crossover < maxNumCrossovers; ++crossover)
+            {
+                names[crossoverFreq(crossover)] = crossover < 2
+                    ? String(legacyCrossoverIds[crossover])
+                    : "crossover frequency " + String(crossover + 1);
+            }
+
+            for (size_t band = 0; band < maxNumBands; ++band)
+            {
+                for (size_t parameter = 0; parameter < numBandParameters; ++parameter)
+                {
+                    names[bandParameter(band, (BandParameter)parameter)] = band < 3
+                        ? String(legacyBandIds[parameter][band])
+                        : String(bandParameterNames[parameter]) + " band " + String(band + 1);
+                }
+            }
+
+            return names;
+        }();
+
+        return parameters;
+    }
+
+    // Values of the ratio choices: the audio thread takes the ratio from here
+    // by the index of the choice instead of parsing its name.
+
+    constexpr array <float, 13> ratioValues{ 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 5.0f, 7.0f,
+                                             9.0f, 10.0f, 15.0f, 20.0f, 50.0f, 100.0f };
+
+    // Oversampling factors of the choices (1 is off), and the names of the qualities
+    // (in the order of VstOversamplerBase::Quality).
+
+    constexpr array <size_t, 4> oversamplingFactors{ 1, 2, 4, 8 };
+
+    constexpr array <const char*, 3> oversamplingQualities{ "draft", "normal", "high" };
+}
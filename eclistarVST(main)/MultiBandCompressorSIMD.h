@@ -0,0 +1,746 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "VstFastMath.h"
+
+using namespace juce;
+using namespace dsp;
+using namespace std;
+
+#if ! JUCE_USE_SIMD
+ #error "MultiBandCompressorSIMD needs juce::dsp::SIMDRegister (SSE or NEON)."
+#endif
+
+//==============================================================================================
+// Compressor of all bands and channels at once.
+//
+// The algorithm is the one of juce::dsp::Compressor (peak BallisticsFilter + VCA), but the
+// channels of the bands are laid out in the lanes of SIMDRegisters. The bands come in one
+// block of numBands * numChannels channels, as written by VstCrossover: band b, channel c
+// is the channel b * numChannels + c. This block is cut into chunks of SIMDRegister::size()
+// consecutive channels, and the envelope followers, the threshold test and the gain of a
+// chunk are computed together, whatever band each of its lanes belongs to. So the lanes
+// stay full for any number of bands and channels (up to maxNumChannels), and the cost per
+// channel does not depend on how the channels fall into the bands.
+//
+// The gain computer works in the log domain: the overshoot of the envelope over the
+// threshold (in log2 units) times 1 / ratio - 1 is the gain, with a quadratic soft knee of
+// the given width centred on the threshold. log2 and exp2 are the polynomials of VstFastMath,
+// computed in a branch-free loop over the lanes of a register (vectorized by the compiler),
+// and only when a lane is above the start of its knee. With no knee the gain is the power
+// law of Compressor, (envelope / threshold)^(1 / ratio - 1); with a knee the quadratic curve.
+// Both are met within maxGainErrorDecibels, in float and double (checked by the gainComputer
+// benchmark).
+//
+// The settings are stored as a structure of arrays (one aligned array per coefficient, one
+// lane per channel of a band), so a chunk is loaded with a single register.
+//
+// With linked channels all channels of a band share one envelope, which follows the peak of
+// all of them, and get the same gain (the image of a stereo or surround mix does not move).
+// Then the bands are in the lanes, and the channels are read one after another.
+//
+// processScalar() is the reference path: the same math band by band, without SIMD.
+// Both paths give the same output (they use the same operations in the same order).
+// A bypassed band passes the signal and keeps its envelope, as Compressor does.
+//
+// Bands that are not heard can be left out with setActiveBands(): they are neither read nor
+// written, and their envelopes restart from zero when they become active again. When no
+// band is active and not bypassed, processing costs nothing.
+//
+// The envelopes follow the bands themselves, or separate keys in the same layout (the
+// window peaks of VstLookahead).
+//
+// The samples and coefficients are of SampleType (float or double); the settings of the
+// bands stay in float, as the parameters are.
+
+template <typename SampleType>
+class MultiBandCompressorSIMD
+{
+public:
+
+    using Lane = SIMDRegister <SampleType>;
+
+    static constexpr size_t maxNumBands = 8;
+    static constexpr size_t maxNumChannels = 16;
+
+    static constexpr size_t maxNumLanes = maxNumBands * maxNumChannels;
+
+    static_assert(maxNumLanes % Lane::size() == 0, "The lanes must fill whole registers.");
+
+    // Largest error of the gain against the exact curves (log2 and exp2 of VstFastMath are
+    // within 1e-5 dB each, the rest is the rounding of the sample type).
+
+    static constexpr double maxGainErrorDecibels = 0.001;
+
+    // Functions of the compressor itself (numChannels is the number of channels of a band).
+
+    void prepare(const ProcessSpec& process_spec)
+    {
+        jassert(process_spec.numChannels >= 1 && process_spec.numChannels <= maxNumChannels);
+
+        _numChannels = jlimit((size_t)1, maxNumChannels, (size_t)process_spec.numChannels);
+        _envelopes.resize((_numChannels * maxNumBands + Lane::size() - 1) / Lane::size());
+
+        setSampleRate(process_spec.sampleRate);
+        reset();
+    }
+
+    // Rate of the processed samples (e.g. the oversampled one); no allocation.
+
+    void setSampleRate(double sampleRate) noexcept
+    {
+        _expFactor = (SampleType)(-2.0 * MathConstants <double>::pi * 1000.0 / sampleRate);
+
+        for (size_t band = 0; band < maxNumBands; ++band)
+        {
+            UpdateBand(band);
+        }
+    }
+
+    void reset()
+    {
+        for (auto& envelope : _envelopes)
+        {
+            envelope = Lane::expand((SampleType)0);
+        }
+    }
+
+    // Number of bands in the block (the settings of all bands are kept).
+
+    void setNumBands(size_t numBands) noexcept
+    {
+        jassert(numBands >= 1 && numBands <= maxNumBands);
+
+        _numBands = jlimit((size_t)1, maxNumBands, numBands);
+    }
+
+    size_t getNumBands() const noexcept { return _numBands; }
+
+    // Linked detection: one envelope for all channels of a band. The linked envelope starts
+    // from the highest envelope of the channels, so the gain does not jump.
+
+    void setChannelLink(bool shouldLinkChannels) noexcept
+    {
+        if (shouldLinkChannels && !_isLinked && !_envelopes.empty())
+        {
+            for (size_t band = 0; band < maxNumBands; ++band)
+            {
+                auto envelope = (SampleType)0;
+
+                for (size_t channel = 0; channel < _numChannels; ++channel)
+                {
+                    envelope = jmax(envelope, GetEnvelope(band * _numChannels + channel));
+                }
+
+                SetBandEnvelope(band, envelope);
+            }
+        }
+
+        _isLinked = shouldLinkChannels;
+    }
+
+    bool isChannelLinked() const noexcept { return _isLinked; }
+
+    void setBandParameters(size_t band, float attack, float release, float threshold, float ratio, bool bypassed)
+    {
+        jassert(band < maxNumBands);
+        jassert(ratio >= 1.0f);
+
+        auto& parameters = _parameters[band];
+
+        parameters.bypassed = bypassed;
+
+        if (parameters.attack != attack || parameters.release != release
+            || parameters.threshold != threshold || parameters.ratio != ratio)
+        {
+            parameters.attack = attack;
+            parameters.release = release;
+            parameters.threshold = threshold;
+            parameters.ratio = ratio;
+
+            UpdateBand(band);
+        }
+    }
+
+    // Width of the soft knee in decibels for all bands (0 is a hard knee).
+
+    void setKnee(float kneeDecibels)
+    {
+        jassert(kneeDecibels >= 0.0f);
+
+        kneeDecibels = jmax(0.0f, kneeDecibels);
+
+        if (_kneeDecibels != kneeDecibels)
+        {
+            _kneeDecibels = kneeDecibels;
+
+            auto kneeWidth = VstFastMath::decibelsToLog2((SampleType)kneeDecibels);
+
+            _kneeHalf = kneeWidth / (SampleType)2;
+            _kneeFactor = kneeWidth > (SampleType)0 ? (SampleType)1 / ((SampleType)2 * kneeWidth) : (SampleType)0;
+
+            for (size_t band = 0; band < maxNumBands; ++band)
+            {
+                UpdateThreshold(band);
+            }
+        }
+    }
+
+    float getKnee() const noexcept { return _kneeDecibels; }
+
+    // Threshold alone (smoothed automation): only its own coefficients are recomputed.
+
+    void setBandThreshold(size_t band, float threshold)
+    {
+        jassert(band < maxNumBands);
+
+        if (_parameters[band].threshold != threshold)
+        {
+            _parameters[band].threshold = threshold;
+            UpdateThreshold(band);
+        }
+    }
+
+    // Bands to process (bit 0 is the first band).
+
+    void setActiveBands(uint32 bandMask) noexcept
+    {
+        for (size_t band = 0; band < maxNumBands; ++band)
+        {
+            auto isActive = (bandMask & (1u << band)) != 0;
+
+            if (isActive && (_activeBands & (1u << band)) == 0)
+            {
+                SetBandEnvelope(band, (SampleType)0);
+            }
+        }
+
+        _activeBands = bandMask;
+    }
+
+    // Gain of the band at its current envelopes (the lowest of its channels), for the meters.
+
+    SampleType getBandGain(size_t band) const noexcept
+    {
+        jassert(band < _numBands);
+
+        auto gain = (SampleType)1;
+
+        if (!IsCompressing(band) || _envelopes.empty())
+            return gain;
+
+        for (auto lane = band * _numChannels; lane < (band + 1) * _numChannels; ++lane)
+        {
+            gain = jmin(gain, Gain(lane, GetEnvelope(lane)));
+        }
+
+        return gain;
+    }
+
+    // Gain of the band at the given envelope (the curve of the gain computer).
+
+    SampleType getGain(size_t band, SampleType envelope) const noexcept
+    {
+        jassert(band < maxNumBands);
+
+        return Gain(band * _numChannels, envelope);
+    }
+
+    // Vectorized processing of the bands (in place), detection on the bands or on the keys.
+    //
+    // The block may hold only the channels firstChannel ... of the bands, if it starts on a
+    // register (and holds whole bands when the channels are linked): such blocks share no
+    // envelope, so different threads can process different parts of the bands.
+
+    void process(AudioBlock <SampleType>& bands, size_t firstChannel = 0) noexcept
+    {
+        Process(bands, nullptr, firstChannel);
+    }
+
+    void process(AudioBlock <SampleType>& bands, const AudioBlock <SampleType>& keys, size_t firstChannel = 0) noexcept
+    {
+        Process(bands, &keys, firstChannel);
+    }
+
+    // Scalar reference path (in place).
+
+    void processScalar(AudioBlock <SampleType>& bands, const AudioBlock <SampleType>* keys = nullptr) noexcept
+    {
+        auto numChannels = bands.getNumChannels() / _numBands;
+
+        for (size_t band = 0; band < _numBands; ++band)
+        {
+            auto block = bands.getSubsetChannelBlock(band * numChannels, numChannels);
+
+            if (keys != nullptr)
+            {
+                auto keyBlock = keys->getSubsetChannelBlock(band * numChannels, numChannels);
+                processScalarBand(block, band, &keyBlock);
+            }
+            else
+            {
+                processScalarBand(block, band);
+            }
+        }
+    }
+
+    void processScalarBand(AudioBlock <SampleType>& block, size_t band, const AudioBlock <SampleType>* keys = nullptr) noexcept
+    {
+        auto numChannels = block.getNumChannels();
+        auto numSamples = block.getNumSamples();
+
+        jassert(band < _numBands);
+        jassert(numChannels == _numChannels);
+        jassert(keys == nullptr || (keys->getNumChannels() == numChannels && keys->getNumSamples() == numSamples));
+
+        if (!IsCompressing(band))
+            return;
+
+        auto first = band * _numChannels;
+
+        // Linked channels: the peak of all channels drives the envelope of the first one.
+
+        if (_isLinked)
+        {
+            auto envelope = GetEnvelope(first);
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                auto peak = (SampleType)0;
+
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                {
+                    auto* key = keys != nullptr ? keys->getChannelPointer(channel) : block.getChannelPointer(channel);
+                    peak = jmax(peak, std::abs(key[i]));
+                }
+
+                envelope = NextEnvelope(first, envelope, peak);
+
+                auto gain = Gain(first, envelope);
+
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                {
+                    block.getChannelPointer(channel)[i] *= gain;
+                }
+            }
+
+            SetBandEnvelope(band, envelope);
+            return;
+        }
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            auto* samples = block.getChannelPointer(channel);
+            auto* key = keys != nullptr ? keys->getChannelPointer(channel) : samples;
+            auto lane = first + channel;
+
+            auto envelope = GetEnvelope(lane);
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                envelope = NextEnvelope(lane, envelope, std::abs(key[i]));
+                samples[i] = Gain(lane, envelope) * samples[i];
+            }
+
+            SetEnvelope(lane, envelope);
+        }
+    }
+
+private:
+
+    struct BandParameters
+    {
+        float attack{ 1.0f };
+        float release{ 100.0f };
+        float threshold{ 0.0f };
+        float ratio{ 1.0f };
+
+        bool bypassed{ false };
+    };
+
+    // Scalar steps of the ballistics filter and of the VCA for one lane (as in the SIMD paths).
+
+    SampleType NextEnvelope(size_t lane, SampleType envelope, SampleType peak) const noexcept
+    {
+        auto cte = peak > envelope ? _cteAttack[lane] : _cteRelease[lane];
+
+        return peak + cte * (envelope - peak);
+    }
+
+    // Gain computer in the log domain (1 below the knee): with the overshoot d in log2 units
+    // and y = d + knee / 2, the gain is slope * (k^2 / (2 * knee) + max(0, y - knee)), where
+    // k = max(0, y) - max(0, y - knee) is y limited to [0, knee] (the quadratic part).
+
+    SampleType Gain(SampleType thresholdLog2, SampleType slope, SampleType envelope) const noexcept
+    {
+        auto fromKneeStart = VstFastMath::log2(envelope) - thresholdLog2 + _kneeHalf;
+
+        auto aboveKnee = VstFastMath::positivePart(fromKneeStart - (SampleType)2 * _kneeHalf);
+        auto inKnee = VstFastMath::positivePart(fromKneeStart) - aboveKnee;
+
+        return VstFastMath::exp2(slope * (inKnee * inKnee * _kneeFactor + aboveKnee));
+    }
+
+    SampleType Gain(size_t lane, SampleType envelope) const noexcept
+    {
+        return Gain(_thresholdLog2[lane], _slope[lane], envelope);
+    }
+
+    // Gains of one register of lanes at their envelopes (in place), from the coefficients of
+    // the lanes. The loop has no branch, so it is vectorized.
+
+    void Gains(const SampleType* thresholdsLog2, const SampleType* slopes, SampleType* envelopes) const noexcept
+    {
+        for (size_t lane = 0; lane < Lane::size(); ++lane)
+        {
+            envelopes[lane] = Gain(thresholdsLog2[lane], slopes[lane], envelopes[lane]);
+        }
+    }
+
+    void Process(AudioBlock <SampleType>& bands, const AudioBlock <SampleType>* keys, size_t firstChannel) noexcept
+    {
+        jassert(firstChannel % Lane::size() == 0);
+        jassert(firstChannel + bands.getNumChannels() <= _numBands * _numChannels);
+        jassert(keys == nullptr || (keys->getNumChannels() >= bands.getNumChannels()
+                                    && keys->getNumSamples() == bands.getNumSamples()));
+
+        if (_isLinked)
+        {
+            jassert(firstChannel % _numChannels == 0 && bands.getNumChannels() % _numChannels == 0);
+
+            ProcessLinked(bands, keys, firstChannel / _numChannels, bands.getNumChannels() / _numChannels);
+        }
+        else
+        {
+            ProcessChannels(bands, keys, firstChannel);
+        }
+    }
+
+    // Every lane is one channel of one band: chunks of consecutive channels of the block.
+
+    void ProcessChannels(AudioBlock <SampleType>& bands, const AudioBlock <SampleType>* keys, size_t firstChannel) noexcept
+    {
+        auto endChannel = firstChannel + bands.getNumChannels();
+        auto numSamples = bands.getNumSamples();
+
+        auto one = Lane::expand((SampleType)1);
+
+        for (auto first = firstChannel; first < endChannel; first += Lane::size())
+        {
+            auto numLanes = jmin(Lane::size(), endChannel - first);
+
+            alignas(sizeof(Lane)) SampleType active[Lane::size()] = {};
+            auto isAnyActive = false;
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                auto isActive = IsCompressing((first + lane) / _numChannels);
+
+                active[lane] = isActive ? (SampleType)1 : (SampleType)0;
+                isAnyActive = isAnyActive || isActive;
+            }
+
+            if (!isAnyActive)
+                continue;
+
+            auto activeMask = Lane::equal(Lane::fromRawArray(active), one);
+
+            auto cteAttack = Lane::fromRawArray(_cteAttack + first);
+            auto cteRelease = Lane::fromRawArray(_cteRelease + first);
+            auto kneeStart = Lane::fromRawArray(_kneeStart + first);
+
+            SampleType* samples[Lane::size()] = {};
+            const SampleType* keySamples[Lane::size()] = {};
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                samples[lane] = bands.getChannelPointer(first - firstChannel + lane);
+                keySamples[lane] = keys != nullptr ? keys->getChannelPointer(first - firstChannel + lane) : nullptr;
+            }
+
+            auto& envelopeState = _envelopes[first / Lane::size()];
+            auto envelope = envelopeState;
+
+            alignas(sizeof(Lane)) SampleType frame[Lane::size()] = {};
+            alignas(sizeof(Lane)) SampleType keyFrame[Lane::size()] = {};
+            alignas(sizeof(Lane)) SampleType values[Lane::size()] = {};
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    frame[lane] = samples[lane][i];
+                }
+
+                auto input = Lane::fromRawArray(frame);
+                auto key = input;
+
+                if (keys != nullptr)
+                {
+                    for (size_t lane = 0; lane < numLanes; ++lane)
+                    {
+                        keyFrame[lane] = keySamples[lane][i];
+                    }
+
+                    key = Lane::fromRawArray(keyFrame);
+                }
+
+                // Ballistics filter with peak rectifier.
+
+                auto peak = Lane::abs(key);
+                auto cte = Select(Lane::greaterThan(peak, envelope), cteAttack, cteRelease);
+                auto nextEnvelope = peak + cte * (envelope - peak);
+
+                envelope = Select(activeMask, nextEnvelope, envelope);
+
+                // VCA: the gain computer runs only when a lane is above the start of its knee.
+
+                auto gain = one;
+                auto aboveKnee = Lane::greaterThanOrEqual(envelope, kneeStart) & activeMask;
+
+                if (aboveKnee.sum() != 0)
+                {
+                    envelope.copyToRawArray(values);
+                    Gains(_thresholdLog2 + first, _slope + first, values);
+
+                    gain = Select(activeMask, Lane::fromRawArray(values), one);
+                }
+
+                (gain * input).copyToRawArray(frame);
+
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    samples[lane][i] = frame[lane];
+                }
+            }
+
+            envelopeState = envelope;
+        }
+    }
+
+    // Every lane is one band: the peak of its channels drives its envelope, and its gain is
+    // applied to all of them. The envelope is kept in the lanes of all channels of the band.
+
+    void ProcessLinked(AudioBlock <SampleType>& bands, const AudioBlock <SampleType>* keys,
+                       size_t blockFirstBand, size_t numBands) noexcept
+    {
+        auto numSamples = bands.getNumSamples();
+        auto blockFirstLane = blockFirstBand * _numChannels;
+
+        auto one = Lane::expand((SampleType)1);
+
+        for (auto firstBand = blockFirstBand; firstBand < blockFirstBand + numBands; firstBand += Lane::size())
+        {
+            auto numLanes = jmin(Lane::size(), blockFirstBand + numBands - firstBand);
+
+            if (!IsCompressing(firstBand, numLanes))
+                continue;
+
+            // Settings and envelopes of the bands, from the lanes of their first channels.
+
+            alignas(sizeof(Lane)) SampleType active[Lane::size()] = {};
+            alignas(sizeof(Lane)) SampleType cteAttacks[Lane::size()] = {};
+            alignas(sizeof(Lane)) SampleType cteReleases[Lane::size()] = {};
+            alignas(sizeof(Lane)) SampleType kneeStarts[Lane::size()] = {};
+            alignas(sizeof(Lane)) SampleType thresholdsLog2[Lane::size()] = {};
+            alignas(sizeof(Lane)) SampleType slopes[Lane::size()] = {};
+            alignas(sizeof(Lane)) SampleType values[Lane::size()] = {};
+
+            size_t firstLanes[Lane::size()] = {};
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                auto band = firstBand + lane;
+
+                firstLanes[lane] = band * _numChannels;
+
+                active[lane] = IsCompressing(band) ? (SampleType)1 : (SampleType)0;
+                cteAttacks[lane] = _cteAttack[firstLanes[lane]];
+                cteReleases[lane] = _cteRelease[firstLanes[lane]];
+                kneeStarts[lane] = _kneeStart[firstLanes[lane]];
+                thresholdsLog2[lane] = _thresholdLog2[firstLanes[lane]];
+                slopes[lane] = _slope[firstLanes[lane]];
+                values[lane] = GetEnvelope(firstLanes[lane]);
+            }
+
+            auto activeMask = Lane::equal(Lane::fromRawArray(active), one);
+
+            auto cteAttack = Lane::fromRawArray(cteAttacks);
+            auto cteRelease = Lane::fromRawArray(cteReleases);
+            auto kneeStart = Lane::fromRawArray(kneeStarts);
+            auto envelope = Lane::fromRawArray(values);
+
+            const auto& source = keys != nullptr ? *keys : bands;
+
+            alignas(sizeof(Lane)) SampleType frame[Lane::size()] = {};
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    auto peak = (SampleType)0;
+
+                    for (size_t channel = 0; channel < _numChannels; ++channel)
+                    {
+                        peak = jmax(peak, std::abs(source.getChannelPointer(firstLanes[lane] - blockFirstLane + channel)[i]));
+                    }
+
+                    frame[lane] = peak;
+                }
+
+                // Ballistics filter on the peaks of the bands.
+
+                auto peak = Lane::fromRawArray(frame);
+                auto cte = Select(Lane::greaterThan(peak, envelope), cteAttack, cteRelease);
+                auto nextEnvelope = peak + cte * (envelope - peak);
+
+                envelope = Select(activeMask, nextEnvelope, envelope);
+
+                // VCA of the bands above the start of their knee, applied to all their channels.
+
+                if ((Lane::greaterThanOrEqual(envelope, kneeStart) & activeMask).sum() == 0)
+                    continue;
+
+                envelope.copyToRawArray(values);
+                Gains(thresholdsLog2, slopes, values);
+
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    if (active[lane] == 0)
+                        continue;
+
+                    auto gain = values[lane];
+
+                    for (size_t channel = 0; channel < _numChannels; ++channel)
+                    {
+                        bands.getChannelPointer(firstLanes[lane] - blockFirstLane + channel)[i] *= gain;
+                    }
+                }
+            }
+
+            envelope.copyToRawArray(values);
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                SetBandEnvelope(firstBand + lane, values[lane]);
+            }
+        }
+    }
+
+    // Coefficients are computed as in Compressor::update and BallisticsFilter, and written
+    // into the lanes of all channels of the band.
+
+    void UpdateBand(size_t band)
+    {
+        auto& parameters = _parameters[band];
+
+        auto LimitedCte = [expFactor = _expFactor](float timeMs)
+        {
+            return timeMs < 1.0e-3f ? (SampleType)0 : (SampleType)std::exp(expFactor / (SampleType)timeMs);
+        };
+
+        auto cteAttack = LimitedCte(parameters.attack);
+        auto cteRelease = LimitedCte(parameters.release);
+        auto slope = (SampleType)1 / (SampleType)parameters.ratio - (SampleType)1;
+
+        for (auto lane = band * _numChannels; lane < (band + 1) * _numChannels; ++lane)
+        {
+            _cteAttack[lane] = cteAttack;
+            _cteRelease[lane] = cteRelease;
+            _slope[lane] = slope;
+        }
+
+        UpdateThreshold(band);
+    }
+
+    // The threshold in log2 units for the gain computer, and the envelope where the knee
+    // starts for the test of the lanes.
+
+    void UpdateThreshold(size_t band)
+    {
+        auto threshold = (SampleType)_parameters[band].threshold;
+
+        auto thresholdLog2 = VstFastMath::decibelsToLog2(threshold);
+        auto kneeStart = Decibels::decibelsToGain(threshold - (SampleType)_kneeDecibels / (SampleType)2, (SampleType)-200);
+
+        for (auto lane = band * _numChannels; lane < (band + 1) * _numChannels; ++lane)
+        {
+            _thresholdLog2[lane] = thresholdLog2;
+            _kneeStart[lane] = kneeStart;
+        }
+    }
+
+    bool IsCompressing(size_t band) const noexcept
+    {
+        return !_parameters[band].bypassed && (_activeBands & (1u << band)) != 0;
+    }
+
+    bool IsCompressing(size_t firstBand, size_t numBands) const noexcept
+    {
+        for (auto band = firstBand; band < firstBand + numBands; ++band)
+        {
+            if (IsCompressing(band))
+                return true;
+        }
+
+        return false;
+    }
+
+    // Envelopes of single lanes (outside of the sample loops).
+
+    SampleType GetEnvelope(size_t lane) const noexcept
+    {
+        return _envelopes[lane / Lane::size()].get(lane % Lane::size());
+    }
+
+    void SetEnvelope(size_t lane, SampleType envelope) noexcept
+    {
+        _envelopes[lane / Lane::size()].set(lane % Lane::size(), envelope);
+    }
+
+    void SetBandEnvelope(size_t band, SampleType envelope) noexcept
+    {
+        for (auto lane = band * _numChannels; lane < (band + 1) * _numChannels && lane / Lane::size() < _envelopes.size(); ++lane)
+        {
+            SetEnvelope(lane, envelope);
+        }
+    }
+
+    static Lane Select(typename Lane::vMaskType mask, Lane ifTrue, Lane ifFalse) noexcept
+    {
+        return (ifTrue & mask) + (ifFalse & ~mask);
+    }
+
+    //------------------------------------------------------------------
+
+    SampleType _expFactor{ 0 };
+
+    size_t _numBands{ 3 };
+    size_t _numChannels{ 1 };
+
+    bool _isLinked{ false };
+
+    array <BandParameters, maxNumBands> _parameters;
+
+    uint32 _activeBands{ (1u << maxNumBands) - 1 };
+
+    // Soft knee of all bands: its width, half of it in log2 units, and 1 / (2 * width).
+
+    float _kneeDecibels{ 0.0f };
+
+    SampleType _kneeHalf{ 0 };
+    SampleType _kneeFactor{ 0 };
+
+    // Per-lane coefficients (structure of arrays), lane b * numChannels + c for the channel c
+    // of the band b; the lanes after the last band stay neutral (a slope of 0 is a gain of 1).
+
+    alignas(sizeof(Lane)) SampleType _cteAttack[maxNumLanes] = {};
+    alignas(sizeof(Lane)) SampleType _cteRelease[maxNumLanes] = {};
+    alignas(sizeof(Lane)) SampleType _kneeStart[maxNumLanes] = {};
+    alignas(sizeof(Lane)) SampleType _thresholdLog2[maxNumLanes] = {};
+    alignas(sizeof(Lane)) SampleType _slope[maxNumLanes] = {};
+
+    // Envelopes of all lanes, in registers of consecutive lanes.
+
+    vector <Lane> _envelopes;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CompressorParameters.h"
+
+using namespace juce;
+using namespace std;
+
+//==============================================================================================
+// Lock-free snapshot of all parameters for the audio thread.
+//
+// Every parameter has a small APVTS listener that stores the new value and raises the bit
+// of the parameter in a change mask. Listeners may be called from any thread (the message
+// thread, or the audio thread for host automation) and never wait.
+//
+// Once per block the audio thread takes the mask with one atomic exchange (acquire) per
+// 64 parameters and copies only the changed values into a plain struct, so it never
+// touches the parameter objects and knows exactly which coefficients have to be recomputed.
+
+class ParameterSnapshot
+{
+public:
+
+    using NamesOfParameters = compressor_parameters::NamesOfParameters;
+
+    static constexpr size_t numOfParameters = compressor_parameters::numOfParameters;
+
+    static constexpr size_t numWords = (numOfParameters + 63) / 64;
+
+    // Values of all parameters, indexed by NamesOfParameters.
+
+    struct Values
+    {
+        array <float, numOfParameters> values{};
+
+        float operator[](NamesOfParameters name) const noexcept { return values[(size_t)name]; }
+
+        bool isOn(NamesOfParameters name) const noexcept { return values[(size_t)name] >= 0.5f; }
+
+        float ratio(NamesOfParameters name) const noexcept
+        {
+            auto index = jlimit(0, (int)compressor_parameters::ratioValues.size() - 1,
+                                roundToInt(values[(size_t)name]));
+
+            return compressor_parameters::ratioValues[(size_t)index];
+        }
+    };
+
+    // Set of parameters, one bit per parameter.
+
+    struct Mask
+    {
+        array <uint64, numWords> words{};
+
+        bool test(NamesOfParameters name) const noexcept
+        {
+            return (words[(size_t)name / 64] & ((uint64)1 << ((size_t)name % 64))) != 0;
+        }
+
+        bool any() const noexcept
+        {
+            for (auto word : words)
+            {
+                if (word != 0)
+                    return true;
+            }
+
+            return false;
+        }
+
+        bool intersects(const Mask& other) const noexcept
+        {
+            for (size_t i = 0; i < numWords; ++i)
+            {
+                if ((words[i] & other.words[i]) != 0)
+                    return true;
+            }
+
+            return false;
+        }
+
+        Mask& operator|=(const Mask& other) noexcept
+        {
+            for (size_t i = 0; i < numWords; ++i)
+            {
+                words[i] |= other.words[i];
+            }
+
+            return *this;
+        }
+
+        Mask operator|(const Mask& other) const noexcept { return Mask(*this) |= other; }
+    };
+
+    static Mask maskOf(NamesOfParameters name) noexcept
+    {
+        Mask mask;
+        mask.words[(size_t)name / 64] = (uint64)1 << ((size_t)name % 64);
+
+        return mask;
+    }
+
+    //------------------------------------------------------------------
+
+    explicit ParameterSnapshot(AudioProcessorValueTreeState& apvts)
+        : _apvts(apvts)
+    {
+        const auto& parameters = compressor_parameters::GetParameters();
+
+        for (size_t i = 0; i < numOfParameters; ++i)
+        {
+            auto name = (NamesOfParameters)i;
+            auto* value = _apvts.getRawParameterValue(parameters.at(name));
+
+            jassert(value != nullptr);
+
+            _published[i].store(value->load());
+
+            _listeners[i].owner = this;
+            _listeners[i].name = name;
+
+            _apvts.addParameterListener(parameters.at(name), &_listeners[i]);
+        }
+
+        markAllChanged();
+    }
+
+    ~ParameterSnapshot()
+    {
+        const auto& parameters = compressor_parameters::GetParameters();
+
+        for (size_t i = 0; i < numOfParameters; ++i)
+        {
+            _apvts.removeParameterListener(parameters.at((NamesOfParameters)i), &_listeners[i]);
+        }
+    }
+
+    // All values are reloaded on the next update (e.g. after prepareToPlay).
+
+    void markAllChanged() noexcept
+    {
+        for (size_t word = 0; word < numWords; ++word)
+        {
+            auto numBits = jmin((size_t)64, numOfParameters - word * 64);
+            _changed[word].fetch_or(~(uint64)0 >> (64 - numBits), memory_order_release);
+        }
+    }
+
+    // Audio thread: takes the published changes, returns the mask of changed parameters.
+
+    Mask update() noexcept
+    {
+        Mask changed;
+
+        for (size_t word = 0; word < numWords; ++word)
+        {
+            changed.words[word] = _changed[word].exchange(0, memory_order_acquire);
+
+            for (auto mask = changed.words[word]; mask != 0; mask &= mask - 1)
+            {
+                auto i = word * 64 + (size_t)countTrailingZeros(mask);
+                _current.values[i] = _published[i].load(memory_order_relaxed);
+            }
+        }
+
+        return changed;
+    }
+
+    const Values& get() const noexcept { return _current; }
+
+private:
+
+    struct Listener : public AudioProcessorValueTreeState::Listener
+    {
+        ParameterSnapshot* owner{ nullptr };
+        NamesOfParameters name{};
+
+        void parameterChanged(const String&, float newValue) override
+        {
+            auto index = (size_t)name;
+
+            owner->_published[index].store(newValue, memory_order_relaxed);
+            owner->_changed[index / 64].fetch_or((uint64)1 << (index % 64), memory_order_release);
+        }
+    };
+
+    static int countTrailingZeros(uint64 mask) noexcept
+    {
+        auto count = 0;
+
+        for (; (mask & 1) == 0; mask >>= 1)
+        {
+            ++count;
+        }
+
+        return count;
+    }
+
+    //------------------------------------------------------------------
+
+    AudioProcessorValueTreeState& _apvts;
+
+    array <atomic <float>, numOfParameters> _published;
+    array <atomic <uint64>, numWords> _changed{};
+
+    array <Listener, numOfParameters> _listeners;
+
+    Values _current;
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterSnapshot)
+};
@@ -1,29 +1,346 @@
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================================
-
-EclistarVSTAudioProcessorEditor::EclistarVSTAudioProcessorEditor(EclistarVSTAudioProcessor& processor)
-    : AudioProcessorEditor(&processor), audio_processor(processor)
-{
-    setSize(600, 500);
-}
-
-EclistarVSTAudioProcessorEditor::~EclistarVSTAudioProcessorEditor()
-{
-}
-
-//==============================================================================================
-
-void EclistarVSTAudioProcessorEditor::paint(Graphics& graphics)
-{
-    graphics.fillAll(getLookAndFeel().findColour(ResizableWindow::backgroundColourId));
-
-    graphics.setColour(Colours::white);
-    graphics.setFont(15.0f);
-    graphics.drawFittedText("Empty", getLocalBounds(), Justification::centred, 1);
-}
-
-void EclistarVSTAudioProcessorEditor::resized()
-{
-}
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+//==============================================================================================
+
+EclistarVSTAudioProcessorEditor::EclistarVSTAudioProcessorEditor(EclistarVSTAudioProcessor& processor)
+    : AudioProcessorEditor(&processor), audio_processor(processor), parameters_editor(processor)
+{
+    addAndMakeVisible(band_meters);
+    addAndMakeVisible(spectrum_view);
+    addAndMakeVisible(trace_label);
+    addAndMakeVisible(parameters_editor);
+
+    // The processor measures the bands and the spectra only while the editor is open.
+
+    audio_processor.setMeteringEnabled(true);
+    audio_processor.getSpectrumAnalyzer().setEnabled(true);
+    startTimerHz(refreshRateHz);
+
+    // The tracing is not turned on by the editor (only by the host tools or ECLISTAR_TRACE),
+    // the editor shows its report while it is on.
+
+    trace_label.setFont(12.0f);
+    trace_label.setText("Tracing off", dontSendNotification);
+
+    setSize(600, 500 + metersHeight + spectrumHeight + traceHeight);
+}
+
+EclistarVSTAudioProcessorEditor::~EclistarVSTAudioProcessorEditor()
+{
+    stopTimer();
+    audio_processor.setMeteringEnabled(false);
+    audio_processor.getSpectrumAnalyzer().setEnabled(false);
+}
+
+//==============================================================================================
+
+void EclistarVSTAudioProcessorEditor::paint(Graphics& graphics)
+{
+    graphics.fillAll(getLookAndFeel().findColour(ResizableWindow::backgroundColourId));
+}
+
+void EclistarVSTAudioProcessorEditor::resized()
+{
+    auto bounds = getLocalBounds();
+
+    band_meters.setBounds(bounds.removeFromTop(metersHeight).reduced(8));
+    spectrum_view.setBounds(bounds.removeFromTop(spectrumHeight).reduced(8));
+    trace_label.setBounds(bounds.removeFromTop(traceHeight).reduced(8, 0));
+    parameters_editor.setBounds(bounds);
+}
+
+void EclistarVSTAudioProcessorEditor::timerCallback()
+{
+    using namespace compressor_parameters;
+
+    const auto& parameters = GetParameters();
+
+    auto Value = [this, &parameters](NamesOfParameters name)
+    {
+        return audio_processor.apvts.getRawParameterValue(parameters.at(name))->load();
+    };
+
+    auto numBands = (size_t)jlimit(1, (int)maxNumBands, roundToInt(Value(numberOfBands)));
+
+    VstMeteringBus::Levels levels;
+
+    if (audio_processor.getMeteringBus().read(levels))
+    {
+        band_meters.setLevels(levels, numBands);
+    }
+    else
+    {
+        band_meters.fallBack();
+    }
+
+    // The view repaints itself only when the crossovers or the spectra have changed.
+
+    array <float, maxNumCrossovers> crossovers{};
+
+    for (size_t crossover = 0; crossover + 1 < numBands; ++crossover)
+    {
+        crossovers[crossover] = Value(crossoverFreq(crossover));
+    }
+
+    spectrum_view.setCrossovers(crossovers, numBands);
+
+    VstSpectrumAnalyzer::Spectrum spectrum;
+
+    if (audio_processor.getSpectrumAnalyzer().read(spectrum))
+    {
+        spectrum_view.setSpectrum(spectrum);
+    }
+
+    VstBlockTracer::Report report;
+
+    if (audio_processor.getBlockTracer().read(report))
+    {
+        trace_label.setText("Trace: " + report.toString(), dontSendNotification);
+    }
+}
+
+//==============================================================================================
+
+void EclistarBandMeters::setLevels(const VstMeteringBus::Levels& newLevels, size_t numBands)
+{
+    // New levels are taken at once when they are higher, and fall back at the rate of the
+    // meters when they are lower.
+
+    auto fall = Decibels::decibelsToGain(-fallDecibels);
+
+    for (size_t band = 0; band < levels.size(); ++band)
+    {
+        auto& level = levels[band];
+        const auto& newLevel = newLevels[band];
+
+        level.inputRms = jmax(newLevel.inputRms, level.inputRms * fall);
+        level.outputRms = jmax(newLevel.outputRms, level.outputRms * fall);
+        level.inputPeak = jmax(newLevel.inputPeak, level.inputPeak * fall);
+        level.outputPeak = jmax(newLevel.outputPeak, level.outputPeak * fall);
+        level.gainReduction = jmax(newLevel.gainReduction, level.gainReduction - fallDecibels);
+    }
+
+    num_bands = numBands;
+
+    repaint();
+}
+
+void EclistarBandMeters::fallBack()
+{
+    setLevels({}, num_bands);
+}
+
+void EclistarBandMeters::paint(Graphics& graphics)
+{
+    auto bounds = getLocalBounds().toFloat();
+    auto bandWidth = bounds.getWidth() / (float)num_bands;
+
+    auto Proportion = [](float gain)
+    {
+        return jlimit(0.0f, 1.0f, 1.0f - Decibels::gainToDecibels(gain, minDecibels) / minDecibels);
+    };
+
+    graphics.setFont(12.0f);
+
+    for (size_t band = 0; band < num_bands; ++band)
+    {
+        const auto& level = levels[band];
+
+        auto column = bounds.withX(bounds.getX() + bandWidth * (float)band).withWidth(bandWidth).reduced(6.0f, 0.0f);
+        auto label = column.removeFromBottom(16.0f);
+        auto meters = column.reduced(0.0f, 2.0f);
+
+        graphics.setColour(Colours::black.withAlpha(0.4f));
+        graphics.fillRect(meters);
+
+        // Input and output: RMS as a bar, peak as a line.
+
+        auto meterWidth = meters.getWidth() / 3.0f;
+        auto inputMeter = meters.withWidth(meterWidth);
+        auto outputMeter = meters.withX(meters.getX() + meterWidth).withWidth(meterWidth);
+        auto reductionMeter = meters.withX(meters.getX() + 2.0f * meterWidth).withWidth(meterWidth);
+
+        auto DrawLevel = [&graphics, &Proportion](Rectangle <float> meter, float rms, float peak)
+        {
+            meter = meter.reduced(2.0f, 0.0f);
+
+            graphics.setColour(Colours::limegreen);
+            graphics.fillRect(meter.withTop(meter.getBottom() - meter.getHeight() * Proportion(rms)));
+
+            graphics.setColour(Colours::white);
+            graphics.fillRect(meter.withTop(meter.getBottom() - meter.getHeight() * Proportion(peak)).withHeight(1.5f));
+        };
+
+        DrawLevel(inputMeter, level.inputRms, level.inputPeak);
+        DrawLevel(outputMeter, level.outputRms, level.outputPeak);
+
+        // Gain reduction hangs from the top.
+
+        auto inner = reductionMeter.reduced(2.0f, 0.0f);
+        auto reduction = jlimit(0.0f, 1.0f, level.gainReduction / maxGainReduction);
+
+        graphics.setColour(Colours::orange);
+        graphics.fillRect(inner.withHeight(inner.getHeight() * reduction));
+
+        graphics.setColour(Colours::white);
+        graphics.drawFittedText(String(band + 1) + ": " + String(-level.gainReduction, 1) + " dB",
+                                label.toNearestInt(), Justification::centred, 1);
+    }
+}
+
+//==============================================================================================
+
+void EclistarSpectrumView::setSpectrum(const VstSpectrumAnalyzer::Spectrum& newSpectrum)
+{
+    spectrum = newSpectrum;
+
+    UpdatePaths();
+    repaint();
+}
+
+void EclistarSpectrumView::setCrossovers(const array <float, compressor_parameters::maxNumCrossovers>& frequencies,
+                                         size_t numBands)
+{
+    if (frequencies == crossovers && numBands == num_bands)
+        return;
+
+    crossovers = frequencies;
+    num_bands = numBands;
+
+    repaint();
+}
+
+void EclistarSpectrumView::paint(Graphics& graphics)
+{
+    graphics.drawImageAt(grid, 0, 0);
+
+    // Bands: every other one is shaded, the crossovers are lines.
+
+    auto bounds = getLocalBounds().toFloat();
+    auto left = bounds.getX();
+
+    for (size_t band = 0; band < num_bands; ++band)
+    {
+        auto right = band + 1 < num_bands ? XOfFrequency(crossovers[band]) : bounds.getRight();
+
+        if (band % 2 == 1)
+        {
+            graphics.setColour(Colours::white.withAlpha(0.05f));
+            graphics.fillRect(bounds.withLeft(left).withRight(right));
+        }
+
+        if (band + 1 < num_bands)
+        {
+            graphics.setColour(Colours::orange.withAlpha(0.8f));
+            graphics.fillRect(bounds.withLeft(right - 0.5f).withWidth(1.0f));
+        }
+
+        left = right;
+    }
+
+    graphics.setColour(Colours::limegreen.withAlpha(0.35f));
+    graphics.fillPath(input_area);
+
+    graphics.setColour(Colours::white);
+    graphics.fillPath(output_line);
+}
+
+void EclistarSpectrumView::resized()
+{
+    UpdateGrid();
+    UpdatePaths();
+}
+
+float EclistarSpectrumView::XOfFrequency(float frequency) const
+{
+    using Analyzer = VstSpectrumAnalyzer;
+
+    auto proportion = std::log(jlimit(Analyzer::minFrequency, Analyzer::maxFrequency, frequency) / Analyzer::minFrequency)
+                    / std::log(Analyzer::maxFrequency / Analyzer::minFrequency);
+
+    return (float)getWidth() * proportion;
+}
+
+float EclistarSpectrumView::YOfDecibels(float decibels) const
+{
+    auto proportion = jlimit(0.0f, 1.0f, decibels / VstSpectrumAnalyzer::minDecibels);
+
+    return (float)getHeight() * proportion;
+}
+
+void EclistarSpectrumView::UpdateGrid()
+{
+    if (getWidth() <= 0 || getHeight() <= 0)
+    {
+        grid = Image();
+        return;
+    }
+
+    grid = Image(Image::ARGB, getWidth(), getHeight(), true);
+
+    Graphics graphics(grid);
+
+    graphics.setColour(Colours::black.withAlpha(0.4f));
+    graphics.fillAll();
+
+    graphics.setFont(11.0f);
+
+    for (auto decibels = -12.0f; decibels > VstSpectrumAnalyzer::minDecibels; decibels -= 12.0f)
+    {
+        auto y = YOfDecibels(decibels);
+
+        graphics.setColour(Colours::white.withAlpha(0.1f));
+        graphics.fillRect(0.0f, y, (float)getWidth(), 1.0f);
+
+        graphics.setColour(Colours::white.withAlpha(0.5f));
+        graphics.drawText(String((int)decibels), 2, (int)y - 12, 40, 12, Justification::left);
+    }
+
+    for (auto frequency : { 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f, 10000.0f })
+    {
+        auto x = XOfFrequency(frequency);
+
+        graphics.setColour(Colours::white.withAlpha(0.1f));
+        graphics.fillRect(x, 0.0f, 1.0f, (float)getHeight());
+
+        graphics.setColour(Colours::white.withAlpha(0.5f));
+        graphics.drawText(frequency >= 1000.0f ? String((int)(frequency / 1000.0f)) + "k" : String((int)frequency),
+                          (int)x + 2, getHeight() - 14, 40, 12, Justification::left);
+    }
+}
+
+void EclistarSpectrumView::UpdatePaths()
+{
+    input_area.clear();
+    output_line.clear();
+
+    if (getWidth() <= 0 || getHeight() <= 0)
+        return;
+
+    const auto& input = spectrum.levels[VstSpectrumAnalyzer::inputTap];
+    const auto& output = spectrum.levels[VstSpectrumAnalyzer::outputTap];
+
+    Path outputPath;
+
+    input_area.startNewSubPath(0.0f, (float)getHeight());
+
+    for (size_t point = 0; point < VstSpectrumAnalyzer::numPoints; ++point)
+    {
+        auto x = XOfFrequency(VstSpectrumAnalyzer::getFrequency(point));
+
+        input_area.lineTo(x, YOfDecibels(input[point]));
+
+        if (point == 0)
+            outputPath.startNewSubPath(x, YOfDecibels(output[point]));
+        else
+            outputPath.lineTo(x, YOfDecibels(output[point]));
+    }
+
+    input_area.lineTo((float)getWidth(), (float)getHeight());
+    input_area.closeSubPath();
+
+    // The line is stroked here once, so that paint only fills it.
+
+    PathStrokeType(1.5f).createStrokedPath(output_line, outputPath);
+}
@@ -1,28 +1,98 @@
-#pragma once
-
-#include <JuceHeader.h>
-#include "PluginProcessor.h"
-
-using namespace juce;
-
-//==============================================================================================
-// Class of compressor's editor
-
-class EclistarVSTAudioProcessorEditor : public AudioProcessorEditor
-{
-public:
-
-    EclistarVSTAudioProcessorEditor(EclistarVSTAudioProcessor&);
-    ~EclistarVSTAudioProcessorEditor() override;
-
-//==============================================================================================
-
-    void paint(Graphics&) override;
-    void resized() override;
-
-private:
-
-    EclistarVSTAudioProcessor& audio_processor;
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EclistarVSTAudioProcessorEditor)
-};
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+using namespace juce;
+
+//==============================================================================================
+// Meters of the bands: input and output level (RMS bar, peak line, -60 ... 0 dB) and gain
+// reduction (0 ... 24 dB, from the top). Between two frames of the metering bus they fall back.
+
+class EclistarBandMeters : public Component
+{
+public:
+
+    void setLevels(const VstMeteringBus::Levels& levels, size_t numBands);
+    void fallBack();
+
+    void paint(Graphics&) override;
+
+private:
+
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float maxGainReduction = 24.0f;
+    static constexpr float fallDecibels = 0.75f;
+
+    VstMeteringBus::Levels levels{};
+    size_t num_bands{ compressor_parameters::defaultNumBands };
+};
+
+//==============================================================================================
+// Spectra of the input (filled) and the output (line) over the bands, -96 ... 0 dB from 20 Hz
+// to 20 kHz. The grid is drawn once into an image when the size changes, and the paths are
+// built only when a new spectrum arrives, so a repaint is one image and two filled paths.
+
+class EclistarSpectrumView : public Component
+{
+public:
+
+    void setSpectrum(const VstSpectrumAnalyzer::Spectrum& spectrum);
+    void setCrossovers(const array <float, compressor_parameters::maxNumCrossovers>& frequencies, size_t numBands);
+
+    void paint(Graphics&) override;
+    void resized() override;
+
+private:
+
+    float XOfFrequency(float frequency) const;
+    float YOfDecibels(float decibels) const;
+
+    void UpdateGrid();
+    void UpdatePaths();
+
+    Image grid;
+
+    VstSpectrumAnalyzer::Spectrum spectrum;
+    Path input_area;
+    Path output_line;
+
+    array <float, compressor_parameters::maxNumCrossovers> crossovers{};
+    size_t num_bands{ 0 };
+};
+
+//==============================================================================================
+// Class of compressor's editor
+
+class EclistarVSTAudioProcessorEditor : public AudioProcessorEditor, private Timer
+{
+public:
+
+    EclistarVSTAudioProcessorEditor(EclistarVSTAudioProcessor&);
+    ~EclistarVSTAudioProcessorEditor() override;
+
+//==============================================================================================
+
+    void paint(Graphics&) override;
+    void resized() override;
+
+private:
+
+    // The meters, the spectra and the trace report are read from the processor on the timer.
+
+    static constexpr int refreshRateHz = 60;
+    static constexpr int metersHeight = 160;
+    static constexpr int spectrumHeight = 220;
+    static constexpr int traceHeight = 24;
+
+    void timerCallback() override;
+
+    EclistarVSTAudioProcessor& audio_processor;
+
+    EclistarBandMeters band_meters;
+    EclistarSpectrumView spectrum_view;
+    Label trace_label;
+    GenericAudioProcessorEditor parameters_editor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EclistarVSTAudioProcessorEditor)
+};
@@ -1,572 +1,1710 @@
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-using namespace compressor_parameters;
-
-//==============================================================================================
-// The main system elements of the compressor.
-
-EclistarVSTAudioProcessor::EclistarVSTAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-    : AudioProcessor(BusesProperties()
-#if ! JucePlugin_IsMidiEffect
-#if ! JucePlugin_IsSynth
-        .withInput("Input", AudioChannelSet::stereo(), true)
-#endif
-        .withOutput("Output", AudioChannelSet::stereo(), true)
-#endif
-    )
-#endif
-{
-    //---------------------------------------------------------------------
-    // Next, parameter casting is implemented using simplified lambda functions.
-
-    const auto& parameters = GetParameters();
-
-    // Choice cast.
-
-    auto ChoiceCastHelper = [&apvts = this->apvts, &parameters](auto& parameter, 
-                                                                const auto& parameterName)
-    {
-        parameter = dynamic_cast <AudioParameterChoice*> (apvts.getParameter
-                                                         (parameters.at(parameterName)));
-        jassert(parameter != nullptr);
-    };
-
-    // Float cast.
-
-    auto FloatCastHelper = [&apvts = this->apvts, &parameters](auto& parameter,
-                                                               const auto& parameterName)
-    {
-        parameter = dynamic_cast <AudioParameterFloat*> (apvts.getParameter
-                                                        (parameters.at(parameterName)));
-        jassert(parameter != nullptr);
-    };
-
-    // Bool cast.
-
-    auto BoolCastHelper = [&apvts = this->apvts, &parameters](auto& parameter,
-                                                              const auto& parameterName)
-    {
-        parameter = dynamic_cast <AudioParameterBool*> (apvts.getParameter
-                                                       (parameters.at(parameterName)));
-        jassert(parameter != nullptr);
-    };
-
-    //---------------------------------------------------------------------
-    // Application of lambda functions:
-
-    // Gain;
-
-    FloatCastHelper(_inputGain, NamesOfParameters::gainInput);
-    FloatCastHelper(_outputGain, NamesOfParameters::gainOutput);
-
-    // Low compressor;
-
-    ChoiceCastHelper(_lowCompressor.ratio, NamesOfParameters::ratioLowBand);
-
-    FloatCastHelper(_lowCompressor.attack, NamesOfParameters::attackLowBand);
-    FloatCastHelper(_lowCompressor.release, NamesOfParameters::releaseLowBand);
-    FloatCastHelper(_lowCompressor.threshold, NamesOfParameters::thresholdLowBand);
-
-    BoolCastHelper(_lowCompressor.solo, NamesOfParameters::soloLowBand);
-    BoolCastHelper(_lowCompressor.mute, NamesOfParameters::muteLowBand);
-    BoolCastHelper(_lowCompressor.bypassed, NamesOfParameters::bypassedLowBand);
-
-    // Middle compressor;
-
-    ChoiceCastHelper(_midCompressor.ratio, NamesOfParameters::ratioMidBand);
-
-    FloatCastHelper(_midCompressor.attack, NamesOfParameters::attackMidBand);
-    FloatCastHelper(_midCompressor.release, NamesOfParameters::releaseMidBand);
-    FloatCastHelper(_midCompressor.threshold, NamesOfParameters::thresholdMidBand);
-
-    BoolCastHelper(_midCompressor.solo, NamesOfParameters::soloMidBand);
-    BoolCastHelper(_midCompressor.mute, NamesOfParameters::muteMidBand);
-    BoolCastHelper(_midCompressor.bypassed, NamesOfParameters::bypassedMidBand);
-
-    // High Compressor;
-
-    ChoiceCastHelper(_highCompressor.ratio, NamesOfParameters::ratioHighBand);
-
-    FloatCastHelper(_highCompressor.attack, NamesOfParameters::attackHighBand);
-    FloatCastHelper(_highCompressor.release, NamesOfParameters::releaseHighBand);
-    FloatCastHelper(_highCompressor.threshold, NamesOfParameters::thresholdHighBand);
-
-    BoolCastHelper(_highCompressor.solo, NamesOfParameters::soloHighBand);
-    BoolCastHelper(_highCompressor.mute, NamesOfParameters::muteHighBand);
-    BoolCastHelper(_highCompressor.bypassed, NamesOfParameters::bypassedHighBand);
-
-    // Crossovers.
-
-    FloatCastHelper(_lowMidCrossover, NamesOfParameters::lowMidCrossoverFreq);
-    FloatCastHelper(_midHighCrossover, NamesOfParameters::midHighCrossoverFreq);
-
-    // Determining filters parameters.
-
-    _lowPass1.setType(LinkwitzRileyFilterType::lowpass);
-    _highPass1.setType(LinkwitzRileyFilterType::highpass);
-
-    _lowPass2.setType(LinkwitzRileyFilterType::lowpass);
-    _highPass2.setType(LinkwitzRileyFilterType::highpass);
-
-    _allPass2.setType(LinkwitzRileyFilterType::allpass);
-}
-
-EclistarVSTAudioProcessor::~EclistarVSTAudioProcessor()
-{
-    // nothing.
-}
-
-//==============================================================================================
-// This block contains system functions that currently do not contain
-// and do not require to contain anything.
-
-bool EclistarVSTAudioProcessor::acceptsMidi() const
-{
-#if JucePlugin_WantsMidiInput
-    return true;
-#else
-    return false;
-#endif
-}
-
-bool EclistarVSTAudioProcessor::producesMidi() const
-{
-#if JucePlugin_ProducesMidiOutput
-    return true;
-#else
-    return false;
-#endif
-}
-
-bool EclistarVSTAudioProcessor::isMidiEffect() const
-{
-#if JucePlugin_IsMidiEffect
-    return true;
-#else
-    return false;
-#endif
-}
-
-double EclistarVSTAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int EclistarVSTAudioProcessor::getNumPrograms()
-{
-    return 1;
-}
-
-int EclistarVSTAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-const String EclistarVSTAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-const String EclistarVSTAudioProcessor::getProgramName(int index)
-{
-    return {};
-}
-
-void EclistarVSTAudioProcessor::setCurrentProgram(int index)
-{
-    // nothing.
-}
-
-void EclistarVSTAudioProcessor::changeProgramName(int index, const String& newName)
-{
-    // nothing.
-}
-
-//==============================================================================================
-// Next are the functions responsible for the preparation and processing of sound.
-
-void EclistarVSTAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
-{
-    // Specification of the "music" processor
-    // Preparation for processing a musical fragment (sample).
-
-    ProcessSpec processSpec;
-
-    processSpec.maximumBlockSize = samplesPerBlock;
-    processSpec.numChannels = getTotalNumOutputChannels();
-    processSpec.sampleRate = sampleRate;
-
-    // Preparing several compressors.
-
-    for (auto& compressor : _compressors)
-    {
-        compressor.prepare(processSpec);
-    }
-
-    // Preparing levels of compressor.
-
-    _lowPass1.prepare(processSpec);
-    _highPass1.prepare(processSpec);
-
-    _lowPass2.prepare(processSpec);
-    _highPass2.prepare(processSpec);
-
-    _allPass2.prepare(processSpec);
-
-    // Preparing gain.
-
-    _inGain.prepare(processSpec);
-    _outGain.prepare(processSpec);
-
-    _inGain.setRampDurationSeconds(0.05);
-    _outGain.setRampDurationSeconds(0.05);
-
-    // Setting the size of buffers for transmitting sounds.
-
-    for (auto& buffer : _multiFilterBuffers)
-    {
-        buffer.setSize(processSpec.numChannels, samplesPerBlock);
-    }
-}
-
-void EclistarVSTAudioProcessor::releaseResources()
-{
-    // nothing.
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool EclistarVSTAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
-{
-#if JucePlugin_IsMidiEffect
-    ignoreUnused(layouts);
-    return true;
-#else
-
-    if (layouts.getMainOutputChannelSet() != AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != AudioChannelSet::stereo())
-        return false;
-
-#if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-#endif
-
-    return true;
-#endif
-}
-#endif
-
-void EclistarVSTAudioProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
-{
-    //---------------------------------------------------------------------
-    // Operational scope.
-
-    ScopedNoDenormals noDenormals;
-
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    // Clearing the old channel.
-
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
-
-    // Update the parameters of all compressors.
-
-    for (auto& compressor : _compressors)
-    {
-        compressor.updateVstCompressorSettings();
-    }
-
-    // Set gain parameters.
-
-    _inGain.setGainDecibels(_inputGain->get());
-    _outGain.setGainDecibels(_outputGain->get());
-
-    // In gain used before applying filters.
-
-    ApplyGain(buffer, _inGain);
-
-    // Set the buffer size.
-
-    for (auto& filterBuffer : _multiFilterBuffers)
-    {
-        filterBuffer = buffer;
-    }
-
-    // Audio cutoff for channels.
-
-    auto lowMidCutoff = _lowMidCrossover->get();
-    auto midHighCutoff = _midHighCrossover->get();
-
-    _lowPass1.setCutoffFrequency(lowMidCutoff);
-    _highPass1.setCutoffFrequency(lowMidCutoff);
-
-    _lowPass2.setCutoffFrequency(midHighCutoff);
-    _highPass2.setCutoffFrequency(midHighCutoff);
-
-    _allPass2.setCutoffFrequency(midHighCutoff);
-
-    // Creating a buffer for samples, allocating static memory.
-
-    auto filterBuf0Block = AudioBlock <float>(_multiFilterBuffers[0]);
-    auto filterBuf1Block = AudioBlock <float>(_multiFilterBuffers[1]);
-    auto filterBuf2Block = AudioBlock <float>(_multiFilterBuffers[2]);
-
-    // ProcessContextReplacing contains contextual information
-    // that is passed to the processing method of the algorithm.
-
-    auto filterBuf0Context = ProcessContextReplacing <float>(filterBuf0Block);
-    auto filterBuf1Context = ProcessContextReplacing <float>(filterBuf1Block);
-    auto filterBuf2Context = ProcessContextReplacing <float>(filterBuf2Block);
-
-    // Processing levels.
-
-    _lowPass1.process(filterBuf0Context);
-    _allPass2.process(filterBuf0Context);
-
-    _highPass1.process(filterBuf1Context);
-    _multiFilterBuffers[2] = _multiFilterBuffers[1];
-
-    _lowPass2.process(filterBuf1Context);
-    _highPass2.process(filterBuf2Context);
-
-    // Determine the size of the data to work with each sub-compressor.
-
-    for (size_t i = 0; i < _multiFilterBuffers.size(); ++i)
-    {
-        _compressors[i].processing(_multiFilterBuffers[i]);
-    }
-
-    auto numSamples = buffer.getNumSamples();
-    auto numChannels = buffer.getNumChannels();
-
-    buffer.clear();
-
-    //---------------------------------------------------------------------
-    // Buffer exchange with DSP, sound processing.
-
-    auto soledBands = false;
-
-    // Lambda function for applying a filter to the sound
-
-    auto AddFilterBand = [numC = numChannels, numS = numSamples](auto& inputBuffer,
-        const auto& source)
-    {
-        for (auto i = 0; i < numC; ++i)
-        {
-            inputBuffer.addFrom(i, 0, source, i, 0, numS);
-        }
-    };
-
-    // Checking for superimposed effects : solo.
-
-    for (auto& compressor : _compressors)
-    {
-        if (compressor.solo->get())
-        {
-            soledBands = true;
-            break;
-        }
-    }
-
-    // If there is an imposed effect, we proceed from
-    // other states of the compressor elements.
-
-    if (soledBands)
-    {
-        for (size_t i = 0; i < _compressors.size(); ++i)
-        {
-            auto& compressor = _compressors[i];
-            if (compressor.solo->get())
-            {
-                AddFilterBand(buffer, _multiFilterBuffers[i]);
-            }
-        }
-    }
-    else
-    {
-        for (size_t i = 0; i < _compressors.size(); ++i)
-        {
-            auto& compressor = _compressors[i];
-            if (!compressor.mute->get())
-            {
-                AddFilterBand(buffer, _multiFilterBuffers[i]);
-            }
-        }
-    }
-
-    // Output gain used after applying filters.
-
-    ApplyGain(buffer, _outGain);
-}
-
-//==============================================================================================
-// Functions of editor.
-
-bool EclistarVSTAudioProcessor::hasEditor() const
-{
-    return true;
-}
-
-AudioProcessorEditor* EclistarVSTAudioProcessor::createEditor()
-{
-
-    //return new EclistarVSTAudioProcessorEditor(*this);
-    return new GenericAudioProcessorEditor(*this);
-}
-
-//==============================================================================================
-// Data state status.
-
-void EclistarVSTAudioProcessor::getStateInformation(MemoryBlock& destinationData)
-{
-    // The sound went to the right place.
-
-    MemoryOutputStream memOutStream(destinationData, true);
-    apvts.state.writeToStream(memOutStream);
-}
-
-void EclistarVSTAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
-{
-    // A universal structure for storing and interacting data with each other.
-
-    auto valueTree = ValueTree::readFromData(data, sizeInBytes);
-    if (valueTree.isValid())
-    {
-        apvts.replaceState(valueTree);
-    }
-}
-
-//==============================================================================================
-// Layout, application appearance.
-
-AudioProcessorValueTreeState::ParameterLayout
-EclistarVSTAudioProcessor::createParameterLayout()
-{
-    auto attackRange = NormalisableRange <float>(5, 500, 1, 1);
-    auto gainRange = NormalisableRange <float>(-24.f, 24.f, 0.5f, 1.f);
-
-    auto choicesValues = vector <double>{ 1,1.5,2,3,4,5,7,9,10,15,20,50,100 };
-    StringArray strArray;
-    for (auto choice : choicesValues)
-    {
-        strArray.add(String(choice, 1));
-    }
-
-    APVTS::ParameterLayout layout;
-    const auto& parameters = GetParameters();
-
-    // Testing sliders:
-
-    // Gain;
-
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::gainInput),
-        parameters.at(NamesOfParameters::gainInput),
-        gainRange, 0));
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::gainOutput),
-        parameters.at(NamesOfParameters::gainOutput),
-        gainRange, 0));
-
-    // Low compressor;
-
-    layout.add(make_unique<AudioParameterChoice>(parameters.at(NamesOfParameters::ratioLowBand),
-        parameters.at(NamesOfParameters::ratioLowBand),
-        strArray, 3));
-
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::thresholdLowBand),
-        parameters.at(NamesOfParameters::thresholdLowBand),
-        NormalisableRange<float>(-60, 12, 1, 1), 0));
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::attackLowBand),
-        parameters.at(NamesOfParameters::attackLowBand),
-        attackRange, 0));
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::releaseLowBand),
-        parameters.at(NamesOfParameters::releaseLowBand),
-        attackRange, 250));
-
-    layout.add(make_unique<AudioParameterBool>(parameters.at(NamesOfParameters::soloLowBand),
-        parameters.at(NamesOfParameters::soloLowBand),
-        false));
-    layout.add(make_unique<AudioParameterBool>(parameters.at(NamesOfParameters::muteLowBand),
-        parameters.at(NamesOfParameters::muteLowBand),
-        false));
-    layout.add(make_unique<AudioParameterBool>(parameters.at(NamesOfParameters::bypassedLowBand),
-        parameters.at(NamesOfParameters::bypassedLowBand),
-        false));
-
-    // Middle compressor;
-
-    layout.add(make_unique<AudioParameterChoice>(parameters.at(NamesOfParameters::ratioMidBand),
-        parameters.at(NamesOfParameters::ratioMidBand),
-        strArray, 3));
-
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::thresholdMidBand),
-        parameters.at(NamesOfParameters::thresholdMidBand),
-        NormalisableRange<float>(-60, 12, 1, 1), 0));
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::attackMidBand),
-        parameters.at(NamesOfParameters::attackMidBand),
-        attackRange, 0));
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::releaseMidBand),
-        parameters.at(NamesOfParameters::releaseMidBand),
-        attackRange, 250));
-
-    layout.add(make_unique<AudioParameterBool>(parameters.at(NamesOfParameters::soloMidBand),
-        parameters.at(NamesOfParameters::soloMidBand),
-        false));
-    layout.add(make_unique<AudioParameterBool>(parameters.at(NamesOfParameters::muteMidBand),
-        parameters.at(NamesOfParameters::muteMidBand),
-        false));
-    layout.add(make_unique<AudioParameterBool>(parameters.at(NamesOfParameters::bypassedMidBand),
-        parameters.at(NamesOfParameters::bypassedMidBand),
-        false));
-
-    // High compressor;
-
-    layout.add(make_unique<AudioParameterChoice>(parameters.at(NamesOfParameters::ratioHighBand),
-        parameters.at(NamesOfParameters::ratioHighBand),
-        strArray, 3));
-
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::thresholdHighBand),
-        parameters.at(NamesOfParameters::thresholdHighBand),
-        NormalisableRange<float>(-60, 12, 1, 1), 0));
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::attackHighBand),
-        parameters.at(NamesOfParameters::attackHighBand),
-        attackRange, 0));
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::releaseHighBand),
-        parameters.at(NamesOfParameters::releaseHighBand),
-        attackRange, 250));
-
-    layout.add(make_unique<AudioParameterBool>(parameters.at(NamesOfParameters::soloHighBand),
-        parameters.at(NamesOfParameters::soloHighBand),
-        false));
-    layout.add(make_unique<AudioParameterBool>(parameters.at(NamesOfParameters::muteHighBand),
-        parameters.at(NamesOfParameters::muteHighBand),
-        false));
-    layout.add(make_unique<AudioParameterBool>(parameters.at(NamesOfParameters::bypassedHighBand),
-        parameters.at(NamesOfParameters::bypassedHighBand),
-        false));
-
-    // Crossovers.
-
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::lowMidCrossoverFreq),
-        parameters.at(NamesOfParameters::lowMidCrossoverFreq),
-        NormalisableRange<float>(20, 999, 1, 1), 400));
-
-    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::midHighCrossoverFreq),
-        parameters.at(NamesOfParameters::midHighCrossoverFreq),
-        NormalisableRange<float>(1000, 20000, 1, 1), 2000));
-
-
-    return layout;
-}
-
-//==============================================================================================
-// Creating plugin.
-
-AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new EclistarVSTAudioProcessor();
-}
-
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+#include "AllocationTrap.h"
+
+using namespace compressor_parameters;
+
+//==============================================================================================
+// The main system elements of the compressor.
+
+EclistarVSTAudioProcessor::EclistarVSTAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+    : AudioProcessor(BusesProperties()
+#if ! JucePlugin_IsMidiEffect
+#if ! JucePlugin_IsSynth
+        .withInput("Input", AudioChannelSet::stereo(), true)
+        .withInput("Sidechain", AudioChannelSet::stereo(), false)
+#endif
+        .withOutput("Output", AudioChannelSet::stereo(), true)
+#endif
+    )
+#endif
+{
+    // Parameters reach the audio thread through _parameters (ParameterSnapshot),
+    // every band knows its own ones.
+
+    for (size_t i = 0; i < _compressors.size(); ++i)
+    {
+        _compressors[i] = VstCompressorBand::forBand(i);
+    }
+
+    // Tracing of all instances into a directory (for sessions in a host), one file each.
+
+    auto traceDirectory = SystemStats::getEnvironmentVariable("ECLISTAR_TRACE", {});
+
+    if (traceDirectory.isNotEmpty() && File::isAbsolutePath(traceDirectory))
+    {
+        static atomic <int> instanceCount{ 0 };
+
+        auto name = "eclistar-trace-" + String(Time::currentTimeMillis()) + "-" + String(++instanceCount) + ".json";
+
+        setTracingEnabled(true, File(traceDirectory).getChildFile(name));
+    }
+
+    // The latency of a switch of the topology is reported from the message thread.
+
+    startTimerHz(latencyTimerHz);
+}
+
+EclistarVSTAudioProcessor::~EclistarVSTAudioProcessor()
+{
+    stopTimer();
+}
+
+//==============================================================================================
+// This block contains system functions that currently do not contain
+// and do not require to contain anything.
+
+bool EclistarVSTAudioProcessor::acceptsMidi() const
+{
+#if JucePlugin_WantsMidiInput
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool EclistarVSTAudioProcessor::producesMidi() const
+{
+#if JucePlugin_ProducesMidiOutput
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool EclistarVSTAudioProcessor::isMidiEffect() const
+{
+#if JucePlugin_IsMidiEffect
+    return true;
+#else
+    return false;
+#endif
+}
+
+double EclistarVSTAudioProcessor::getTailLengthSeconds() const
+{
+    return _tailSeconds.load(memory_order_relaxed);
+}
+
+int EclistarVSTAudioProcessor::getNumPrograms()
+{
+    return 1;
+}
+
+int EclistarVSTAudioProcessor::getCurrentProgram()
+{
+    return 0;
+}
+
+const String EclistarVSTAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+const String EclistarVSTAudioProcessor::getProgramName(int index)
+{
+    return {};
+}
+
+void EclistarVSTAudioProcessor::setCurrentProgram(int index)
+{
+    // nothing.
+}
+
+void EclistarVSTAudioProcessor::changeProgramName(int index, const String& newName)
+{
+    // nothing.
+}
+
+//==============================================================================================
+// Next are the functions responsible for the preparation and processing of sound.
+
+void EclistarVSTAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    // Specification of the "music" processor
+    // Preparation for processing a musical fragment (sample).
+
+    ProcessSpec processSpec;
+
+    processSpec.maximumBlockSize = samplesPerBlock;
+    processSpec.numChannels = getTotalNumOutputChannels();
+    processSpec.sampleRate = sampleRate;
+
+    // The command line tools call prepareToPlay without a host, the rate is kept for them.
+
+    setRateAndBufferSizeDetails(sampleRate, samplesPerBlock);
+
+    // Only the chain of the processing precision is prepared, the other one is released.
+
+    if (isUsingDoublePrecision())
+    {
+        PrepareChain(_doubleChain, processSpec);
+        ReleaseChain(_floatChain);
+    }
+    else
+    {
+        PrepareChain(_floatChain, processSpec);
+        ReleaseChain(_doubleChain);
+    }
+
+    _meteringBus.prepare(sampleRate);
+    _spectrumAnalyzer.prepare(sampleRate);
+    _blockTracer.prepare(sampleRate);
+
+    // Workers of the parallel processing (none while it is off).
+
+    _workerPool.start(_parallelProcessing.load(memory_order_relaxed)
+                      ? (size_t)_parallelWorkers.load(memory_order_relaxed) : 0);
+
+    // Smoothing of the automation starts from the current values, without ramps.
+
+    _parameters.update();
+
+    const auto& values = _parameters.get();
+
+    for (size_t i = 0; i < _cutoffs.size(); ++i)
+    {
+        _cutoffs[i].reset(sampleRate, smoothingSeconds);
+        _cutoffs[i].setCurrentAndTargetValue(values[crossoverFreq(i)]);
+    }
+
+    for (auto& compressor : _compressors)
+    {
+        compressor.resetSmoothing(sampleRate, smoothingSeconds, values);
+    }
+
+    SetLinearPhase(values.isOn(linearPhase));
+    SetNumBands(NumBandsOf(values));
+    SetOversampling(OversamplingOf(values), OversamplingQualityOf(values));
+
+    // The kernels of the linear-phase split are built now, so the first block has them.
+
+    if (_linearPhase)
+    {
+        ForChain([](auto& chain) { chain.linearCrossover.buildKernels(); });
+    }
+
+    // The host learns the latency before the first block (later switches by the timer).
+
+    setLatencySamples(_latencySamples.load(memory_order_relaxed));
+
+    // Bands start at their current level, the DSP starts computed.
+
+    auto audibleBands = GetAudibleBands();
+
+    for (size_t i = 0; i < _bandLevels.size(); ++i)
+    {
+        _bandLevels[i].reset(sampleRate, fadeSeconds);
+        _bandLevels[i].setCurrentAndTargetValue((audibleBands & (1u << i)) != 0 ? 1.0f : 0.0f);
+    }
+
+    _wetLevel.reset(sampleRate, fadeSeconds);
+    _wetLevel.setCurrentAndTargetValue(1.0f);
+
+    PlanBands(audibleBands);
+
+    // The new DSP objects get the current values of all parameters.
+
+    _parameters.markAllChanged();
+
+    _tailSeconds.store(TailSeconds(values), memory_order_relaxed);
+    _silentSamples = 0;
+    _isSleeping.store(false, memory_order_relaxed);
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::PrepareChain(VstDspChain <SampleType>& chain, const ProcessSpec& processSpec)
+{
+    auto numBandChannels = processSpec.numChannels * (uint32)maxNumBands;
+    auto samplesPerBlock = (int)processSpec.maximumBlockSize;
+
+    // Preparing several compressors.
+
+    chain.bandCompressor.prepare(processSpec);
+
+    // Preparing levels of compressor (the lanes after the channels are for the sidechain).
+
+    chain.crossover.prepare({ processSpec.sampleRate, processSpec.maximumBlockSize, processSpec.numChannels * 2 });
+    chain.linearCrossover.prepare({ processSpec.sampleRate, processSpec.maximumBlockSize, processSpec.numChannels * 2 });
+
+    // Preparing the oversampling of all bands.
+
+    chain.oversampler.prepare({ processSpec.sampleRate, processSpec.maximumBlockSize, numBandChannels });
+
+    // Preparing the lookahead for the largest delay (at the highest oversampled rate).
+
+    chain.lookahead.prepare({ processSpec.sampleRate * (double)VstOversamplerBase::maxFactor,
+                              processSpec.maximumBlockSize, numBandChannels });
+
+    chain.sidechainLookahead.prepare({ processSpec.sampleRate, processSpec.maximumBlockSize, numBandChannels });
+
+    // Preparing gain.
+
+    chain.inGain.prepare(processSpec);
+    chain.outGain.prepare(processSpec);
+
+    chain.inGain.setRampDurationSeconds(0.05);
+    chain.outGain.setRampDurationSeconds(0.05);
+
+    // Setting the size of buffers for transmitting sounds.
+
+    chain.bandBuffer.setSize((int)numBandChannels, samplesPerBlock);
+    chain.dryBuffer.setSize((int)processSpec.numChannels, samplesPerBlock);
+    chain.keyBuffer.setSize((int)numBandChannels, samplesPerBlock * (int)VstOversamplerBase::maxFactor);
+
+    chain.sidechainBuffer.setSize((int)numBandChannels, samplesPerBlock);
+    chain.sidechainKeyBuffer.setSize((int)numBandChannels, samplesPerBlock * (int)VstOversamplerBase::maxFactor);
+
+    // The oversampler filters the bands that are not computed as well, they must not hold garbage.
+
+    chain.bandBuffer.clear();
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::ReleaseChain(VstDspChain <SampleType>& chain)
+{
+    chain.bandBuffer.setSize(0, 0);
+    chain.dryBuffer.setSize(0, 0);
+    chain.keyBuffer.setSize(0, 0);
+    chain.sidechainBuffer.setSize(0, 0);
+    chain.sidechainKeyBuffer.setSize(0, 0);
+
+    chain.linearCrossover.release();
+}
+
+void EclistarVSTAudioProcessor::releaseResources()
+{
+    // The workers are started again by prepareToPlay.
+
+    _workerPool.stop();
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool EclistarVSTAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+#if JucePlugin_IsMidiEffect
+    ignoreUnused(layouts);
+    return true;
+#else
+
+    auto numChannels = layouts.getMainOutputChannelSet().size();
+
+    if (numChannels < 1 || numChannels > maxNumChannels)
+        return false;
+
+#if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+
+    // The sidechain is off, mono, or has the channels of the input.
+
+    auto sidechain = layouts.getChannelSet(true, 1);
+
+    if (!sidechain.isDisabled() && sidechain.size() != 1 && sidechain != layouts.getMainInputChannelSet())
+        return false;
+#endif
+
+    return true;
+#endif
+}
+#endif
+
+void EclistarVSTAudioProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
+{
+    ignoreUnused(midiMessages);
+
+    jassert(!isUsingDoublePrecision());
+
+    _spectrumAnalyzer.push(VstSpectrumAnalyzer::inputTap, buffer);
+    TraceBlock(buffer);
+    _spectrumAnalyzer.push(VstSpectrumAnalyzer::outputTap, buffer);
+}
+
+void EclistarVSTAudioProcessor::processBlock(AudioBuffer<double>& buffer, MidiBuffer& midiMessages)
+{
+    ignoreUnused(midiMessages);
+
+    jassert(isUsingDoublePrecision());
+
+    _spectrumAnalyzer.push(VstSpectrumAnalyzer::inputTap, buffer);
+    TraceBlock(buffer);
+    _spectrumAnalyzer.push(VstSpectrumAnalyzer::outputTap, buffer);
+}
+
+// The only cost of the tracing while it is off is the branch on its flag.
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::TraceBlock(AudioBuffer <SampleType>& buffer)
+{
+    if (_blockTracer.isEnabled())
+    {
+        auto startTicks = Time::getHighResolutionTicks();
+
+        ProcessBlock(buffer);
+
+        _blockTracer.add(startTicks, buffer.getNumSamples(), TraceModes());
+    }
+    else
+    {
+        ProcessBlock(buffer);
+    }
+}
+
+bool EclistarVSTAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::ProcessBlock(AudioBuffer <SampleType>& buffer)
+{
+    //---------------------------------------------------------------------
+    // Operational scope.
+
+    ScopedNoDenormals noDenormals;
+
+    // In debug builds any heap allocation below this point stops in the debugger.
+
+    allocation_trap::ScopedAudioThreadTrap allocationTrap;
+
+    auto totalNumInputChannels = getMainBusNumInputChannels();
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
+
+    // Clearing the old channel.
+
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear(i, 0, buffer.getNumSamples());
+
+    // Update the parameters which have changed since the last block.
+
+    UpdateParameters();
+
+    // A sleeping processor only scans its input for a signal.
+
+    if (UpdateSleep(buffer, totalNumInputChannels))
+    {
+        for (auto i = 0; i < totalNumOutputChannels; ++i)
+            buffer.clear(i, 0, buffer.getNumSamples());
+
+        return;
+    }
+
+    //---------------------------------------------------------------------
+    // Plan of the block.
+
+    // With every band bypassed and heard and both gains at 0 dB the plugin only adds the
+    // phase shift of the crossover, so the input is passed untouched. The switch into and
+    // out of this state is crossfaded; the DSP restarts from silence when it is left.
+
+    auto audibleBands = GetAudibleBands();
+    auto numSamples = (size_t)buffer.getNumSamples();
+
+    _wetLevel.setTargetValue(IsPassthrough(audibleBands) ? 0.0f : 1.0f);
+
+    if (_wetLevel.getTargetValue() == 0.0f && !_wetLevel.isSmoothing())
+    {
+        AdvanceSmoothing((int)numSamples);
+        return;
+    }
+
+    auto& chain = GetChain <SampleType>();
+
+    if (_wetLevel.getCurrentValue() == 0.0f)
+    {
+        chain.reset();
+    }
+
+    // Bands that are not heard (and not fading out) are neither split nor compressed.
+
+    auto activeBands = PlanBands(audibleBands);
+
+    //---------------------------------------------------------------------
+    // Buffer exchange with DSP, sound processing.
+
+    // The band buffers are never resized here: if the host sends more samples
+    // than were announced in prepareToPlay, the block is processed in parts.
+    // The fused engine uses short parts, so that a part passes the whole chain
+    // (gain, crossover, compressors, summation) while it is still in the cache.
+
+    auto audioBlock = AudioBlock <SampleType>(buffer).getSubsetChannelBlock(0, (size_t)totalNumOutputChannels);
+    auto maxPartSize = (size_t)jmax(1, chain.bandBuffer.getNumSamples());
+
+    if (_fusedProcessing.load(memory_order_relaxed))
+    {
+        maxPartSize = jmin(maxPartSize, (size_t)_fusedSubBlockSize.load(memory_order_relaxed));
+    }
+
+    // The sidechain has the channels of the input: a mono one is used for all of them.
+
+    auto sidechainBuffer = getBusCount(true) > 1 ? getBusBuffer(buffer, true, 1) : AudioBuffer <SampleType>();
+    const SampleType* sidechainChannels[maxNumChannels] = {};
+
+    for (auto i = 0; sidechainBuffer.getNumChannels() > 0 && i < totalNumOutputChannels; ++i)
+    {
+        sidechainChannels[i] = sidechainBuffer.getReadPointer(i % sidechainBuffer.getNumChannels());
+    }
+
+    auto sidechainBlock = AudioBlock <const SampleType>(sidechainChannels,
+                                                        sidechainBuffer.getNumChannels() > 0 ? (size_t)totalNumOutputChannels : 0,
+                                                        numSamples);
+
+    // While automation is being smoothed, the block is also split into control periods,
+    // and the coefficients are updated at the start of each of them.
+
+    for (size_t start = 0; start < numSamples;)
+    {
+        auto periodSize = numSamples - start;
+
+        if (IsSmoothing())
+        {
+            periodSize = jmin(periodSize, (size_t)_controlRate.load(memory_order_relaxed));
+            AdvanceSmoothing((int)periodSize);
+        }
+
+        auto end = start + periodSize;
+
+        for (; start < end; start += jmin(maxPartSize, end - start))
+        {
+            auto partSize = jmin(maxPartSize, end - start);
+            auto partBlock = audioBlock.getSubBlock(start, partSize);
+
+            ProcessPart(partBlock, sidechainBlock.getSubBlock(start, partSize), activeBands);
+        }
+    }
+
+    // The states of the crossover are cleaned once per host block,
+    // independently of the size of the parts.
+
+#if JUCE_DSP_ENABLE_SNAP_TO_ZERO
+    chain.crossover.snapToZero();
+#endif
+}
+
+void EclistarVSTAudioProcessor::UpdateParameters()
+{
+    // Coefficients are recomputed only for the parameters that have changed.
+
+    auto changed = _parameters.update();
+
+    if (!changed.any())
+        return;
+
+    const auto& values = _parameters.get();
+
+    if (changed.test(numberOfBands) && NumBandsOf(values) != _numBands)
+    {
+        SetNumBands(NumBandsOf(values));
+    }
+
+    if (changed.test(linearPhase) && values.isOn(linearPhase) != _linearPhase)
+    {
+        SetLinearPhase(values.isOn(linearPhase));
+    }
+
+    auto quality = ForChain([](auto& chain) { return chain.oversampler.getQuality(); });
+
+    if ((changed.test(oversampling) || changed.test(oversamplingQuality))
+        && (OversamplingOf(values) != GetOversamplingFactor() || OversamplingQualityOf(values) != quality))
+    {
+        SetOversampling(OversamplingOf(values), OversamplingQualityOf(values));
+    }
+
+    ParameterSnapshot::Mask lookaheadMask;
+
+    for (const auto& compressor : _compressors)
+    {
+        lookaheadMask |= ParameterSnapshot::maskOf(compressor.lookahead);
+    }
+
+    if (changed.intersects(lookaheadMask))
+    {
+        UpdateLookahead();
+    }
+
+    ForChain([&](auto& chain)
+    {
+        for (size_t i = 0; i < _compressors.size(); ++i)
+        {
+            if (changed.intersects(_compressors[i].getSettingsMask()))
+            {
+                _compressors[i].updateVstCompressorSettings(chain.bandCompressor, i, values);
+            }
+        }
+
+        if (changed.test(gainInput))
+        {
+            chain.inGain.setGainDecibels(values[gainInput]);
+        }
+
+        if (changed.test(gainOutput))
+        {
+            chain.outGain.setGainDecibels(values[gainOutput]);
+        }
+
+        if (changed.test(linkChannels))
+        {
+            chain.bandCompressor.setChannelLink(values.isOn(linkChannels));
+        }
+
+        if (changed.test(knee))
+        {
+            chain.bandCompressor.setKnee(values[knee]);
+        }
+    });
+
+    auto tailMask = ParameterSnapshot::maskOf(numberOfBands) | ParameterSnapshot::maskOf(linearPhase);
+
+    for (size_t i = 0; i < _cutoffs.size(); ++i)
+    {
+        tailMask |= ParameterSnapshot::maskOf(crossoverFreq(i));
+    }
+
+    for (const auto& compressor : _compressors)
+    {
+        tailMask |= ParameterSnapshot::maskOf(compressor.release);
+    }
+
+    if (changed.intersects(tailMask))
+    {
+        _tailSeconds.store(TailSeconds(values), memory_order_relaxed);
+    }
+
+    // Crossovers and thresholds only get new targets here, they reach the DSP
+    // through AdvanceSmoothing.
+
+    for (size_t i = 0; i < _cutoffs.size(); ++i)
+    {
+        _cutoffs[i].setTargetValue(values[crossoverFreq(i)]);
+    }
+}
+
+size_t EclistarVSTAudioProcessor::NumBandsOf(const ParameterSnapshot::Values& values)
+{
+    return (size_t)jlimit((int)minNumBands, (int)maxNumBands, roundToInt(values[numberOfBands]));
+}
+
+void EclistarVSTAudioProcessor::SetNumBands(size_t numBands)
+{
+    _numBands = numBands;
+
+    ForChain([numBands](auto& chain)
+    {
+        chain.crossover.setNumBands(numBands);
+        chain.linearCrossover.setNumBands(numBands);
+        chain.oversampler.reset();
+        chain.lookahead.setNumBands(numBands);
+        chain.sidechainLookahead.setNumBands(numBands);
+        chain.bandCompressor.setNumBands(numBands);
+        chain.bandCompressor.reset();
+    });
+
+    ApplyCutoffs();
+    UpdateLookahead();
+
+    for (auto& level : _bandLevels)
+    {
+        level.setCurrentAndTargetValue(0.0f);
+    }
+}
+
+void EclistarVSTAudioProcessor::SetLinearPhase(bool isLinearPhase)
+{
+    // The bands of the other split are delayed differently: the states restart and the bands
+    // fade in, as for a new number of bands. The kernels are only built while they are used.
+
+    _linearPhase = isLinearPhase;
+
+    ForChain([isLinearPhase](auto& chain)
+    {
+        chain.linearCrossover.setEnabled(isLinearPhase);
+        chain.reset();
+    });
+
+    for (auto& level : _bandLevels)
+    {
+        level.setCurrentAndTargetValue(0.0f);
+    }
+
+    UpdateLatency();
+}
+
+size_t EclistarVSTAudioProcessor::OversamplingOf(const ParameterSnapshot::Values& values)
+{
+    auto index = jlimit(0, (int)oversamplingFactors.size() - 1, roundToInt(values[oversampling]));
+
+    return oversamplingFactors[(size_t)index];
+}
+
+VstOversamplerBase::Quality EclistarVSTAudioProcessor::OversamplingQualityOf(const ParameterSnapshot::Values& values)
+{
+    return (VstOversamplerBase::Quality)jlimit(0, VstOversamplerBase::numQualities - 1, roundToInt(values[oversamplingQuality]));
+}
+
+size_t EclistarVSTAudioProcessor::GetOversamplingFactor() const
+{
+    return ForChain([](const auto& chain) { return chain.oversampler.getFactor(); });
+}
+
+void EclistarVSTAudioProcessor::SetOversampling(size_t factor, VstOversamplerBase::Quality quality)
+{
+    // The envelopes run at the oversampled rate, so their coefficients follow it. The states
+    // restart and the bands fade in, as for a new number of bands.
+
+    ForChain([this, factor, quality](auto& chain)
+    {
+        chain.oversampler.setFactor(factor, quality);
+
+        chain.bandCompressor.setSampleRate(getSampleRate() * (double)factor);
+        chain.bandCompressor.reset();
+    });
+
+    for (auto& level : _bandLevels)
+    {
+        level.setCurrentAndTargetValue(0.0f);
+    }
+
+    UpdateLookahead();
+    UpdateLatency();
+}
+
+void EclistarVSTAudioProcessor::UpdateLookahead()
+{
+    // While a band in use has a lookahead, the audio of all bands is delayed by the longest
+    // lookahead the parameters allow, a whole number of host samples, so the latency stays
+    // exact with oversampling and does not move with the automation: it only moves the windows
+    // of the bands, counted at the rate of the compressors. Without any lookahead there is no
+    // delay and no latency.
+
+    const auto& values = _parameters.get();
+
+    auto sampleRate = getSampleRate();
+    auto factor = GetOversamplingFactor();
+    auto hasLookahead = false;
+
+    for (size_t i = 0; i < _numBands; ++i)
+    {
+        hasLookahead = hasLookahead || values[_compressors[i].lookahead] > 0.0f;
+    }
+
+    auto delay = hasLookahead ? (size_t)(VstLookahead <float>::maxLookaheadSeconds * sampleRate) * factor : 0;
+    auto isNewDelay = false;
+
+    ForChain([&](auto& chain)
+    {
+        // The delay changes when the lookahead is turned on or off, or with the rate of the
+        // compressors: it moves the audio of all bands, the states restart and the bands fade in.
+
+        if (delay != chain.lookahead.getDelay())
+        {
+            chain.lookahead.setDelay(delay);
+            chain.sidechainLookahead.setDelay(delay / factor);
+            chain.bandCompressor.reset();
+
+            for (auto& level : _bandLevels)
+            {
+                level.setCurrentAndTargetValue(0.0f);
+            }
+
+            isNewDelay = true;
+        }
+
+        for (size_t i = 0; i < _numBands; ++i)
+        {
+            auto window = roundToInt(values[_compressors[i].lookahead] * sampleRate * (double)factor / 1000.0);
+
+            chain.lookahead.setBandLookahead(i, jmin(delay, (size_t)jmax(0, window)));
+
+            // The keys of the sidechain are found at the host rate and held at the rate of the compressors.
+
+            auto sidechainWindow = roundToInt(values[_compressors[i].lookahead] * sampleRate / 1000.0);
+
+            chain.sidechainLookahead.setBandLookahead(i, jmin(delay / factor, (size_t)jmax(0, sidechainWindow)));
+        }
+    });
+
+    if (isNewDelay)
+        UpdateLatency();
+}
+
+void EclistarVSTAudioProcessor::UpdateLatency()
+{
+    // Only the topology changes the latency (linear-phase split, oversampling, lookahead on or
+    // off). The audio thread keeps it here and reads it from here; prepareToPlay and the timer on the message thread report it.
+
+    auto latency = ForChain([this](const auto& chain)
+    {
+        auto splitLatency = _linearPhase ? chain.linearCrossover.getLatencySamples() : 0;
+        auto lookaheadLatency = (int)(chain.lookahead.getDelay() / chain.oversampler.getFactor());
+
+        return splitLatency + chain.oversampler.getLatencySamples() + lookaheadLatency;
+    });
+
+    _latencySamples.store(latency, memory_order_relaxed);
+}
+
+void EclistarVSTAudioProcessor::timerCallback()
+{
+    // A switch of the topology on the audio thread reaches the host from here: the call
+    // notifies the listeners of the host, which must not happen on the audio thread.
+
+    auto latency = _latencySamples.load(memory_order_relaxed);
+
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+}
+
+double EclistarVSTAudioProcessor::TailSeconds(const ParameterSnapshot::Values& values)
+{
+    // The lowest crossover rings the longest: the envelope of a Butterworth section falls
+    // by 120 dB in ln(10^6) / (2 pi f / sqrt(2)) = 3.1 / f seconds, doubled for the two
+    // sections of a Linkwitz-Riley filter. The kernels of the linear-phase split end half a
+    // kernel after the latency. The envelopes of the compressors follow with their release time.
+
+    auto numBands = NumBandsOf(values);
+    auto lowestCutoff = values[crossoverFreq(0)];
+    auto releaseMs = 0.0f;
+
+    for (size_t i = 1; i + 1 < numBands; ++i)
+    {
+        lowestCutoff = jmin(lowestCutoff, values[crossoverFreq(i)]);
+    }
+
+    for (size_t i = 0; i < numBands; ++i)
+    {
+        releaseMs = jmax(releaseMs, values[bandParameter(i, BandParameter::release)]);
+    }
+
+    auto splitSeconds = values.isOn(linearPhase) ? VstLinearPhaseKernels::kernelSeconds : 6.2 / jmax(1.0f, lowestCutoff);
+
+    return splitSeconds + releaseMs / 1000.0;
+}
+
+template <typename SampleType>
+bool EclistarVSTAudioProcessor::IsSilent(const AudioBuffer <SampleType>& buffer, int numChannels)
+{
+    // Vectorized peak of every channel (FloatVectorOperations uses SIMD).
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto range = FloatVectorOperations::findMinAndMax(buffer.getReadPointer(channel), buffer.getNumSamples());
+
+        if (range.getStart() <= (SampleType)-silenceThreshold || range.getEnd() >= (SampleType)silenceThreshold)
+            return false;
+    }
+
+    return true;
+}
+
+template <typename SampleType>
+bool EclistarVSTAudioProcessor::UpdateSleep(const AudioBuffer <SampleType>& buffer, int numChannels)
+{
+    auto numSamples = buffer.getNumSamples();
+
+    if (!IsSilent(buffer, numChannels))
+    {
+        // Waking up: the states have decayed below the threshold, so they restart from zero.
+
+        if (_isSleeping.load(memory_order_relaxed))
+        {
+            GetChain <SampleType>().reset();
+
+            _isSleeping.store(false, memory_order_relaxed);
+        }
+
+        _silentSamples = 0;
+        return false;
+    }
+
+    if (!_isSleeping.load(memory_order_relaxed))
+    {
+        auto tailSamples = (int64)(_tailSeconds.load(memory_order_relaxed) * getSampleRate())
+                         + _latencySamples.load(memory_order_relaxed);
+
+        _silentSamples += numSamples;
+
+        if (_silentSamples < tailSamples + numSamples)
+            return false;
+
+        _isSleeping.store(true, memory_order_relaxed);
+    }
+
+    // Ramps that would end during the sleep are finished now.
+
+    AdvanceSmoothing(numSamples);
+
+    for (auto& level : _bandLevels)
+    {
+        level.skip(numSamples);
+    }
+
+    _wetLevel.skip(numSamples);
+
+    return true;
+}
+
+bool EclistarVSTAudioProcessor::isSleeping() const
+{
+    return _isSleeping.load(memory_order_relaxed);
+}
+
+uint32 EclistarVSTAudioProcessor::TraceModes() const
+{
+    const auto& values = _parameters.get();
+    uint32 modes = _isSleeping.load(memory_order_relaxed) ? VstBlockTracer::modeBit(VstBlockTracer::sleepMode) : 0;
+
+    for (size_t i = 0; i < _numBands; ++i)
+    {
+        const auto& compressor = _compressors[i];
+
+        if (values.isOn(compressor.solo))
+            modes |= VstBlockTracer::modeBit(VstBlockTracer::soloMode);
+
+        if (values.isOn(compressor.mute))
+            modes |= VstBlockTracer::modeBit(VstBlockTracer::muteMode);
+
+        if (values.isOn(compressor.bypassed))
+            modes |= VstBlockTracer::modeBit(VstBlockTracer::bypassMode);
+    }
+
+    return modes;
+}
+
+uint32 EclistarVSTAudioProcessor::GetAudibleBands() const
+{
+    // If there is an imposed effect (solo), only soloed bands are heard,
+    // otherwise every band that is not muted.
+
+    const auto& values = _parameters.get();
+    auto soledBands = false;
+
+    for (size_t i = 0; i < _numBands; ++i)
+    {
+        if (values.isOn(_compressors[i].solo))
+        {
+            soledBands = true;
+            break;
+        }
+    }
+
+    uint32 audibleBands = 0;
+
+    for (size_t i = 0; i < _numBands; ++i)
+    {
+        auto& compressor = _compressors[i];
+
+        if (soledBands ? values.isOn(compressor.solo) : !values.isOn(compressor.mute))
+        {
+            audibleBands |= 1u << i;
+        }
+    }
+
+    return audibleBands;
+}
+
+bool EclistarVSTAudioProcessor::IsPassthrough(uint32 audibleBands) const
+{
+    const auto& values = _parameters.get();
+
+    // With a latency the input would come too early, so it is never passed untouched.
+
+    if (audibleBands != (1u << _numBands) - 1 || _latencySamples.load(memory_order_relaxed) != 0)
+        return false;
+
+    for (size_t i = 0; i < _numBands; ++i)
+    {
+        if (!values.isOn(_compressors[i].bypassed) || _bandLevels[i].isSmoothing())
+            return false;
+    }
+
+    auto areGainsSmoothing = ForChain([](const auto& chain)
+    {
+        return chain.inGain.isSmoothing() || chain.outGain.isSmoothing();
+    });
+
+    return values[gainInput] == 0.0f && values[gainOutput] == 0.0f && !areGainsSmoothing;
+}
+
+uint32 EclistarVSTAudioProcessor::PlanBands(uint32 audibleBands)
+{
+    uint32 activeBands = 0;
+
+    for (size_t i = 0; i < _numBands; ++i)
+    {
+        auto isAudible = (audibleBands & (1u << i)) != 0;
+
+        _bandLevels[i].setTargetValue(isAudible ? 1.0f : 0.0f);
+
+        if (isAudible || _bandLevels[i].getCurrentValue() > 0.0f)
+        {
+            activeBands |= 1u << i;
+        }
+    }
+
+    // Filter sections and envelopes of the bands that come back are cleared,
+    // the fade of the band hides their restart.
+
+    ForChain([activeBands](auto& chain)
+    {
+        chain.crossover.setActiveBands(activeBands);
+        chain.linearCrossover.setActiveBands(activeBands);
+        chain.lookahead.setActiveBands(activeBands);
+        chain.sidechainLookahead.setActiveBands(activeBands);
+        chain.bandCompressor.setActiveBands(activeBands);
+    });
+
+    return activeBands;
+}
+
+uint32 EclistarVSTAudioProcessor::GetKeyedBands() const
+{
+    const auto& values = _parameters.get();
+    uint32 keyedBands = 0;
+
+    for (size_t i = 0; i < _numBands; ++i)
+    {
+        if (values.isOn(_compressors[i].sidechain))
+        {
+            keyedBands |= 1u << i;
+        }
+    }
+
+    return keyedBands;
+}
+
+bool EclistarVSTAudioProcessor::IsSmoothing() const
+{
+    for (const auto& cutoff : _cutoffs)
+    {
+        if (cutoff.isSmoothing())
+            return true;
+    }
+
+    for (const auto& compressor : _compressors)
+    {
+        if (compressor.smoothedThreshold.isSmoothing())
+            return true;
+    }
+
+    return false;
+}
+
+void EclistarVSTAudioProcessor::AdvanceSmoothing(int numSamples)
+{
+    // The values at the end of the control period are used for the whole period.
+
+    auto areCutoffsSmoothing = false;
+
+    for (auto& cutoff : _cutoffs)
+    {
+        if (cutoff.isSmoothing())
+        {
+            cutoff.skip(numSamples);
+            areCutoffsSmoothing = true;
+        }
+    }
+
+    if (areCutoffsSmoothing)
+    {
+        ApplyCutoffs();
+    }
+
+    ForChain([this, numSamples](auto& chain)
+    {
+        for (size_t i = 0; i < _compressors.size(); ++i)
+        {
+            _compressors[i].advanceSmoothing(chain.bandCompressor, i, numSamples);
+        }
+    });
+}
+
+void EclistarVSTAudioProcessor::ApplyCutoffs()
+{
+    // The crossover parameters may be set in any order (the first two keep the ranges
+    // of the three-band version), the bands always follow the ascending frequencies.
+
+    array <float, compressor_parameters::maxNumCrossovers> cutoffs;
+    auto numCrossovers = _numBands - 1;
+
+    for (size_t i = 0; i < numCrossovers; ++i)
+    {
+        cutoffs[i] = _cutoffs[i].getCurrentValue();
+    }
+
+    sort(cutoffs.begin(), cutoffs.begin() + (ptrdiff_t)numCrossovers);
+
+    ForChain([&cutoffs](auto& chain)
+    {
+        chain.crossover.setCutoffFrequencies(cutoffs.data());
+        chain.linearCrossover.setCutoffFrequencies(cutoffs.data());
+    });
+}
+
+void EclistarVSTAudioProcessor::setControlRate(int samplesPerUpdate)
+{
+    jassert(samplesPerUpdate > 0);
+
+    _controlRate.store(jmax(1, samplesPerUpdate), memory_order_relaxed);
+}
+
+void EclistarVSTAudioProcessor::setFusedProcessing(bool shouldBeFused, int subBlockSize)
+{
+    jassert(subBlockSize > 0);
+
+    _fusedSubBlockSize.store(jmax(1, subBlockSize), memory_order_relaxed);
+    _fusedProcessing.store(shouldBeFused, memory_order_relaxed);
+}
+
+bool EclistarVSTAudioProcessor::isFusedProcessing() const
+{
+    return _fusedProcessing.load(memory_order_relaxed);
+}
+
+void EclistarVSTAudioProcessor::setScalarCompression(bool shouldUseScalarPath)
+{
+    _scalarCompression.store(shouldUseScalarPath, memory_order_relaxed);
+}
+
+void EclistarVSTAudioProcessor::setMeteringEnabled(bool shouldMeter)
+{
+    _metering.store(shouldMeter, memory_order_relaxed);
+}
+
+void EclistarVSTAudioProcessor::setTracingEnabled(bool shouldTrace, const File& reportFile)
+{
+    _blockTracer.setEnabled(shouldTrace, reportFile);
+}
+
+void EclistarVSTAudioProcessor::setParallelProcessing(bool shouldBeParallel, int numWorkers, int minBlockSize)
+{
+    jassert(numWorkers >= 0 && minBlockSize > 0);
+
+    _parallelWorkers.store(jlimit(0, (int)VstWorkerPool::maxNumWorkers, numWorkers), memory_order_relaxed);
+    _parallelMinBlockSize.store(jmax(1, minBlockSize), memory_order_relaxed);
+    _parallelProcessing.store(shouldBeParallel, memory_order_relaxed);
+}
+
+bool EclistarVSTAudioProcessor::isParallelProcessing() const
+{
+    return _parallelProcessing.load(memory_order_relaxed);
+}
+
+bool EclistarVSTAudioProcessor::IsParallel(size_t partSize) const
+{
+    // Below the threshold the work of a task does not pay for waking the workers up. In real
+    // time the blocks leave pauses in which the workers park, and waking them enters the
+    // kernel on the audio thread, so only offline rendering is parallel.
+
+    return _parallelProcessing.load(memory_order_relaxed)
+        && isNonRealtime()
+        && _workerPool.getNumWorkers() > 0
+        && partSize >= (size_t)_parallelMinBlockSize.load(memory_order_relaxed);
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::ProcessPart(AudioBlock <SampleType>& block, const AudioBlock <const SampleType>& sidechain,
+                                            uint32 activeBands)
+{
+    auto& chain = GetChain <SampleType>();
+    auto partSize = block.getNumSamples();
+
+    // The input is kept only while the output is crossfaded with it.
+
+    auto isCrossfading = _wetLevel.isSmoothing();
+    auto dryBlock = AudioBlock <SampleType>(chain.dryBuffer)
+        .getSubsetChannelBlock(0, block.getNumChannels())
+        .getSubBlock(0, partSize);
+
+    if (isCrossfading)
+    {
+        dryBlock.copyFrom(block);
+    }
+
+    // In gain used before applying filters.
+
+    {
+        ScopedStageTimer timer(_stageTicks[inputGainStage]);
+        ApplyGain(block, chain.inGain);
+    }
+
+    // Determine the size of the data to work with the compressors: all bands of the part.
+
+    auto numChannels = block.getNumChannels();
+    auto bandsBlock = AudioBlock <SampleType>(chain.bandBuffer)
+        .getSubsetChannelBlock(0, _numBands * numChannels)
+        .getSubBlock(0, partSize);
+
+    // The sidechain is split only when a band is keyed by it.
+
+    _keyedBands = sidechain.getNumChannels() > 0 ? GetKeyedBands() & activeBands : 0;
+
+    auto sidechainBands = AudioBlock <SampleType>(chain.sidechainBuffer)
+        .getSubsetChannelBlock(0, _numBands * numChannels)
+        .getSubBlock(0, partSize);
+
+    {
+        ScopedStageTimer timer(_stageTicks[splitStage]);
+
+        if (_keyedBands != 0)
+            SplitIntoBands(block, sidechain, bandsBlock, sidechainBands);
+        else
+            SplitIntoBands(block, bandsBlock);
+    }
+
+    if (_keyedBands != 0)
+    {
+        ScopedStageTimer timer(_stageTicks[lookaheadStage]);
+        PrepareSidechainKeys(sidechainBands, chain.oversampler.getFactor());
+    }
+
+    // The meters read the bands while they are in the cache: after the split and before the sum.
+
+    auto isMetering = _metering.load(memory_order_relaxed);
+
+    if (isMetering)
+    {
+        _meteringBus.addInput(bandsBlock, numChannels, activeBands);
+    }
+
+    // The compressors work at the oversampled rate when it is on.
+
+    if (IsParallel(partSize))
+    {
+        ScopedStageTimer timer(_stageTicks[compressorsStage]);
+        CompressBandsInParallel(bandsBlock, numChannels);
+    }
+    else if (chain.oversampler.getFactor() > 1)
+    {
+        AudioBlock <SampleType> oversampledBlock;
+
+        {
+            ScopedStageTimer timer(_stageTicks[resamplingStage]);
+            oversampledBlock = chain.oversampler.processUp(AudioBlock <const SampleType>(bandsBlock));
+        }
+
+        CompressBands(oversampledBlock, numChannels);
+
+        {
+            ScopedStageTimer timer(_stageTicks[resamplingStage]);
+            chain.oversampler.processDown(bandsBlock);
+        }
+    }
+    else
+    {
+        CompressBands(bandsBlock, numChannels);
+    }
+
+    if (isMetering)
+    {
+        _meteringBus.addOutput(bandsBlock, numChannels, activeBands);
+
+        for (size_t band = 0; band < _numBands; ++band)
+        {
+            _meteringBus.addGain(band, (float)chain.bandCompressor.getBandGain(band));
+        }
+
+        _meteringBus.advance(partSize);
+    }
+
+    {
+        ScopedStageTimer timer(_stageTicks[sumStage]);
+        SumBands(block, bandsBlock, activeBands);
+    }
+
+    // Output gain used after applying filters.
+
+    {
+        ScopedStageTimer timer(_stageTicks[outputGainStage]);
+        ApplyGain(block, chain.outGain);
+    }
+
+    if (isCrossfading)
+    {
+        MixDry(block, dryBlock);
+    }
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::SplitIntoBands(const AudioBlock <SampleType>& block, AudioBlock <SampleType>& bands)
+{
+    // The crossover writes its outputs straight into the band buffer,
+    // so the input is never copied.
+
+    auto& chain = GetChain <SampleType>();
+
+    jassert(bands.getNumChannels() <= (size_t)chain.bandBuffer.getNumChannels());
+    jassert(block.getNumSamples() <= (size_t)chain.bandBuffer.getNumSamples());
+
+    if (_linearPhase)
+        chain.linearCrossover.process(AudioBlock <const SampleType>(block), bands);
+    else
+        chain.crossover.process(AudioBlock <const SampleType>(block), bands);
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::SplitIntoBands(const AudioBlock <SampleType>& block, const AudioBlock <const SampleType>& sidechain,
+                                               AudioBlock <SampleType>& bands, AudioBlock <SampleType>& sidechainBands)
+{
+    // The sidechain takes the lanes after the channels of the input, in the same pass.
+
+    auto& chain = GetChain <SampleType>();
+
+    jassert(sidechainBands.getNumChannels() <= (size_t)chain.sidechainBuffer.getNumChannels());
+    jassert(block.getNumSamples() <= (size_t)chain.sidechainBuffer.getNumSamples());
+
+    if (_linearPhase)
+        chain.linearCrossover.process(AudioBlock <const SampleType>(block), sidechain, bands, sidechainBands);
+    else
+        chain.crossover.process(AudioBlock <const SampleType>(block), sidechain, bands, sidechainBands);
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::PrepareSidechainKeys(const AudioBlock <SampleType>& sidechainBands, size_t factor)
+{
+    // The keys are the bands of the sidechain, or the peaks of their lookahead windows. They
+    // are found at the host rate and held at the rate of the compressors: the detectors only
+    // need the level, so the sidechain is not resampled.
+
+    auto& chain = GetChain <SampleType>();
+    auto numSamples = sidechainBands.getNumSamples();
+    auto hasLookahead = chain.sidechainLookahead.getDelay() > 0;
+
+    if (!hasLookahead && factor == 1)
+    {
+        chain.sidechainKeys = sidechainBands;
+        return;
+    }
+
+    chain.sidechainKeys = AudioBlock <SampleType>(chain.sidechainKeyBuffer)
+        .getSubsetChannelBlock(0, sidechainBands.getNumChannels())
+        .getSubBlock(0, numSamples * factor);
+
+    auto source = sidechainBands;
+
+    if (hasLookahead)
+    {
+        source = chain.sidechainKeys.getSubBlock(0, numSamples);
+
+        auto delayedBands = sidechainBands;
+        chain.sidechainLookahead.process(delayedBands, source);
+    }
+
+    if (factor == 1)
+        return;
+
+    // From the last sample backwards, so the keys can be held in place.
+
+    auto numChannels = sidechainBands.getNumChannels() / _numBands;
+
+    for (size_t channel = 0; channel < sidechainBands.getNumChannels(); ++channel)
+    {
+        if ((_keyedBands & (1u << (channel / numChannels))) == 0)
+            continue;
+
+        const auto* samples = source.getChannelPointer(channel);
+        auto* keys = chain.sidechainKeys.getChannelPointer(channel);
+
+        for (auto i = numSamples; i-- > 0;)
+        {
+            auto value = samples[i];
+
+            for (auto k = factor; k-- > 0;)
+            {
+                keys[i * factor + k] = value;
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::CompressBands(AudioBlock <SampleType>& bands, size_t numChannels, size_t firstChannel, bool isParallelTask)
+{
+    // With a lookahead the bands are delayed and the detectors get the peaks ahead of them.
+
+    auto& chain = GetChain <SampleType>();
+    auto hasLookahead = chain.lookahead.getDelay() > 0;
+    auto keysBlock = AudioBlock <SampleType>(chain.keyBuffer)
+        .getSubsetChannelBlock(firstChannel, bands.getNumChannels())
+        .getSubBlock(0, bands.getNumSamples());
+
+    if (hasLookahead)
+    {
+        ScopedStageTimer timer(_stageTicks[lookaheadStage], !isParallelTask);
+
+        if (isParallelTask)
+            chain.lookahead.processChannels(bands, keysBlock, firstChannel, numChannels);
+        else
+            chain.lookahead.process(bands, keysBlock);
+    }
+
+    // Bands keyed by the sidechain detect on its keys, the other ones on the keys of the
+    // lookahead or on themselves (the compressors read a key before they write its sample).
+
+    auto hasKeys = hasLookahead || _keyedBands != 0;
+    SampleType* keyChannels[maxNumBands * (size_t)maxNumChannels] = {};
+
+    if (_keyedBands != 0)
+    {
+        for (size_t channel = 0; channel < bands.getNumChannels(); ++channel)
+        {
+            auto band = (firstChannel + channel) / numChannels;
+
+            keyChannels[channel] = (_keyedBands & (1u << band)) != 0
+                ? chain.sidechainKeys.getChannelPointer(firstChannel + channel)
+                : (hasLookahead ? keysBlock : bands).getChannelPointer(channel);
+        }
+
+        keysBlock = AudioBlock <SampleType>(keyChannels, bands.getNumChannels(), bands.getNumSamples());
+    }
+
+    if (_scalarCompression.load(memory_order_relaxed))
+    {
+        for (size_t channel = 0; channel < bands.getNumChannels(); channel += numChannels)
+        {
+            auto band = (firstChannel + channel) / numChannels;
+
+            ScopedStageTimer timer(_bandTicks[band], !isParallelTask);
+
+            auto bandBlock = bands.getSubsetChannelBlock(channel, numChannels);
+            auto keyBlock = keysBlock.getSubsetChannelBlock(channel, numChannels);
+
+            chain.bandCompressor.processScalarBand(bandBlock, band, hasKeys ? &keyBlock : nullptr);
+        }
+    }
+    else
+    {
+        ScopedStageTimer timer(_stageTicks[compressorsStage], !isParallelTask);
+
+        if (hasKeys)
+            chain.bandCompressor.process(bands, keysBlock, firstChannel);
+        else
+            chain.bandCompressor.process(bands, firstChannel);
+    }
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::CompressBandsInParallel(AudioBlock <SampleType>& bands, size_t numChannels)
+{
+    auto& chain = GetChain <SampleType>();
+    auto numBandChannels = bands.getNumChannels();
+    auto factor = chain.oversampler.getFactor();
+
+    // A task starts on a register of the oversampler, the lookahead and the compressors
+    // (linked channels and the scalar path need whole bands as well).
+
+    auto taskSize = SIMDRegister <SampleType>::size();
+
+    if (chain.bandCompressor.isChannelLinked() || _scalarCompression.load(memory_order_relaxed))
+    {
+        taskSize = (size_t)std::lcm(taskSize, numChannels);
+    }
+
+    auto numTasks = (numBandChannels + taskSize - 1) / taskSize;
+
+    auto task = [&](size_t index)
+    {
+        auto firstChannel = index * taskSize;
+        auto block = bands.getSubsetChannelBlock(firstChannel, jmin(taskSize, numBandChannels - firstChannel));
+
+        if (factor > 1)
+        {
+            auto oversampledBlock = chain.oversampler.processUp(AudioBlock <const SampleType>(block), firstChannel);
+
+            CompressBands(oversampledBlock, numChannels, firstChannel, true);
+
+            chain.oversampler.processDown(block, firstChannel);
+        }
+        else
+        {
+            CompressBands(block, numChannels, firstChannel, true);
+        }
+    };
+
+    _workerPool.run(numTasks, task);
+
+    if (chain.lookahead.getDelay() > 0)
+    {
+        chain.lookahead.advance(bands.getNumSamples() * factor);
+    }
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::SumBands(AudioBlock <SampleType>& block, const AudioBlock <SampleType>& bands, uint32 activeBands)
+{
+    // Bands are added at their level: at full level with a plain add, while
+    // fading (solo, mute) sample by sample, and not at all when silent.
+
+    auto numChannels = block.getNumChannels();
+    auto numSamples = block.getNumSamples();
+
+    block.clear();
+
+    for (size_t i = 0; i < _numBands; ++i)
+    {
+        auto& level = _bandLevels[i];
+
+        if ((activeBands & (1u << i)) == 0)
+            continue;
+
+        auto bandBlock = bands.getSubsetChannelBlock(i * numChannels, numChannels);
+
+        if (!level.isSmoothing())
+        {
+            if (level.getCurrentValue() > 0.0f)
+            {
+                block.add(bandBlock);
+            }
+
+            continue;
+        }
+
+        for (size_t sample = 0; sample < numSamples; ++sample)
+        {
+            auto gain = level.getNextValue();
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                block.getChannelPointer(channel)[sample] += gain * bandBlock.getChannelPointer(channel)[sample];
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void EclistarVSTAudioProcessor::MixDry(AudioBlock <SampleType>& block, const AudioBlock <SampleType>& dryBlock)
+{
+    auto numChannels = block.getNumChannels();
+    auto numSamples = block.getNumSamples();
+
+    for (size_t sample = 0; sample < numSamples; ++sample)
+    {
+        auto wet = _wetLevel.getNextValue();
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            auto* samples = block.getChannelPointer(channel);
+            auto dry = dryBlock.getChannelPointer(channel)[sample];
+
+            samples[sample] = dry + wet * (samples[sample] - dry);
+        }
+    }
+}
+
+//==============================================================================================
+// Functions of editor.
+
+bool EclistarVSTAudioProcessor::hasEditor() const
+{
+    return true;
+}
+
+AudioProcessorEditor* EclistarVSTAudioProcessor::createEditor()
+{
+    return new EclistarVSTAudioProcessorEditor(*this);
+}
+
+//==============================================================================================
+// Data state status.
+
+void EclistarVSTAudioProcessor::getStateInformation(MemoryBlock& destinationData)
+{
+    // The sound went to the right place.
+
+    getPreset().write(destinationData);
+}
+
+void EclistarVSTAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    // The binary preset sets the parameters directly.
+
+    if (VstPreset::isPreset(data, (size_t)jmax(0, sizeInBytes)))
+    {
+        VstPreset preset;
+
+        if (preset.read(data, (size_t)sizeInBytes))
+        {
+            applyPreset(preset);
+        }
+
+        return;
+    }
+
+    // A universal structure for storing and interacting data with each other (older states).
+
+    auto valueTree = ValueTree::readFromData(data, sizeInBytes);
+    if (valueTree.isValid())
+    {
+        apvts.replaceState(valueTree);
+    }
+}
+
+VstPreset EclistarVSTAudioProcessor::getPreset() const
+{
+    return _presetParameters.capture();
+}
+
+void EclistarVSTAudioProcessor::applyPreset(const VstPreset& preset)
+{
+    _presetParameters.apply(preset);
+}
+
+//==============================================================================================
+// Layout, application appearance.
+
+AudioProcessorValueTreeState::ParameterLayout
+EclistarVSTAudioProcessor::createParameterLayout()
+{
+    auto attackRange = NormalisableRange <float>(5, 500, 1, 1);
+    auto gainRange = NormalisableRange <float>(-24.f, 24.f, 0.5f, 1.f);
+
+    StringArray strArray;
+    for (auto choice : ratioValues)
+    {
+        strArray.add(String((double)choice, 1));
+    }
+
+    APVTS::ParameterLayout layout;
+    const auto& parameters = GetParameters();
+
+    // Testing sliders:
+
+    // Gain;
+
+    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::gainInput),
+        parameters.at(NamesOfParameters::gainInput),
+        gainRange, 0));
+    layout.add(make_unique<AudioParameterFloat>(parameters.at(NamesOfParameters::gainOutput),
+        parameters.at(NamesOfParameters::gainOutput),
+        gainRange, 0));
+
+    // Compressors of the bands (the first three keep their place in the layout);
+
+    auto AddBand = [&](size_t band)
+    {
+        auto Id = [&](BandParameter parameter) { return parameters.at(bandParameter(band, parameter)); };
+
+        layout.add(make_unique<AudioParameterChoice>(Id(BandParameter::ratio),
+            Id(BandParameter::ratio),
+            strArray, 3));
+
+        layout.add(make_unique<AudioParameterFloat>(Id(BandParameter::threshold),
+            Id(BandParameter::threshold),
+            NormalisableRange<float>(-60, 12, 1, 1), 0));
+        layout.add(make_unique<AudioParameterFloat>(Id(BandParameter::attack),
+            Id(BandParameter::attack),
+            attackRange, 0));
+        layout.add(make_unique<AudioParameterFloat>(Id(BandParameter::release),
+            Id(BandParameter::release),
+            attackRange, 250));
+
+        layout.add(make_unique<AudioParameterBool>(Id(BandParameter::solo),
+            Id(BandParameter::solo),
+            false));
+        layout.add(make_unique<AudioParameterBool>(Id(BandParameter::mute),
+            Id(BandParameter::mute),
+            false));
+        layout.add(make_unique<AudioParameterBool>(Id(BandParameter::bypassed),
+            Id(BandParameter::bypassed),
+            false));
+    };
+
+    for (size_t band = 0; band < defaultNumBands; ++band)
+    {
+        AddBand(band);
+    }
+
+    // Crossovers of the three-band version.
+
+    layout.add(make_unique<AudioParameterFloat>(parameters.at(crossoverFreq(0)),
+        parameters.at(crossoverFreq(0)),
+        NormalisableRange<float>(20, 999, 1, 1), 400));
+
+    layout.add(make_unique<AudioParameterFloat>(parameters.at(crossoverFreq(1)),
+        parameters.at(crossoverFreq(1)),
+        NormalisableRange<float>(1000, 20000, 1, 1), 2000));
+
+    // Number of bands, then the crossovers and bands added to the three-band version.
+
+    layout.add(make_unique<AudioParameterInt>(parameters.at(NamesOfParameters::numberOfBands),
+        parameters.at(NamesOfParameters::numberOfBands),
+        (int)minNumBands, (int)maxNumBands, (int)defaultNumBands));
+
+    const float extraCutoffs[] = { 5000, 8000, 11000, 14000, 17000 };
+
+    for (size_t crossover = 2; crossover < maxNumCrossovers; ++crossover)
+    {
+        layout.add(make_unique<AudioParameterFloat>(parameters.at(crossoverFreq(crossover)),
+            parameters.at(crossoverFreq(crossover)),
+            NormalisableRange<float>(20, 20000, 1, 1), extraCutoffs[crossover - 2]));
+    }
+
+    for (size_t band = defaultNumBands; band < maxNumBands; ++band)
+    {
+        AddBand(band);
+    }
+
+    // Oversampling of the compressors (off by default, it adds latency).
+
+    StringArray factorChoices;
+    for (auto factor : oversamplingFactors)
+    {
+        factorChoices.add(factor == 1 ? String("off") : String((int)factor) + "x");
+    }
+
+    StringArray qualityChoices;
+    for (auto quality : oversamplingQualities)
+    {
+        qualityChoices.add(quality);
+    }
+
+    layout.add(make_unique<AudioParameterChoice>(parameters.at(NamesOfParameters::oversampling),
+        parameters.at(NamesOfParameters::oversampling),
+        factorChoices, 0));
+    layout.add(make_unique<AudioParameterChoice>(parameters.at(NamesOfParameters::oversamplingQuality),
+        parameters.at(NamesOfParameters::oversamplingQuality),
+        qualityChoices, (int)VstOversamplerBase::normalQuality));
+
+    // Lookahead of the bands (off by default, without latency). While a band has one, the audio
+    // is delayed by the longest one, so the latency does not move with the automation.
+
+    for (size_t band = 0; band < maxNumBands; ++band)
+    {
+        auto id = parameters.at(bandParameter(band, BandParameter::lookahead));
+
+        layout.add(make_unique<AudioParameterFloat>(id, id,
+            NormalisableRange<float>(0, (float)(VstLookahead <float>::maxLookaheadSeconds * 1000.0), 0.1f, 1), 0));
+    }
+
+    // Linked detection of the channels (off: every channel is compressed on its own).
+
+    layout.add(make_unique<AudioParameterBool>(parameters.at(linkChannels), parameters.at(linkChannels), false));
+
+    // Linear-phase split of the bands (it adds latency, so it is off by default).
+
+    layout.add(make_unique<AudioParameterBool>(parameters.at(linearPhase), parameters.at(linearPhase), false));
+
+    // Soft knee of the compressors (a hard knee by default, as before).
+
+    layout.add(make_unique<AudioParameterFloat>(parameters.at(knee), parameters.at(knee),
+        NormalisableRange<float>(0, 24, 0.1f, 1), 0));
+
+    // Detection of the bands on their band of the sidechain (off: on the band itself).
+
+    for (size_t band = 0; band < maxNumBands; ++band)
+    {
+        auto id = parameters.at(bandParameter(band, BandParameter::sidechain));
+
+        layout.add(make_unique<AudioParameterBool>(id, id, false));
+    }
+
+    return layout;
+}
+
+//==============================================================================================
+// Creating plugin.
+
+AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new EclistarVSTAudioProcessor();
+}
+
@@ -1,279 +1,608 @@
-#pragma once
-
-#include <JuceHeader.h>
-
-using namespace juce;
-using namespace dsp;
-using namespace std;
-
-//==============================================================================================
-// Namespace of compressor parameters.
-
-namespace compressor_parameters
-{
-    enum NamesOfParameters
-    {
-        // Names of the main parameters.
-
-        ratioLowBand,
-        ratioMidBand,
-        ratioHighBand,
-
-        attackLowBand,
-        attackMidBand,
-        attackHighBand,
-
-        releaseLowBand,
-        releaseMidBand,
-        releaseHighBand,
-
-        thresholdLowBand,
-        thresholdMidBand,
-        thresholdHighBand,
-
-        // Names of additional parameters and channels.
-
-        gainInput,
-        gainOutput,
-
-        soloLowBand,
-        soloMidBand,
-        soloHighBand,
-
-        muteLowBand,
-        muteMidBand,
-        muteHighBand,
-
-        bypassedLowBand,
-        bypassedMidBand,
-        bypassedHighBand,
-
-        // Names of crossovers.
-
-        lowMidCrossoverFreq,
-        midHighCrossoverFreq,
-    };
-
-    // Correlation of parameters and their names when determining on the layout.
-
-    const map<NamesOfParameters, String>& GetParameters()
-    {
-        static map <NamesOfParameters, String> parameters =
-        {
-            { ratioLowBand, "ratio low band" },
-            { ratioMidBand, "ratio mid band" },
-            { ratioHighBand, "Ratio high Band" },
-
-            { attackLowBand, "attack low band" },
-            { attackMidBand, "attack mid band" },
-            { attackHighBand, "attack high band" },
-
-            { releaseLowBand, "release low band" },
-            { releaseMidBand, "release mid band" },
-            { releaseHighBand, "release high band" },
-
-            { thresholdLowBand, "threshold low band" },
-            { thresholdMidBand, "threshold mid band" },
-            { thresholdHighBand, "threshold high band" },
-
-
-            { gainInput, "gain in" },
-            { gainOutput, "gain out" },
-
-            { soloLowBand, "solo low band" },
-            { soloMidBand, "solo mid band" },
-            { soloHighBand, "solo high band" },
-
-            { muteLowBand, "mute low band" },
-            { muteMidBand, "mute mid band" },
-            { muteHighBand, "mute high band" },
-
-            { bypassedLowBand, "bypassed low band" },
-            { bypassedMidBand, "bypassed mid band" },
-            { bypassedHighBand, "bypassed high band" },
-
-            { lowMidCrossoverFreq, "low-mid crossover frequency" },
-            { midHighCrossoverFreq, "mid-high crossover frequency" }
-        };
-
-        return parameters;
-    }
-}
-
-//==============================================================================================
-// Structure of compressor.
-
-struct VstCompressorBand
-{
-private:
-
-    Compressor<float> _compressor;
-
-public:
-
-    // Elements of compressor.
-
-    AudioParameterChoice* ratio{ nullptr };
-
-    AudioParameterBool* solo{ nullptr };
-    AudioParameterBool* mute{ nullptr };
-    AudioParameterBool* bypassed{ nullptr };
-
-    AudioParameterFloat* attack{ nullptr };
-    AudioParameterFloat* release{ nullptr };
-    AudioParameterFloat* threshold{ nullptr };
-
-    // Functions of the compressor itself.
-
-    void prepare(const ProcessSpec& process_spec)
-    {
-        _compressor.prepare(process_spec);
-    }
-
-    void updateVstCompressorSettings()
-    {
-        _compressor.setAttack(attack->get());
-        _compressor.setRelease(release->get());
-        _compressor.setThreshold(threshold->get());
-        _compressor.setRatio(ratio->getCurrentChoiceName().getFloatValue());
-    }
-
-    void processing(AudioBuffer <float>& buffer)
-    {
-        auto audioBlock = AudioBlock <float>(buffer);
-        auto context = ProcessContextReplacing <float>(audioBlock);
-
-        context.isBypassed = bypassed->get();
-
-        _compressor.process(context);
-    }
-};
-
-//==============================================================================================
-// Class of processor compressor.
-
-class EclistarVSTAudioProcessor : public AudioProcessor
-#if JucePlugin_Enable_ARA
-    , public AudioProcessorARAExtension
-#endif
-{
-public:
-
-    EclistarVSTAudioProcessor();
-
-    ~EclistarVSTAudioProcessor() override;
-
-//==============================================================================================
-
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-
-    void releaseResources() override;
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
-#endif
-
-    void processBlock(AudioBuffer<float>&, MidiBuffer&) override;
-
-//==============================================================================================
-
-    AudioProcessorEditor* createEditor() override;
-
-    bool hasEditor() const override;
-
-//==============================================================================================
-
-    const String getName() const override;
-
-    bool acceptsMidi() const override;
-
-    bool producesMidi() const override;
-
-    bool isMidiEffect() const override;
-
-    double getTailLengthSeconds() const override;
-
-//==============================================================================================
-
-    int getNumPrograms() override;
-
-    int getCurrentProgram() override;
-
-    void setCurrentProgram(int index) override;
-
-    const String getProgramName(int index) override;
-
-    void changeProgramName(int index, const String& newName) override;
-
-//==============================================================================================
-
-    void getStateInformation(MemoryBlock& destinationData) override;
-
-    void setStateInformation(const void* data, int sizeInBytes) override;
-
-    // Creating a tree of audio parameter values.
-
-    using APVTS = AudioProcessorValueTreeState;
-
-    // Linking the value tree and the layout of the parameters display.
-
-    static APVTS::ParameterLayout createParameterLayout();
-    APVTS apvts{ *this, nullptr, "Parameters", createParameterLayout() };
-
-
-private:
-//==============================================================================================
-// The following are the elements of the compressor, Linkwitz filter.
-
-    // Define compressors of three levels.
-
-    array <VstCompressorBand, 3> _compressors;
-
-    VstCompressorBand& _lowCompressor = _compressors[0];
-    VstCompressorBand& _midCompressor = _compressors[1];
-    VstCompressorBand& _highCompressor = _compressors[2];
-
-    // Apply Linkwitz-Riley filters, which will help with the mechanization
-    // of compressor activity ranges.
-
-    using Filter = LinkwitzRileyFilter <float>;
-
-    Filter _lowPass1;
-    Filter _lowPass2;
-
-    Filter _highPass1;
-    Filter _highPass2;
-
-    Filter _allPass2;
-
-    // Creating gain parameters.
-
-    Gain <float> _inGain;                   // values
-    Gain <float> _outGain;      
-
-    AudioParameterFloat* _inputGain;        // parameters    
-    AudioParameterFloat* _outputGain;
-
-    // Define crossovers and an audio buffer.
-
-    AudioParameterFloat* _lowMidCrossover{ nullptr };
-    AudioParameterFloat* _midHighCrossover{ nullptr };
-
-    array <AudioBuffer <float>, 3> _multiFilterBuffers;
-
-    // Apply the gain & gain context.
-
-    template <typename B, typename G>
-
-    void ApplyGain(B& buffer, G& gain)
-    {
-        auto audioBlock = AudioBlock <float>(buffer);
-        auto context = ProcessContextReplacing <float>(audioBlock);
-
-        gain.process(context);
-    }
-
-//==============================================================================================
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EclistarVSTAudioProcessor)
-};
+#pragma once
+
+#include <JuceHeader.h>
+#include "VstCrossover.h"
+#include "VstLinearPhaseCrossover.h"
+#include "MultiBandCompressorSIMD.h"
+#include "VstOversampler.h"
+#include "VstLookahead.h"
+#include "VstWorkerPool.h"
+#include "VstMeteringBus.h"
+#include "VstSpectrumAnalyzer.h"
+#include "VstBlockTracer.h"
+#include "VstPreset.h"
+#include "ParameterSnapshot.h"
+
+// Per-stage timing of processBlock, compiled in only for the benchmarks.
+
+#ifndef ECLISTAR_STAGE_TIMING
+ #define ECLISTAR_STAGE_TIMING 0
+#endif
+
+using namespace juce;
+using namespace dsp;
+using namespace std;
+
+//==============================================================================================
+// Structure of compressor.
+
+struct VstCompressorBand
+{
+    using NamesOfParameters = compressor_parameters::NamesOfParameters;
+    using BandParameter = compressor_parameters::BandParameter;
+
+    // Elements of compressor (their places in the parameter snapshot).
+
+    NamesOfParameters ratio{};
+
+    NamesOfParameters solo{};
+    NamesOfParameters mute{};
+    NamesOfParameters bypassed{};
+
+    NamesOfParameters attack{};
+    NamesOfParameters release{};
+    NamesOfParameters threshold{};
+
+    NamesOfParameters lookahead{};
+
+    NamesOfParameters sidechain{};
+
+    // Automation of the threshold is smoothed (in dB) and applied at the control rate.
+
+    SmoothedValue <float> smoothedThreshold;
+
+    // Parameters of the band with the given index.
+
+    static VstCompressorBand forBand(size_t band)
+    {
+        using compressor_parameters::bandParameter;
+
+        VstCompressorBand compressorBand;
+
+        compressorBand.ratio = bandParameter(band, BandParameter::ratio);
+        compressorBand.solo = bandParameter(band, BandParameter::solo);
+        compressorBand.mute = bandParameter(band, BandParameter::mute);
+        compressorBand.bypassed = bandParameter(band, BandParameter::bypassed);
+        compressorBand.attack = bandParameter(band, BandParameter::attack);
+        compressorBand.release = bandParameter(band, BandParameter::release);
+        compressorBand.threshold = bandParameter(band, BandParameter::threshold);
+        compressorBand.lookahead = bandParameter(band, BandParameter::lookahead);
+        compressorBand.sidechain = bandParameter(band, BandParameter::sidechain);
+
+        return compressorBand;
+    }
+
+    // Parameters which change the compressor itself (solo and mute only change the sum, the
+    // lookahead is set by the processor for all bands together, the key is chosen per block).
+
+    ParameterSnapshot::Mask getSettingsMask() const noexcept
+    {
+        return ParameterSnapshot::maskOf(ratio) | ParameterSnapshot::maskOf(bypassed)
+             | ParameterSnapshot::maskOf(attack) | ParameterSnapshot::maskOf(release)
+             | ParameterSnapshot::maskOf(threshold);
+    }
+
+    // The band itself is processed by MultiBandCompressorSIMD together
+    // with the other bands, here its settings are passed to it.
+
+    template <typename SampleType>
+
+    void updateVstCompressorSettings(MultiBandCompressorSIMD <SampleType>& compressor, size_t band,
+                                     const ParameterSnapshot::Values& values)
+    {
+        smoothedThreshold.setTargetValue(values[threshold]);
+
+        compressor.setBandParameters(band,
+                                     values[attack],
+                                     values[release],
+                                     smoothedThreshold.getCurrentValue(),
+                                     values.ratio(ratio),
+                                     values.isOn(bypassed));
+    }
+
+    void resetSmoothing(double sampleRate, double rampSeconds, const ParameterSnapshot::Values& values)
+    {
+        smoothedThreshold.reset(sampleRate, rampSeconds);
+        smoothedThreshold.setCurrentAndTargetValue(values[threshold]);
+    }
+
+    // Moves the threshold by the given number of samples towards its target.
+
+    template <typename SampleType>
+
+    void advanceSmoothing(MultiBandCompressorSIMD <SampleType>& compressor, size_t band, int numSamples)
+    {
+        if (smoothedThreshold.isSmoothing())
+        {
+            compressor.setBandThreshold(band, smoothedThreshold.skip(numSamples));
+        }
+    }
+};
+
+//==============================================================================================
+// DSP objects and buffers of one sample type (float or double).
+
+template <typename SampleType>
+struct VstDspChain
+{
+    MultiBandCompressorSIMD <SampleType> bandCompressor;
+
+    VstCrossover <SampleType> crossover;
+
+    // Linear-phase split, used instead of the crossover when it is selected.
+
+    VstLinearPhaseCrossover <SampleType> linearCrossover;
+
+    VstOversampler <SampleType> oversampler;
+    VstLookahead <SampleType> lookahead;
+
+    // Keys from the sidechain: its bands get their lookahead at the host rate.
+
+    VstLookahead <SampleType> sidechainLookahead;
+
+    Gain <SampleType> inGain;
+    Gain <SampleType> outGain;
+
+    // All bands in one contiguous buffer, band b of a block with numChannels channels is in
+    // the channels b * numChannels ... (b + 1) * numChannels - 1. The dry buffer keeps the
+    // input during a crossfade, the key buffer the keys of the lookahead. The sidechain is split
+    // into its own bands in the same layout; its keys are brought to the rate of the compressors
+    // in the sidechain key buffer.
+
+    AudioBuffer <SampleType> bandBuffer;
+    AudioBuffer <SampleType> dryBuffer;
+    AudioBuffer <SampleType> keyBuffer;
+
+    AudioBuffer <SampleType> sidechainBuffer;
+    AudioBuffer <SampleType> sidechainKeyBuffer;
+
+    // Keys of the sidechain for the compressors in the current part.
+
+    AudioBlock <SampleType> sidechainKeys;
+
+    // The states restart from silence (the settings are kept).
+
+    void reset()
+    {
+        crossover.reset();
+        linearCrossover.reset();
+        oversampler.reset();
+        lookahead.reset();
+        sidechainLookahead.reset();
+        bandCompressor.reset();
+    }
+};
+
+//==============================================================================================
+// Class of processor compressor.
+
+class EclistarVSTAudioProcessor : public AudioProcessor, private Timer
+#if JucePlugin_Enable_ARA
+    , public AudioProcessorARAExtension
+#endif
+{
+public:
+
+    EclistarVSTAudioProcessor();
+
+    ~EclistarVSTAudioProcessor() override;
+
+//==============================================================================================
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+
+    void releaseResources() override;
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+#endif
+
+    void processBlock(AudioBuffer<float>&, MidiBuffer&) override;
+    void processBlock(AudioBuffer<double>&, MidiBuffer&) override;
+
+    // The whole chain also runs in double precision (for 64-bit hosts), see VstDspChain.
+
+    bool supportsDoublePrecisionProcessing() const override;
+
+    // Optional fused engine: the block is passed through the whole chain in short
+    // sub-blocks instead of stage by stage. The output is bit-identical.
+
+    void setFusedProcessing(bool shouldBeFused, int subBlockSize = 32);
+    bool isFusedProcessing() const;
+
+    // Optional parallel compression for large blocks in offline rendering (isNonRealtime):
+    // parts of at least minBlockSize samples are resampled and compressed by numWorkers pinned
+    // worker threads (at most one per other CPU) together with the audio thread, smaller parts
+    // and real-time blocks stay on the audio thread. The output is bit-identical. The workers
+    // are started in prepareToPlay.
+
+    void setParallelProcessing(bool shouldBeParallel, int numWorkers = 3, int minBlockSize = 1024);
+    bool isParallelProcessing() const;
+
+    // Crossover and threshold automation is smoothed; the coefficients are updated once
+    // per control period (in samples), whatever the size of the host blocks is.
+
+    void setControlRate(int samplesPerUpdate);
+
+    // The processor sleeps while its input is silent and its tail has decayed.
+
+    bool isSleeping() const;
+
+    // Levels and gain reduction of the bands for the editor. They are measured only while
+    // metering is on (the editor turns it on while it is open).
+
+    void setMeteringEnabled(bool shouldMeter);
+    VstMeteringBus& getMeteringBus() { return _meteringBus; }
+
+    // Spectra of the input and the output for the editor, which enables the analyzer while
+    // it is open. The audio thread only copies the blocks into its rings.
+
+    VstSpectrumAnalyzer& getSpectrumAnalyzer() { return _spectrumAnalyzer; }
+
+    // Tracing of the time of every processBlock against its real-time budget (off by default,
+    // a single branch per block while off). The report is read from the tracer and, with a
+    // report file, written there as JSON. ECLISTAR_TRACE in the environment names a directory
+    // in which every instance traces into a file of its own.
+
+    void setTracingEnabled(bool shouldTrace, const File& reportFile = File());
+    VstBlockTracer& getBlockTracer() { return _blockTracer; }
+
+    // Scalar reference path of the band compressors, used to validate the SIMD one.
+
+    void setScalarCompression(bool shouldUseScalarPath);
+
+    // Stages of processBlock measured with ECLISTAR_STAGE_TIMING. The compressors are timed
+    // all together on the SIMD path and band by band on the scalar one (getBandTicks).
+    // Resampling is the way up to the oversampled rate and back. In parallel processing the
+    // resampling, the lookahead and the compressors are timed together as compressors.
+
+    enum Stage
+    {
+        inputGainStage,
+        splitStage,
+        resamplingStage,
+        lookaheadStage,
+        compressorsStage,
+        sumStage,
+        outputGainStage,
+
+        numStages
+    };
+
+    static constexpr size_t maxNumBands = compressor_parameters::maxNumBands;
+
+    // Any layout of up to 16 channels (mono, stereo, surround, discrete), the same on the
+    // input and on the output.
+
+    static constexpr int maxNumChannels = 16;
+
+    static_assert(maxNumChannels <= (int)MultiBandCompressorSIMD <float>::maxNumChannels,
+                  "The compressor must support all channels of the layouts.");
+
+    static_assert(maxNumBands <= VstCrossover <float>::maxNumBands && maxNumBands <= MultiBandCompressorSIMD <float>::maxNumBands,
+                  "The DSP must support all bands of the parameters.");
+
+    const array <int64, numStages>& getStageTicks() const { return _stageTicks; }
+    const array <int64, maxNumBands>& getBandTicks() const { return _bandTicks; }
+    void resetStageTicks() { _stageTicks.fill(0); _bandTicks.fill(0); }
+
+//==============================================================================================
+
+    AudioProcessorEditor* createEditor() override;
+
+    bool hasEditor() const override;
+
+//==============================================================================================
+
+    const String getName() const override;
+
+    bool acceptsMidi() const override;
+
+    bool producesMidi() const override;
+
+    bool isMidiEffect() const override;
+
+    double getTailLengthSeconds() const override;
+
+//==============================================================================================
+
+    int getNumPrograms() override;
+
+    int getCurrentProgram() override;
+
+    void setCurrentProgram(int index) override;
+
+    const String getProgramName(int index) override;
+
+    void changeProgramName(int index, const String& newName) override;
+
+//==============================================================================================
+
+    void getStateInformation(MemoryBlock& destinationData) override;
+
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    // The state is a compact binary preset (VstPreset); the ValueTree blobs of the older
+    // versions are still loaded. A preset parsed once can be applied to many instances
+    // (e.g. at a scene change) without allocation.
+
+    VstPreset getPreset() const;
+
+    void applyPreset(const VstPreset& preset);
+
+    // Creating a tree of audio parameter values.
+
+    using APVTS = AudioProcessorValueTreeState;
+
+    // Linking the value tree and the layout of the parameters display.
+
+    static APVTS::ParameterLayout createParameterLayout();
+    APVTS apvts{ *this, nullptr, "Parameters", createParameterLayout() };
+
+
+private:
+//==============================================================================================
+// The following are the elements of the compressor, Linkwitz filter.
+
+    // Define compressors of all bands (only the first _numBands of them are used).
+
+    array <VstCompressorBand, maxNumBands> _compressors;
+
+    size_t _numBands{ compressor_parameters::defaultNumBands };
+
+    // The DSP of both precisions: Linkwitz-Riley crossover, band compressors, oversampling,
+    // lookahead and gains. Only the chain of the processing precision is prepared and gets
+    // the settings; the host chooses the precision before prepareToPlay.
+
+    VstDspChain <float> _floatChain;
+    VstDspChain <double> _doubleChain;
+
+    template <typename SampleType>
+
+    VstDspChain <SampleType>& GetChain() noexcept
+    {
+        if constexpr (is_same_v <SampleType, double>)
+            return _doubleChain;
+        else
+            return _floatChain;
+    }
+
+    template <typename SampleType>
+    static void PrepareChain(VstDspChain <SampleType>& chain, const ProcessSpec& processSpec);
+
+    template <typename SampleType>
+    static void ReleaseChain(VstDspChain <SampleType>& chain);
+
+    // Calls the function with the chain of the processing precision.
+
+    template <typename Function>
+
+    decltype(auto) ForChain(Function&& function)
+    {
+        return isUsingDoublePrecision() ? function(_doubleChain) : function(_floatChain);
+    }
+
+    template <typename Function>
+
+    decltype(auto) ForChain(Function&& function) const
+    {
+        return isUsingDoublePrecision() ? function(_doubleChain) : function(_floatChain);
+    }
+
+    // Optional oversampling of the compressors (all bands together). The buffers are
+    // prepared for the largest factor, so the factor can change without allocation; the
+    // latency of the filters is reported to the host.
+
+    size_t GetOversamplingFactor() const;
+
+    static size_t OversamplingOf(const ParameterSnapshot::Values& values);
+    static VstOversamplerBase::Quality OversamplingQualityOf(const ParameterSnapshot::Values& values);
+    void SetOversampling(size_t factor, VstOversamplerBase::Quality quality);
+
+    // Linear-phase split of the bands instead of the Linkwitz-Riley crossover. Its latency is
+    // reported; a switch restarts the bands, which fade in.
+
+    bool _linearPhase{ false };
+
+    void SetLinearPhase(bool isLinearPhase);
+
+    // Lookahead of the compressors, at the rate of the compressors. While a band has one, the
+    // audio of all bands is delayed by the longest lookahead of the parameter (whole samples of
+    // the host rate), so the automation only changes the windows; the keys of the detectors are
+    // written into the key buffer. Without lookahead there is no delay.
+
+    void UpdateLookahead();
+
+    // The latency of the linear-phase split, the oversampling and the lookahead. The audio
+    // thread only stores it; prepareToPlay and the timer on the message thread report it.
+
+    static constexpr int latencyTimerHz = 10;
+
+    atomic <int> _latencySamples{ 0 };
+
+    void UpdateLatency();
+    void timerCallback() override;
+
+    // Values of all parameters for the audio thread.
+
+    ParameterSnapshot _parameters{ apvts };
+
+    // Parameter objects of the presets.
+
+    VstPresetParameters _presetParameters{ apvts };
+
+    void UpdateParameters();
+
+    // A new number of bands changes the topology: the states restart and the bands fade in.
+
+    static size_t NumBandsOf(const ParameterSnapshot::Values& values);
+    void SetNumBands(size_t numBands);
+
+    // Smoothing of the automation of the crossovers and thresholds.
+
+    static constexpr double smoothingSeconds = 0.05;
+
+    array <SmoothedValue <float, ValueSmoothingTypes::Multiplicative>, compressor_parameters::maxNumCrossovers> _cutoffs;
+
+    atomic <int> _controlRate{ 32 };
+
+    bool IsSmoothing() const;
+    void AdvanceSmoothing(int numSamples);
+
+    // The crossover gets the current cutoffs in ascending order.
+
+    void ApplyCutoffs();
+
+    // Plan of the block: bands that are heard (solo, mute) fade in and out, bands that are
+    // not heard are not computed, and a fully neutral setting passes the input untouched.
+
+    static constexpr double fadeSeconds = 0.005;
+
+    array <SmoothedValue <float>, maxNumBands> _bandLevels;
+    SmoothedValue <float> _wetLevel;
+
+    uint32 GetAudibleBands() const;
+    bool IsPassthrough(uint32 audibleBands) const;
+    uint32 PlanBands(uint32 audibleBands);
+
+    // Sidechain: an optional second input bus, split by the same crossover in the same pass
+    // as the input. Bands with their sidechain switch on detect on their band of the sidechain
+    // (when the bus has channels), the other ones on themselves.
+
+    uint32 _keyedBands{ 0 };
+
+    uint32 GetKeyedBands() const;
+
+    template <typename SampleType>
+    void PrepareSidechainKeys(const AudioBlock <SampleType>& sidechainBands, size_t factor);
+
+    // Idle sleep: below this peak the input counts as silence. The processor falls asleep
+    // when the input has been silent for the tail length, and wakes up on the first block
+    // that is not silent.
+
+    static constexpr float silenceThreshold = 1.0e-6f;
+
+    atomic <double> _tailSeconds{ 0.0 };
+    int64 _silentSamples{ 0 };
+    atomic <bool> _isSleeping{ false };
+
+    static double TailSeconds(const ParameterSnapshot::Values& values);
+    template <typename SampleType>
+    static bool IsSilent(const AudioBuffer <SampleType>& buffer, int numChannels);
+
+    template <typename SampleType>
+    bool UpdateSleep(const AudioBuffer <SampleType>& buffer, int numChannels);
+
+    // Both overloads of processBlock run the same code on their own chain.
+
+    template <typename SampleType>
+    void ProcessBlock(AudioBuffer <SampleType>& buffer);
+
+    // Splitting of the signal into the band buffers and their summation.
+    // Both work on a part of the host block that fits into the prepared buffers.
+
+    template <typename SampleType>
+    void ProcessPart(AudioBlock <SampleType>& block, const AudioBlock <const SampleType>& sidechain, uint32 activeBands);
+
+    template <typename SampleType>
+    void SplitIntoBands(const AudioBlock <SampleType>& block, AudioBlock <SampleType>& bands);
+
+    template <typename SampleType>
+    void SplitIntoBands(const AudioBlock <SampleType>& block, const AudioBlock <const SampleType>& sidechain,
+                        AudioBlock <SampleType>& bands, AudioBlock <SampleType>& sidechainBands);
+
+    // Lookahead and compressors of the band channels firstChannel ... in the block. A task of
+    // the parallel processing is not timed, and the lookahead is advanced after all tasks.
+
+    template <typename SampleType>
+    void CompressBands(AudioBlock <SampleType>& bands, size_t numChannels, size_t firstChannel = 0, bool isParallelTask = false);
+
+    // Parallel processing: the band channels are cut into tasks of whole registers (of whole
+    // bands with linked channels or on the scalar path), which share no state.
+
+    bool IsParallel(size_t partSize) const;
+
+    template <typename SampleType>
+    void CompressBandsInParallel(AudioBlock <SampleType>& bands, size_t numChannels);
+
+    template <typename SampleType>
+    void SumBands(AudioBlock <SampleType>& block, const AudioBlock <SampleType>& bands, uint32 activeBands);
+
+    template <typename SampleType>
+    void MixDry(AudioBlock <SampleType>& block, const AudioBlock <SampleType>& dryBlock);
+
+    // Metering of the bands, published to the editor.
+
+    atomic <bool> _metering{ false };
+    VstMeteringBus _meteringBus;
+
+    VstSpectrumAnalyzer _spectrumAnalyzer;
+
+    // Tracing of the blocks, and the modes of the bands in a traced block.
+
+    VstBlockTracer _blockTracer;
+
+    uint32 TraceModes() const;
+
+    template <typename SampleType>
+    void TraceBlock(AudioBuffer <SampleType>& buffer);
+
+    // Settings of the fused engine.
+
+    atomic <bool> _fusedProcessing{ false };
+    atomic <int> _fusedSubBlockSize{ 32 };
+
+    atomic <bool> _scalarCompression{ false };
+
+    // Settings of the parallel processing and its workers.
+
+    atomic <bool> _parallelProcessing{ false };
+    atomic <int> _parallelWorkers{ 3 };
+    atomic <int> _parallelMinBlockSize{ 1024 };
+
+    VstWorkerPool _workerPool;
+
+    // Accumulated time of the stages (high resolution ticks).
+
+    array <int64, numStages> _stageTicks{};
+    array <int64, maxNumBands> _bandTicks{};
+
+    struct ScopedStageTimer
+    {
+#if ECLISTAR_STAGE_TIMING
+        explicit ScopedStageTimer(int64& ticks, bool isEnabled = true) noexcept
+            : _ticks(isEnabled ? &ticks : nullptr), _start(Time::getHighResolutionTicks()) {}
+
+        ~ScopedStageTimer() noexcept
+        {
+            if (_ticks != nullptr)
+                *_ticks += Time::getHighResolutionTicks() - _start;
+        }
+
+        int64* _ticks;
+        int64 _start;
+#else
+        explicit ScopedStageTimer(int64&, bool = true) noexcept {}
+#endif
+    };
+
+    // Apply the gain & gain context.
+
+    template <typename SampleType>
+
+    void ApplyGain(AudioBlock <SampleType>& block, Gain <SampleType>& gain)
+    {
+        // Unity gain is skipped (the multiplication would not change the samples).
+
+        if (!gain.isSmoothing() && gain.getGainLinear() == (SampleType)1)
+            return;
+
+        auto context = ProcessContextReplacing <SampleType>(block);
+
+        gain.process(context);
+    }
+
+//==============================================================================================
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EclistarVSTAudioProcessor)
+};
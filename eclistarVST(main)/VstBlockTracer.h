@@ -0,0 +1,478 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "VstServiceThread.h"
+#include "VstTripleBuffer.h"
+
+using namespace juce;
+using namespace std;
+
+//==============================================================================================
+// Tracing of processBlock: how long every block took against its real-time budget.
+//
+// While tracing is on, the audio thread writes one record per block (the elapsed high
+// resolution ticks, the number of samples and the modes of the bands) into a single-producer,
+// single-consumer FIFO of its instance (AbstractFifo over a fixed array of records): no lock,
+// no allocation, and a full FIFO only counts the record as dropped. While it is off, the only
+// cost is the test of one flag per block.
+//
+// The records are aggregated on one background thread shared by all instances in the process
+// (VstServiceThread), every serviceIntervalMs: a histogram of the durations (VstLatencyHistogram), the
+// blocks that took longer than their duration at the sample rate (deadline misses, counted
+// per mode too), the mean and the worst load. The report goes to the editor through a triple
+// buffer (VstTripleBuffer), and it is written as JSON to the report file (if there is one) every reportIntervalMs
+// and when tracing stops.
+
+//==============================================================================================
+// Histogram of durations in nanoseconds with a constant relative precision (as HdrHistogram):
+// the values below 2 * subBucketCount have their own counts, above that every power of two is
+// cut into subBucketCount counts, so a value is known within 1 / subBucketCount (6%) up to
+// 2^maxBits ns (18 minutes).
+
+class VstLatencyHistogram
+{
+public:
+
+    static constexpr int subBucketBits = 4;
+    static constexpr int maxBits = 40;
+
+    static constexpr uint64 subBucketCount = (uint64)1 << subBucketBits;
+    static constexpr int maxShift = maxBits - subBucketBits - 1;
+    static constexpr size_t numCounts = (size_t)(maxShift + 2) * (size_t)subBucketCount;
+
+    void add(uint64 value) noexcept
+    {
+        value = jmin(value, ((uint64)1 << maxBits) - 1);
+
+        ++_counts[IndexOf(value)];
+        ++_totalCount;
+
+        _max = jmax(_max, value);
+    }
+
+    void clear() noexcept
+    {
+        _counts.fill(0);
+        _totalCount = 0;
+        _max = 0;
+    }
+
+    uint64 getTotalCount() const noexcept { return _totalCount; }
+    uint64 getMax() const noexcept { return _max; }
+
+    // Highest value of the count that holds the percentile (at most the largest value).
+
+    uint64 getValueAtPercentile(double percentile) const noexcept
+    {
+        if (_totalCount == 0)
+            return 0;
+
+        auto target = jmax((uint64)1, (uint64)std::ceil(jlimit(0.0, 100.0, percentile) / 100.0 * (double)_totalCount));
+        uint64 count = 0;
+
+        for (size_t index = 0; index < numCounts; ++index)
+        {
+            count += _counts[index];
+
+            if (count >= target)
+                return jmin(_max, HighestValueOf(index));
+        }
+
+        return _max;
+    }
+
+    // The counts that are not empty, with the lowest and the highest value of each.
+
+    template <typename Visitor>
+
+    void visitCounts(Visitor&& visitor) const
+    {
+        for (size_t index = 0; index < numCounts; ++index)
+        {
+            if (_counts[index] != 0)
+            {
+                visitor(LowestValueOf(index), HighestValueOf(index), _counts[index]);
+            }
+        }
+    }
+
+private:
+
+    static size_t IndexOf(uint64 value) noexcept
+    {
+        auto shift = 0;
+
+        while ((value >> shift) >= 2 * subBucketCount)
+        {
+            ++shift;
+        }
+
+        return (size_t)((uint64)(shift + 1) * subBucketCount + (value >> shift) - subBucketCount);
+    }
+
+    static uint64 LowestValueOf(size_t index) noexcept
+    {
+        if (index < 2 * subBucketCount)
+            return (uint64)index;
+
+        auto shift = (int)(index / subBucketCount) - 1;
+
+        return ((uint64)index % subBucketCount + subBucketCount) << shift;
+    }
+
+    static uint64 HighestValueOf(size_t index) noexcept
+    {
+        auto shift = index < 2 * subBucketCount ? 0 : (int)(index / subBucketCount) - 1;
+
+        return LowestValueOf(index) + ((uint64)1 << shift) - 1;
+    }
+
+    array <uint64, numCounts> _counts{};
+
+    uint64 _totalCount{ 0 };
+    uint64 _max{ 0 };
+};
+
+//==============================================================================================
+
+class VstBlockTracer
+{
+public:
+
+    static constexpr int capacity = 4096;
+
+    // The thread of the tracers (VstServiceThread), and the interval of the report file.
+
+    static constexpr const char* serviceThreadName = "Eclistar trace";
+    static constexpr int serviceIntervalMs = 50;
+    static constexpr int reportIntervalMs = 1000;
+
+    // Modes of the bands during a block (any band soloed, muted, bypassed, or the processor
+    // asleep), as bits of a record.
+
+    enum Mode
+    {
+        soloMode,
+        muteMode,
+        bypassMode,
+        sleepMode,
+
+        numModes
+    };
+
+    static constexpr uint32 modeBit(Mode mode) noexcept { return 1u << (uint32)mode; }
+
+    // Aggregates since tracing was turned on (durations in microseconds, loads as the duration
+    // over the budget of the block).
+
+    struct Report
+    {
+        uint64 numBlocks{ 0 };
+        uint64 numDeadlineMisses{ 0 };
+        uint64 numDropped{ 0 };
+
+        array <uint64, numModes> deadlineMissesInMode{};
+
+        double meanMicroseconds{ 0.0 };
+        double p50Microseconds{ 0.0 };
+        double p90Microseconds{ 0.0 };
+        double p99Microseconds{ 0.0 };
+        double p999Microseconds{ 0.0 };
+        double maxMicroseconds{ 0.0 };
+
+        double meanLoad{ 0.0 };
+        double maxLoad{ 0.0 };
+
+        int worstBlockSize{ 0 };
+        uint32 worstBlockModes{ 0 };
+
+        String toString() const
+        {
+            return "blocks " + String((int64)numBlocks)
+                 + ", p50 " + String(p50Microseconds, 1) + " us, p99 " + String(p99Microseconds, 1)
+                 + " us, max " + String(maxMicroseconds, 1) + " us, load " + String(meanLoad * 100.0, 1)
+                 + "% (max " + String(maxLoad * 100.0, 1) + "%), deadline misses " + String((int64)numDeadlineMisses)
+                 + (numDropped > 0 ? ", dropped " + String((int64)numDropped) : String());
+        }
+    };
+
+    VstBlockTracer() = default;
+
+    ~VstBlockTracer()
+    {
+        setEnabled(false);
+    }
+
+    // Audio side: the sample rate of the budgets (called before playing), and the records.
+
+    void prepare(double sampleRate)
+    {
+        _sampleRate.store(sampleRate, memory_order_relaxed);
+    }
+
+    bool isEnabled() const noexcept
+    {
+        return _enabled.load(memory_order_relaxed);
+    }
+
+    // The block that started at startTicks (Time::getHighResolutionTicks) ends now.
+
+    void add(int64 startTicks, int numSamples, uint32 modes) noexcept
+    {
+        auto elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+
+        int start1, size1, start2, size2;
+        _fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+        {
+            _numDropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+
+        _records[(size_t)start1] = { elapsedTicks, numSamples, modes };
+        _fifo.finishedWrite(1);
+    }
+
+    // Message thread: tracing starts from empty aggregates; with a report file, the report is
+    // written there while tracing and when it stops.
+
+    void setEnabled(bool shouldBeEnabled, const File& reportFile = File())
+    {
+        if (shouldBeEnabled == _isServed)
+            return;
+
+        _isServed = shouldBeEnabled;
+
+        if (shouldBeEnabled)
+        {
+            _reportFile = reportFile;
+
+            _thread->add(this);
+            _enabled.store(true, memory_order_relaxed);
+        }
+        else
+        {
+            _enabled.store(false, memory_order_relaxed);
+            _thread->remove(this);
+
+            // The thread does not visit this tracer any more.
+
+            Aggregate();
+            WriteReport();
+        }
+    }
+
+    // Editor: the latest report (false if there is no new one).
+
+    bool read(Report& report) noexcept
+    {
+        return _reports.read(report);
+    }
+
+private:
+
+    friend class VstServiceThread <VstBlockTracer>;
+
+    struct Record
+    {
+        int64 elapsedTicks;
+        int numSamples;
+        uint32 modes;
+    };
+
+    // Background side, with the lock of the thread held.
+
+    void Restart()
+    {
+        int start1, size1, start2, size2;
+        _fifo.prepareToRead(_fifo.getNumReady(), start1, size1, start2, size2);
+        _fifo.finishedRead(size1 + size2);
+
+        _numDropped.store(0, memory_order_relaxed);
+
+        _histogram.clear();
+        _report = {};
+        _totalNanoseconds = 0.0;
+        _totalBudget = 0.0;
+        _lastReportTime = Time::getMillisecondCounter();
+    }
+
+    void Serve()
+    {
+        Aggregate();
+        UpdateReportFile();
+    }
+
+    void Aggregate()
+    {
+        int start1, size1, start2, size2;
+        _fifo.prepareToRead(_fifo.getNumReady(), start1, size1, start2, size2);
+
+        if (size1 + size2 > 0)
+        {
+            for (auto i = 0; i < size1; ++i)
+            {
+                AddRecord(_records[(size_t)(start1 + i)]);
+            }
+
+            for (auto i = 0; i < size2; ++i)
+            {
+                AddRecord(_records[(size_t)(start2 + i)]);
+            }
+
+            _fifo.finishedRead(size1 + size2);
+
+            Publish();
+        }
+    }
+
+    void AddRecord(const Record& record)
+    {
+        auto nanoseconds = (double)record.elapsedTicks * 1.0e9 / (double)Time::getHighResolutionTicksPerSecond();
+        auto budget = (double)record.numSamples * 1.0e9 / jmax(1.0, _sampleRate.load(memory_order_relaxed));
+        auto load = nanoseconds / jmax(1.0, budget);
+
+        _histogram.add((uint64)jmax(0.0, nanoseconds));
+
+        ++_report.numBlocks;
+        _totalNanoseconds += nanoseconds;
+        _totalBudget += budget;
+
+        if (nanoseconds > budget)
+        {
+            ++_report.numDeadlineMisses;
+
+            for (size_t mode = 0; mode < numModes; ++mode)
+            {
+                if ((record.modes & modeBit((Mode)mode)) != 0)
+                {
+                    ++_report.deadlineMissesInMode[mode];
+                }
+            }
+        }
+
+        if (load > _report.maxLoad)
+        {
+            _report.maxLoad = load;
+            _report.worstBlockSize = record.numSamples;
+            _report.worstBlockModes = record.modes;
+        }
+    }
+
+    void Publish()
+    {
+        auto Microseconds = [this](double percentile)
+        {
+            return (double)_histogram.getValueAtPercentile(percentile) / 1000.0;
+        };
+
+        _report.numDropped = (uint64)_numDropped.load(memory_order_relaxed);
+
+        _report.meanMicroseconds = _totalNanoseconds / 1000.0 / (double)jmax((uint64)1, _report.numBlocks);
+        _report.p50Microseconds = Microseconds(50.0);
+        _report.p90Microseconds = Microseconds(90.0);
+        _report.p99Microseconds = Microseconds(99.0);
+        _report.p999Microseconds = Microseconds(99.9);
+        _report.maxMicroseconds = (double)_histogram.getMax() / 1000.0;
+        _report.meanLoad = _totalNanoseconds / jmax(1.0, _totalBudget);
+
+        _reports.getBack() = _report;
+        _reports.publish();
+    }
+
+    // Every reportIntervalMs (and when tracing stops) the report goes to the report file.
+
+    void UpdateReportFile()
+    {
+        auto now = Time::getMillisecondCounter();
+
+        if (now - _lastReportTime < (uint32)reportIntervalMs)
+            return;
+
+        _lastReportTime = now;
+        WriteReport();
+    }
+
+    void WriteReport() const
+    {
+        if (_reportFile == File())
+            return;
+
+        DynamicObject::Ptr report = new DynamicObject();
+
+        report->setProperty("sampleRate", _sampleRate.load(memory_order_relaxed));
+        report->setProperty("blocks", (int64)_report.numBlocks);
+        report->setProperty("deadlineMisses", (int64)_report.numDeadlineMisses);
+        report->setProperty("dropped", (int64)_report.numDropped);
+
+        const char* const modeNames[numModes] = { "solo", "mute", "bypass", "sleep" };
+        DynamicObject::Ptr missesInMode = new DynamicObject();
+
+        for (size_t mode = 0; mode < numModes; ++mode)
+        {
+            missesInMode->setProperty(modeNames[mode], (int64)_report.deadlineMissesInMode[mode]);
+        }
+
+        report->setProperty("deadlineMissesInMode", var(missesInMode.get()));
+        report->setProperty("meanMicroseconds", _report.meanMicroseconds);
+        report->setProperty("p50Microseconds", _report.p50Microseconds);
+        report->setProperty("p90Microseconds", _report.p90Microseconds);
+        report->setProperty("p99Microseconds", _report.p99Microseconds);
+        report->setProperty("p999Microseconds", _report.p999Microseconds);
+        report->setProperty("maxMicroseconds", _report.maxMicroseconds);
+        report->setProperty("meanLoad", _report.meanLoad);
+        report->setProperty("maxLoad", _report.maxLoad);
+        report->setProperty("worstBlockSize", _report.worstBlockSize);
+        report->setProperty("worstBlockModes", (int)_report.worstBlockModes);
+
+        // The histogram: [lowest ns, highest ns, count] of every count that is not empty.
+
+        Array <var> histogram;
+
+        _histogram.visitCounts([&histogram](uint64 lowest, uint64 highest, uint64 count)
+        {
+            histogram.add(Array <var>{ (int64)lowest, (int64)highest, (int64)count });
+        });
+
+        report->setProperty("histogramNanoseconds", histogram);
+
+        _reportFile.replaceWithText(JSON::toString(var(report.get())));
+    }
+
+    //------------------------------------------------------------------
+
+    // Written by the audio thread.
+
+    atomic <bool> _enabled{ false };
+    atomic <double> _sampleRate{ 44100.0 };
+
+    array <Record, (size_t)capacity> _records{};
+    AbstractFifo _fifo{ capacity };
+
+    atomic <int64> _numDropped{ 0 };
+
+    // Aggregation.
+
+    VstLatencyHistogram _histogram;
+    Report _report;
+
+    double _totalNanoseconds{ 0.0 };
+    double _totalBudget{ 0.0 };
+
+    uint32 _lastReportTime{ 0 };
+
+    // Triple buffer of the reports: the aggregation writes the back one, the editor reads the
+    // front one.
+
+    VstTripleBuffer <Report> _reports;
+
+    // Message thread.
+
+    bool _isServed{ false };
+    File _reportFile;
+
+    SharedResourcePointer <VstServiceThread <VstBlockTracer>> _thread;
+
+    JUCE_DECLARE_NON_COPYABLE(VstBlockTracer)
+};
@@ -0,0 +1,597 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+using namespace dsp;
+using namespace std;
+
+#if ! JUCE_USE_SIMD
+ #error "VstCrossover needs juce::dsp::SIMDRegister (SSE or NEON)."
+#endif
+
+//==============================================================================================
+// Prewarped gains g = tan(pi * cutoff / sampleRate) of the crossover points, shared by all
+// crossovers in the process (SharedResourcePointer).
+//
+// The cutoff parameters move in steps of 1 Hz, so the table of a sample rate holds g for every
+// whole frequency from 0 to 20 kHz (at most 0.49 of the rate, where the crossover limits the
+// cutoff), computed with the same expression as the crossover used: a settled cutoff gets
+// exactly the same coefficients. The smoothed cutoffs between two whole frequencies are
+// interpolated linearly (relative error below 1e-7, the precision of float, from 44.1 kHz up);
+// other cutoffs are computed with std::tan.
+//
+// A table is built by prepare() on the message thread, the first time its sample rate is used
+// in the process, and never changes afterwards: the audio threads of all instances read it
+// without a lock. A session of 100 instances at one rate shares one table of 160 kB, and a
+// moved crossover is a lookup instead of a tan().
+
+class VstCrossoverTables
+{
+public:
+
+    static constexpr int maxFrequency = 20000;
+
+    class Table
+    {
+    public:
+
+        explicit Table(double sampleRate)
+            : _sampleRate(sampleRate), _maxIndex(jmin(maxFrequency, (int)(0.49 * sampleRate)))
+        {
+            _gains.resize((size_t)_maxIndex + 1);
+
+            for (int frequency = 0; frequency <= _maxIndex; ++frequency)
+            {
+                _gains[(size_t)frequency] = exactGainOf(sampleRate, (float)frequency);
+            }
+        }
+
+        double getSampleRate() const noexcept { return _sampleRate; }
+        size_t getSizeInBytes() const noexcept { return _gains.size() * sizeof(double); }
+
+        double gainOf(float cutoff) const noexcept
+        {
+            auto position = (double)cutoff;
+
+            if (position >= 0.0 && position < (double)_maxIndex)
+            {
+                auto index = (size_t)position;
+                auto fraction = position - (double)index;
+                auto gain = _gains[index];
+
+                return fraction == 0.0 ? gain : gain + fraction * (_gains[index + 1] - gain);
+            }
+
+            return exactGainOf(_sampleRate, cutoff);
+        }
+
+    private:
+
+        double _sampleRate;
+        int _maxIndex;
+
+        vector <double> _gains;
+    };
+
+    static double exactGainOf(double sampleRate, float cutoff) noexcept
+    {
+        auto limitedCutoff = jmin((double)cutoff, 0.49 * sampleRate);
+
+        return std::tan(MathConstants <double>::pi * limitedCutoff / sampleRate);
+    }
+
+    // Message thread: the table of the sample rate, built the first time.
+
+    const Table& getTable(double sampleRate)
+    {
+        const ScopedLock lock(_lock);
+
+        for (auto& table : _tables)
+        {
+            if (table->getSampleRate() == sampleRate)
+                return *table;
+        }
+
+        _tables.push_back(make_unique <Table>(sampleRate));
+
+        return *_tables.back();
+    }
+
+    size_t getNumTables() const
+    {
+        const ScopedLock lock(_lock);
+
+        return _tables.size();
+    }
+
+private:
+
+    CriticalSection _lock;
+    vector <unique_ptr <Table>> _tables;
+};
+
+//==============================================================================================
+// Linkwitz-Riley (4th order) crossover with 2 to 8 bands.
+//
+// The bands are split as a tree: the signal is split at the middle crossover, then each
+// half is split again at the middle of its own crossovers, and so on. A branch is passed
+// through the allpasses of the crossovers of the other branch, so all bands keep the same
+// phase and their sum stays flat. The allpass is applied once per branch (not per band),
+// which keeps the cost at O(N log N) sections. For three bands this is the five-filter
+// topology of the original version:
+//
+//      low  = allpass2(lowpass1(x))
+//      mid  = lowpass2(highpass1(x))
+//      high = highpass2(highpass1(x))
+//
+// The same TPT state-variable sections as in LinkwitzRileyFilter are used, but the first
+// section of each crossover point is shared by its low-pass and high-pass outputs (both
+// filters see the same input with the same coefficients). Channels are laid out in the
+// lanes of a SIMDRegister, one register per group of SIMDRegister::size() channels, so all
+// channels of a group run in one pass.
+//
+// The bands are written into one block of numBands * numChannels channels: band b,
+// channel c is the channel b * numChannels + c.
+//
+// Bands that are not needed (muted, or not soloed) can be left out with setActiveBands():
+// only the sections that feed the active bands are computed. The sections that were left
+// out are cleared when they are needed again, so they start from silence instead of from
+// a stale state; the processor fades such a band in.
+//
+// The sample type is float or double. With double the coefficients keep their precision
+// for low cutoffs at high sample rates, and a register holds half as many channels.
+//
+// A sidechain can be split in the same pass: its channels take the lanes after the channels
+// of the input, so it shares the coefficients, the tree and the loop over the frames. With a
+// stereo input and a stereo sidechain in one register of float it costs almost nothing. The
+// crossover is then prepared for the channels of both.
+
+template <typename SampleType>
+class VstCrossover
+{
+public:
+
+    using Lane = SIMDRegister <SampleType>;
+
+    static constexpr size_t maxNumBands = 8;
+    static constexpr size_t maxNumCrossovers = maxNumBands - 1;
+
+    // Functions of the crossover itself.
+
+    void prepare(const ProcessSpec& process_spec)
+    {
+        _sampleRate = process_spec.sampleRate;
+        _numChannels = process_spec.numChannels;
+
+        _sections.resize(((_numChannels + Lane::size() - 1) / Lane::size()) * maxNumSections);
+
+        _table = &_tables->getTable(_sampleRate);
+
+        for (size_t crossover = 0; crossover < maxNumCrossovers; ++crossover)
+        {
+            _coefficients[crossover].update(GainOf(_cutoffs[crossover]));
+        }
+
+        setNumBands(_numBands);
+    }
+
+    void reset()
+    {
+        for (auto& section : _sections)
+        {
+            section = {};
+        }
+    }
+
+    // Number of bands (no allocation, the states are cleared).
+
+    void setNumBands(size_t numBands) noexcept
+    {
+        jassert(numBands >= 2 && numBands <= maxNumBands);
+
+        _numBands = jlimit((size_t)2, maxNumBands, numBands);
+        _numOperations = 0;
+        _numSections = 0;
+
+        BuildTree(0, _numBands - 1);
+
+        _activeBands = AllBands();
+        UpdateActiveOperations();
+
+        reset();
+    }
+
+    size_t getNumBands() const noexcept { return _numBands; }
+
+    // Bands to compute (bit 0 is the lowest band). Outputs of the other bands are not written.
+
+    void setActiveBands(uint32 bandMask) noexcept
+    {
+        bandMask &= AllBands();
+
+        for (size_t i = 0; i < _numOperations; ++i)
+        {
+            const auto& operation = _operations[i];
+
+            for (size_t section = 0; section < operation.numSections(); ++section)
+            {
+                if (operation.isSectionNeeded(section, bandMask) && !operation.isSectionNeeded(section, _activeBands))
+                {
+                    ClearSection(operation.firstSection + section);
+                }
+            }
+        }
+
+        _activeBands = bandMask;
+        UpdateActiveOperations();
+    }
+
+    uint32 getActiveBands() const noexcept { return _activeBands; }
+
+    // Cutoffs of the numBands - 1 crossovers, in ascending order.
+
+    void setCutoffFrequencies(const float* cutoffs)
+    {
+        for (size_t crossover = 0; crossover + 1 < _numBands; ++crossover)
+        {
+            jassert(cutoffs[crossover] > 0);
+            jassert(crossover == 0 || cutoffs[crossover] >= cutoffs[crossover - 1]);
+
+            if (cutoffs[crossover] != _cutoffs[crossover])
+            {
+                _cutoffs[crossover] = cutoffs[crossover];
+                _coefficients[crossover].update(GainOf(_cutoffs[crossover]));
+            }
+        }
+    }
+
+    // Splitting of the input into the bands. The bands must not alias the input.
+
+    void process(const AudioBlock <const SampleType>& input, AudioBlock <SampleType>& bands) noexcept
+    {
+        auto numChannels = input.getNumChannels();
+
+        jassert(bands.getNumChannels() >= _numBands * numChannels && bands.getNumSamples() == input.getNumSamples());
+
+        Process(numChannels, input.getNumSamples(),
+                [&](size_t channel) { return input.getChannelPointer(channel); },
+                [&](size_t band, size_t channel) { return bands.getChannelPointer(band * numChannels + channel); });
+    }
+
+    // Splitting of the input and of a sidechain (same number of samples) in one pass; the
+    // bands of the sidechain are in the same layout as the ones of the input.
+
+    void process(const AudioBlock <const SampleType>& input, const AudioBlock <const SampleType>& sidechain,
+                 AudioBlock <SampleType>& bands, AudioBlock <SampleType>& sidechainBands) noexcept
+    {
+        auto numChannels = input.getNumChannels();
+        auto numSidechainChannels = sidechain.getNumChannels();
+
+        jassert(bands.getNumChannels() >= _numBands * numChannels && bands.getNumSamples() == input.getNumSamples());
+        jassert(sidechainBands.getNumChannels() >= _numBands * numSidechainChannels);
+        jassert(sidechain.getNumSamples() == input.getNumSamples() && sidechainBands.getNumSamples() == input.getNumSamples());
+
+        Process(numChannels + numSidechainChannels, input.getNumSamples(),
+                [&](size_t channel)
+                {
+                    return channel < numChannels ? input.getChannelPointer(channel)
+                                                 : sidechain.getChannelPointer(channel - numChannels);
+                },
+                [&](size_t band, size_t channel)
+                {
+                    return channel < numChannels ? bands.getChannelPointer(band * numChannels + channel)
+                                                 : sidechainBands.getChannelPointer(band * numSidechainChannels + channel - numChannels);
+                });
+    }
+
+    // Cleaning of the states from values at the level of denormals.
+
+    void snapToZero() noexcept
+    {
+        for (auto& section : _sections)
+        {
+            section.snapToZero();
+        }
+    }
+
+private:
+
+    // Channels 0 ... numChannels - 1 of the groups: inputOf(channel) gives the input of a
+    // channel, outputOf(band, channel) its output in the band.
+
+    template <typename InputOf, typename OutputOf>
+
+    void Process(size_t numChannels, size_t numSamples, InputOf&& inputOf, OutputOf&& outputOf) noexcept
+    {
+        jassert(numChannels <= _numChannels);
+
+        if (_activeBands == 0)
+            return;
+
+        for (size_t first = 0; first < numChannels; first += Lane::size())
+        {
+            auto* sections = &_sections[(first / Lane::size()) * maxNumSections];
+            auto numLanes = jmin(Lane::size(), numChannels - first);
+
+            // Channel pointers of the group.
+
+            const SampleType* inputs[Lane::size()] = {};
+            SampleType* outputs[maxNumBands][Lane::size()] = {};
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                inputs[lane] = inputOf(first + lane);
+
+                for (size_t band = 0; band < _numBands; ++band)
+                {
+                    outputs[band][lane] = outputOf(band, first + lane);
+                }
+            }
+
+            alignas(sizeof(Lane)) SampleType frame[Lane::size()] = {};
+            Lane slots[maxNumBands];
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    frame[lane] = inputs[lane][i];
+                }
+
+                slots[0] = Lane::fromRawArray(frame);
+
+                ProcessFrame(sections, slots);
+
+                for (size_t band = 0; band < _numBands; ++band)
+                {
+                    if ((_activeBands & (1u << band)) == 0)
+                        continue;
+
+                    slots[band].copyToRawArray(frame);
+
+                    for (size_t lane = 0; lane < numLanes; ++lane)
+                    {
+                        outputs[band][lane][i] = frame[lane];
+                    }
+                }
+            }
+        }
+    }
+
+    // Coefficients of one crossover point (the same as in LinkwitzRileyFilter), from the
+    // prewarped gain of its cutoff (the shared table before the crossover is prepared).
+
+    double GainOf(float cutoff) const noexcept
+    {
+        return _table != nullptr ? _table->gainOf(cutoff) : VstCrossoverTables::exactGainOf(_sampleRate, cutoff);
+    }
+
+    struct Coefficients
+    {
+        Lane g, h, R2, R2plusG;
+
+        void update(double gain)
+        {
+            auto gValue = (SampleType)gain;
+            auto R2Value = (SampleType)std::sqrt(2.0);
+            auto hValue = (SampleType)(1.0 / (1.0 + R2Value * gValue + gValue * gValue));
+
+            g = Lane::expand(gValue);
+            h = Lane::expand(hValue);
+            R2 = Lane::expand(R2Value);
+            R2plusG = Lane::expand(R2Value + gValue);
+        }
+    };
+
+    // One TPT state-variable section for a group of channels.
+
+    struct Section
+    {
+        Lane s1 = Lane::expand((SampleType)0);
+        Lane s2 = Lane::expand((SampleType)0);
+
+        void process(const Coefficients& c, Lane x, Lane& yL, Lane& yB, Lane& yH) noexcept
+        {
+            yH = (x - c.R2plusG * s1 - s2) * c.h;
+
+            yB = c.g * yH + s1;
+            s1 = c.g * yH + yB;
+
+            yL = c.g * yB + s2;
+            s2 = c.g * yB + yL;
+        }
+
+        void snapToZero() noexcept
+        {
+            auto limit = Lane::expand((SampleType)1.0e-8);
+
+            s1 = s1 & Lane::greaterThan(Lane::abs(s1), limit);
+            s2 = s2 & Lane::greaterThan(Lane::abs(s2), limit);
+        }
+    };
+
+    // One step of the tree, working on the slots of a frame (slot b ends as band b).
+    //
+    // A split reads the slot "low" and writes its low-pass output back into it and its
+    // high-pass output into the slot "high"; it owns three sections (shared input, low,
+    // high). An allpass works in place on the slot "low" and owns one section.
+
+    struct Operation
+    {
+        bool isSplit{ false };
+        size_t crossover{ 0 };
+
+        size_t low{ 0 };
+        size_t high{ 0 };
+
+        uint32 lowBands{ 0 };
+        uint32 highBands{ 0 };
+
+        size_t firstSection{ 0 };
+
+        size_t numSections() const noexcept { return isSplit ? 3 : 1; }
+
+        bool isSectionNeeded(size_t section, uint32 bandMask) const noexcept
+        {
+            if (!isSplit || section == 0)
+                return ((lowBands | highBands) & bandMask) != 0;
+
+            return ((section == 1 ? lowBands : highBands) & bandMask) != 0;
+        }
+    };
+
+    struct ActiveOperation
+    {
+        size_t index{ 0 };
+
+        bool low{ false };
+        bool high{ false };
+    };
+
+    // The tree for 8 bands has 17 operations and 31 sections.
+
+    static constexpr size_t maxNumOperations = 32;
+    static constexpr size_t maxNumSections = 32;
+
+    uint32 AllBands() const noexcept { return (1u << _numBands) - 1; }
+
+    static uint32 BandsOf(size_t first, size_t last) noexcept
+    {
+        return ((1u << (last + 1)) - 1) & ~((1u << first) - 1);
+    }
+
+    // Bands first..last are split by the crossovers first..last - 1. The input is in the slot
+    // "first", the low half stays there, the high half goes to the slot of its first band.
+
+    void BuildTree(size_t first, size_t last) noexcept
+    {
+        if (first == last)
+            return;
+
+        auto split = first + (last - first - 1) / 2;
+
+        AddOperation(true, split, first, split + 1, BandsOf(first, split), BandsOf(split + 1, last));
+
+        for (auto crossover = split + 1; crossover < last; ++crossover)
+        {
+            AddOperation(false, crossover, first, first, BandsOf(first, split), 0);
+        }
+
+        for (auto crossover = first; crossover < split; ++crossover)
+        {
+            AddOperation(false, crossover, split + 1, split + 1, BandsOf(split + 1, last), 0);
+        }
+
+        BuildTree(first, split);
+        BuildTree(split + 1, last);
+    }
+
+    void AddOperation(bool isSplit, size_t crossover, size_t low, size_t high, uint32 lowBands, uint32 highBands) noexcept
+    {
+        jassert(_numOperations < maxNumOperations);
+
+        auto& operation = _operations[_numOperations++];
+
+        operation.isSplit = isSplit;
+        operation.crossover = crossover;
+        operation.low = low;
+        operation.high = high;
+        operation.lowBands = lowBands;
+        operation.highBands = highBands;
+        operation.firstSection = _numSections;
+
+        _numSections += operation.numSections();
+
+        jassert(_numSections <= maxNumSections);
+    }
+
+    void UpdateActiveOperations() noexcept
+    {
+        _numActiveOperations = 0;
+
+        for (size_t i = 0; i < _numOperations; ++i)
+        {
+            const auto& operation = _operations[i];
+
+            if (!operation.isSectionNeeded(0, _activeBands))
+                continue;
+
+            auto& active = _activeOperations[_numActiveOperations++];
+
+            active.index = i;
+            active.low = operation.isSectionNeeded(1, _activeBands);
+            active.high = operation.isSplit && operation.isSectionNeeded(2, _activeBands);
+        }
+    }
+
+    void ClearSection(size_t section) noexcept
+    {
+        for (size_t group = section; group < _sections.size(); group += maxNumSections)
+        {
+            _sections[group] = {};
+        }
+    }
+
+    // The steps depend only on the active bands, so they are the same for the whole block.
+
+    void ProcessFrame(Section* sections, Lane* slots) noexcept
+    {
+        Lane yL, yB, yH, unused1, unused2;
+
+        for (size_t i = 0; i < _numActiveOperations; ++i)
+        {
+            const auto& active = _activeOperations[i];
+            const auto& operation = _operations[active.index];
+            const auto& c = _coefficients[operation.crossover];
+
+            auto* section = sections + operation.firstSection;
+
+            // Phase alignment of a branch with a crossover point of the other branch.
+
+            if (!operation.isSplit)
+            {
+                section[0].process(c, slots[operation.low], yL, yB, yH);
+                slots[operation.low] = yL - c.R2 * yB + yH;
+
+                continue;
+            }
+
+            // Crossover point: shared first section, then low and high branches.
+
+            section[0].process(c, slots[operation.low], yL, yB, yH);
+
+            if (active.low)
+                section[1].process(c, yL, slots[operation.low], unused1, unused2);
+
+            if (active.high)
+                section[2].process(c, yH, unused1, unused2, slots[operation.high]);
+        }
+    }
+
+    //------------------------------------------------------------------
+
+    double _sampleRate{ 44100.0 };
+    size_t _numChannels{ 0 };
+
+    size_t _numBands{ 3 };
+
+    array <float, maxNumCrossovers> _cutoffs{ 400.0f, 2000.0f, 5000.0f, 8000.0f, 11000.0f, 14000.0f, 17000.0f };
+    array <Coefficients, maxNumCrossovers> _coefficients;
+
+    SharedResourcePointer <VstCrossoverTables> _tables;
+    const VstCrossoverTables::Table* _table{ nullptr };
+
+    array <Operation, maxNumOperations> _operations;
+    size_t _numOperations{ 0 };
+    size_t _numSections{ 0 };
+
+    array <ActiveOperation, maxNumOperations> _activeOperations;
+    size_t _numActiveOperations{ 0 };
+
+    uint32 _activeBands{ 7 };
+
+    // Sections of all channel groups, maxNumSections per group.
+
+    vector <Section> _sections;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+using namespace std;
+
+//==============================================================================================
+// Fast log2 and exp2 for the gain computer of the compressors.
+//
+// Both are branch-free: integer operations on the bits of the number, integer selects and a
+// short polynomial, so a loop over the lanes of a register is vectorized by the compiler,
+// unlike the calls of std::log2, std::exp2 or std::pow. (Selects of floats are avoided: with
+// the default trapping math the compilers keep them as branches.)
+//
+// log2: the exponent and a mantissa m in [sqrt(1/2), sqrt(2)) are taken from the bits, and
+// log2(m) = 2 / ln(2) * atanh((m - 1) / (m + 1)) is summed up to t^7. The error of the series
+// is below 5e-8 (in log2 units). Inputs below the smallest normal number (zero, denormals,
+// negative numbers) give the log2 of the smallest normal number.
+//
+// exp2: x = n + f with n the nearest integer (rounded by the addition of 1.5 * 2^mantissaBits)
+// and f in [-1/2, 1/2]; 2^f is the Taylor polynomial of exp(f ln(2)) up to f^6 (relative error
+// below 2e-7), and 2^n is written into the exponent. n is limited to the normal numbers, so
+// the result stays finite and normal (|x| must be below 2^(mantissaBits - 1)).
+//
+// As levels in decibels this is an error below 1e-5 dB for either function, for float and
+// double (the polynomials are the same, so double is not more precise). The gain computer
+// built on them is held to MultiBandCompressorSIMD::maxGainErrorDecibels.
+
+struct VstFastMath
+{
+    template <typename SampleType>
+
+    static SampleType log2(SampleType x) noexcept
+    {
+        using Traits = FloatTraits <SampleType>;
+        using Integer = typename Traits::Integer;
+
+        Integer bits;
+        memcpy(&bits, &x, sizeof(x));
+
+        bits = bits < Traits::minNormalBits ? Traits::minNormalBits : bits;
+
+        // x = 2^exponent * mantissa, with the mantissa in [sqrt(1/2), sqrt(2)).
+
+        auto exponent = (bits - Traits::sqrtHalfBits) >> Traits::mantissaBits;
+
+        bits -= exponent * ((Integer)1 << Traits::mantissaBits);
+
+        SampleType mantissa;
+        memcpy(&mantissa, &bits, sizeof(bits));
+
+        auto t = (mantissa - (SampleType)1) / (mantissa + (SampleType)1);
+        auto t2 = t * t;
+
+        auto series = (SampleType)2.8853900817779268
+                    + t2 * ((SampleType)0.9617966939259756
+                    + t2 * ((SampleType)0.5770780163555854
+                    + t2 * (SampleType)0.4121985831111324));
+
+        return (SampleType)exponent + t * series;
+    }
+
+    template <typename SampleType>
+
+    static SampleType exp2(SampleType x) noexcept
+    {
+        using Traits = FloatTraits <SampleType>;
+        using Integer = typename Traits::Integer;
+
+        constexpr auto rounding = (SampleType)(3 * ((Integer)1 << (Traits::mantissaBits - 1)));
+
+        // The nearest integer is in the low bits of the sum.
+
+        auto shifted = x + rounding;
+
+        Integer n;
+        memcpy(&n, &shifted, sizeof(shifted));
+
+        n -= Traits::roundingBits;
+        n = n < 1 - Traits::bias ? 1 - Traits::bias : n;
+        n = n > Traits::bias ? Traits::bias : n;
+
+        auto f = x - (shifted - rounding);
+
+        auto power = (SampleType)1
+                   + f * ((SampleType)0.6931471805599453
+                   + f * ((SampleType)0.2402265069591007
+                   + f * ((SampleType)0.05550410866482158
+                   + f * ((SampleType)0.009618129107628477
+                   + f * ((SampleType)0.0013333558146428443
+                   + f * (SampleType)0.00015403530393381608)))));
+
+        auto bits = (n + Traits::bias) << Traits::mantissaBits;
+
+        SampleType scale;
+        memcpy(&scale, &bits, sizeof(bits));
+
+        return power * scale;
+    }
+
+    // max(0, x) without a select: exact, as x + |x| is 2x or 0.
+
+    template <typename SampleType>
+
+    static SampleType positivePart(SampleType x) noexcept
+    {
+        return (x + std::abs(x)) * (SampleType)0.5;
+    }
+
+    // Decibels to log2 units and back (a factor, no transcendental function).
+
+    template <typename SampleType>
+
+    static constexpr SampleType decibelsToLog2(SampleType decibels) noexcept
+    {
+        return decibels * (SampleType)0.16609640474436813;
+    }
+
+    template <typename SampleType>
+
+    static constexpr SampleType log2ToDecibels(SampleType log2Value) noexcept
+    {
+        return log2Value * (SampleType)6.020599913279624;
+    }
+
+private:
+
+    template <typename SampleType>
+    struct FloatTraits;
+};
+
+template <>
+struct VstFastMath::FloatTraits <float>
+{
+    using Integer = int32;
+
+    static constexpr int mantissaBits = 23;
+    static constexpr Integer bias = 127;
+
+    static constexpr Integer minNormalBits = 0x00800000;
+    static constexpr Integer sqrtHalfBits = 0x3f3504f3;
+    static constexpr Integer roundingBits = 0x4b400000;
+};
+
+template <>
+struct VstFastMath::FloatTraits <double>
+{
+    using Integer = int64;
+
+    static constexpr int mantissaBits = 52;
+    static constexpr Integer bias = 1023;
+
+    static constexpr Integer minNormalBits = 0x0010000000000000ll;
+    static constexpr Integer sqrtHalfBits = 0x3fe6a09e667f3bcdll;
+    static constexpr Integer roundingBits = 0x4338000000000000ll;
+};
@@ -0,0 +1,858 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "VstServiceThread.h"
+
+using namespace juce;
+using namespace dsp;
+using namespace std;
+
+//==============================================================================================
+// Linear-phase crossover with 2 to 8 bands.
+//
+// Every band is a linear-phase FIR filter. Its zero-phase response is the difference of the
+// magnitudes of the Linkwitz-Riley low-passes of its upper and of its lower crossover
+// (1 / (1 + (f / fc)^4)), so the slopes are the ones of VstCrossover and the responses of all
+// bands add up to exactly one: the sum of the bands is the input, only delayed. The kernels
+// are sampled from these responses by an inverse FFT of kernelSize points, centred, and shaped
+// by a Blackman window (1 in the centre, so their sum stays a pure delay).
+//
+// The filters run as a uniformly partitioned convolution (overlap-save). The kernels are cut
+// into numPartitions partitions of partitionSize samples, whose spectra are computed with the
+// kernels. Every partitionSize samples the input of a channel gets one FFT, and its spectrum
+// goes into a ring of the last numPartitions spectra; each active band multiplies the ring
+// with its partitions and accumulates (complex multiply-add over SIMDRegister lanes, with the
+// real and the imaginary parts in separate arrays), then one inverse FFT gives its output.
+// The cost per sample does not depend on the length of the kernels. The latency is half a
+// kernel plus one partition; a partition is computed at once, so with host blocks shorter
+// than a partition every few blocks carry the work.
+//
+// The kernels are built on one background thread shared by all instances in the process
+// (VstServiceThread). The audio thread only posts the number of bands and the cutoffs. A
+// finished set of kernels is published in a slot with an atomic state, and the audio thread
+// takes the newest one at the start of a partition, crossfading from the old set over that
+// partition. Neither side waits and the audio thread never allocates. A set made for another
+// number of bands is not used: the bands are silent until the right one arrives, and it is
+// faded in.
+//
+// The convolution runs in float for both sample types (the FFT of JUCE is float only).
+
+//==============================================================================================
+// Kernels of one crossover: the requests of the audio thread, the slots of the finished sets
+// and the buffers to build them (only used by the thread that builds).
+
+class VstLinearPhaseKernels
+{
+public:
+
+    using Lane = SIMDRegister <float>;
+
+    static constexpr size_t maxNumBands = 8;
+    static constexpr size_t maxNumCrossovers = maxNumBands - 1;
+
+    static constexpr size_t numPartitions = 32;
+
+    // Length of the kernels (rounded up to a power of two of samples): 8192 samples at 48 kHz,
+    // a few periods of the lowest cutoffs.
+
+    static constexpr double kernelSeconds = 0.17;
+
+    // The thread of the kernels (VstServiceThread).
+
+    static constexpr const char* serviceThreadName = "Eclistar kernels";
+    static constexpr int serviceIntervalMs = 10;
+
+    // Spectra of the partitions of all bands: band b, partition p starts at the lane
+    // (b * numPartitions + p) * spectrumSize, with the real parts, then the imaginary ones.
+
+    struct KernelSet
+    {
+        size_t numBands{ 0 };
+        vector <Lane> spectra;
+    };
+
+    VstLinearPhaseKernels() = default;
+
+    ~VstLinearPhaseKernels()
+    {
+        release();
+    }
+
+    // Message thread: sizes for the sample rate; the kernels are served by the thread until
+    // release(). The sets that were built are dropped.
+
+    void prepare(double sampleRate)
+    {
+        release();
+
+        _sampleRate = sampleRate;
+        _kernelSize = (size_t)nextPowerOfTwo(jmax((int)(2 * numPartitions), roundToInt(sampleRate * kernelSeconds)));
+        _partitionSize = _kernelSize / numPartitions;
+        _numLanes = (_partitionSize + 1 + Lane::size() - 1) / Lane::size();
+
+        _kernelFft = make_unique <FFT>(OrderOf(_kernelSize));
+        _partitionFft = make_unique <FFT>(OrderOf(2 * _partitionSize));
+
+        _window.resize(_kernelSize + 1);
+        WindowingFunction <float>::fillWindowingTables(_window.data(), _kernelSize + 1,
+                                                       WindowingFunction <float>::blackman, false);
+
+        _response.resize(2 * _kernelSize);
+        _kernel.resize(_kernelSize);
+        _frame.resize(4 * _partitionSize);
+
+        for (auto& slot : _slots)
+        {
+            slot.state.store(freeSlot, memory_order_relaxed);
+        }
+
+        _builtGeneration = _requestedGeneration.load(memory_order_relaxed) - 1;
+
+        _thread->add(this);
+        _isServed = true;
+    }
+
+    void release()
+    {
+        if (!_isServed)
+            return;
+
+        _thread->remove(this);
+        _isServed = false;
+    }
+
+    size_t getKernelSize() const noexcept { return _kernelSize; }
+    size_t getPartitionSize() const noexcept { return _partitionSize; }
+
+    // Lanes of the real (or imaginary) parts of one spectrum of partitionSize + 1 bins.
+
+    size_t getNumLanes() const noexcept { return _numLanes; }
+    size_t getSpectrumSize() const noexcept { return 2 * _numLanes; }
+
+    FFT& getPartitionFft() const noexcept { return *_partitionFft; }
+
+    // Audio thread: new settings of the kernels, and whether they are built at all.
+
+    void request(size_t numBands, const float* cutoffs) noexcept
+    {
+        for (size_t crossover = 0; crossover + 1 < numBands; ++crossover)
+        {
+            _requestedCutoffs[crossover].store(cutoffs[crossover], memory_order_relaxed);
+        }
+
+        _requestedNumBands.store(numBands, memory_order_relaxed);
+        _requestedGeneration.fetch_add(1, memory_order_release);
+    }
+
+    void setEnabled(bool shouldBeEnabled) noexcept
+    {
+        _enabled.store(shouldBeEnabled, memory_order_relaxed);
+    }
+
+    // Audio thread: the newest set built after the given generation (nullptr if there is none).
+    // The set belongs to the audio thread until it is retired.
+
+    const KernelSet* acquire(uint32 afterGeneration, uint32& generation) noexcept
+    {
+        Slot* newest = nullptr;
+
+        for (auto& slot : _slots)
+        {
+            if (slot.state.load(memory_order_acquire) != readySlot)
+                continue;
+
+            auto slotGeneration = slot.generation.load(memory_order_relaxed);
+
+            if (IsNewer(slotGeneration, afterGeneration)
+                && (newest == nullptr || IsNewer(slotGeneration, newest->generation.load(memory_order_relaxed))))
+            {
+                newest = &slot;
+            }
+        }
+
+        auto expected = (int)readySlot;
+
+        if (newest == nullptr || !newest->state.compare_exchange_strong(expected, activeSlot, memory_order_acq_rel))
+            return nullptr;
+
+        generation = newest->generation.load(memory_order_relaxed);
+
+        return &newest->set;
+    }
+
+    void retire(const KernelSet* set) noexcept
+    {
+        for (auto& slot : _slots)
+        {
+            if (&slot.set == set)
+            {
+                slot.state.store(freeSlot, memory_order_release);
+            }
+        }
+    }
+
+    // Thread of the kernels (or the message thread through VstServiceThread::serve): builds the
+    // kernels of the last request into a free slot and publishes them. A request that changes
+    // while it is read is built again on the next visit.
+
+    void buildRequested()
+    {
+        auto generation = _requestedGeneration.load(memory_order_acquire);
+
+        if (!_enabled.load(memory_order_relaxed) || generation == _builtGeneration)
+            return;
+
+        // A free slot, else the set that is ready but was not taken yet (it is older).
+
+        Slot* slot = nullptr;
+
+        for (auto state : { freeSlot, readySlot })
+        {
+            for (auto& candidate : _slots)
+            {
+                auto expected = (int)state;
+
+                if (slot == nullptr && candidate.state.compare_exchange_strong(expected, buildingSlot, memory_order_acquire))
+                {
+                    slot = &candidate;
+                }
+            }
+        }
+
+        if (slot == nullptr)
+            return;
+
+        auto numBands = jlimit((size_t)2, maxNumBands, _requestedNumBands.load(memory_order_relaxed));
+        array <float, maxNumCrossovers> cutoffs{};
+
+        for (size_t crossover = 0; crossover + 1 < numBands; ++crossover)
+        {
+            cutoffs[crossover] = jmax(1.0f, _requestedCutoffs[crossover].load(memory_order_relaxed));
+        }
+
+        Build(slot->set, numBands, cutoffs.data());
+
+        slot->generation.store(generation, memory_order_relaxed);
+        slot->state.store(readySlot, memory_order_release);
+
+        _builtGeneration = generation;
+
+        // Older sets that were not taken are not needed any more.
+
+        for (auto& other : _slots)
+        {
+            auto expected = (int)readySlot;
+
+            if (&other != slot && IsNewer(generation, other.generation.load(memory_order_relaxed)))
+            {
+                other.state.compare_exchange_strong(expected, freeSlot, memory_order_acq_rel);
+            }
+        }
+    }
+
+    // Real and imaginary parts of the bins 0 ... partitionSize of an interleaved spectrum
+    // (as given by the real-only FFT of JUCE) into the lanes of a spectrum, and back.
+
+    void split(const float* interleaved, Lane* spectrum) const noexcept
+    {
+        auto* real = reinterpret_cast<float*>(spectrum);
+        auto* imaginary = real + _numLanes * Lane::size();
+
+        for (size_t bin = 0; bin <= _partitionSize; ++bin)
+        {
+            real[bin] = interleaved[2 * bin];
+            imaginary[bin] = interleaved[2 * bin + 1];
+        }
+    }
+
+    void interleave(const Lane* spectrum, float* interleaved) const noexcept
+    {
+        const auto* real = reinterpret_cast<const float*>(spectrum);
+        const auto* imaginary = real + _numLanes * Lane::size();
+
+        for (size_t bin = 0; bin <= _partitionSize; ++bin)
+        {
+            interleaved[2 * bin] = real[bin];
+            interleaved[2 * bin + 1] = imaginary[bin];
+        }
+    }
+
+private:
+
+    friend class VstServiceThread <VstLinearPhaseKernels>;
+
+    // Thread of the kernels: the requests are kept when the kernels are served again.
+
+    void Restart() {}
+
+    void Serve()
+    {
+        buildRequested();
+    }
+
+    enum SlotState
+    {
+        freeSlot,
+        buildingSlot,
+        readySlot,
+        activeSlot
+    };
+
+    // The audio thread holds one set and crossfades from it to a new one within one call, one
+    // set may be ready, and the thread builds into the third slot.
+
+    struct Slot
+    {
+        atomic <int> state{ freeSlot };
+        atomic <uint32> generation{ 0 };
+
+        KernelSet set;
+    };
+
+    static bool IsNewer(uint32 generation, uint32 than) noexcept
+    {
+        return (int32)(generation - than) > 0;
+    }
+
+    static int OrderOf(size_t size) noexcept
+    {
+        auto order = 0;
+
+        while (((size_t)1 << order) < size)
+        {
+            ++order;
+        }
+
+        return order;
+    }
+
+    // The kernels of all bands into the set (allocated by the building thread when the sizes
+    // change).
+
+    void Build(KernelSet& set, size_t numBands, const float* cutoffs)
+    {
+        auto spectrumSize = getSpectrumSize();
+        auto halfSize = _kernelSize / 2;
+
+        set.numBands = numBands;
+        set.spectra.resize(maxNumBands * numPartitions * spectrumSize, Lane::expand(0.0f));
+
+        auto lowPass = [this](size_t bin, float cutoff)
+        {
+            auto ratio = (double)bin * _sampleRate / ((double)_kernelSize * (double)cutoff);
+
+            return 1.0 / (1.0 + square(square(ratio)));
+        };
+
+        for (size_t band = 0; band < numBands; ++band)
+        {
+            // Zero-phase response of the band, then its impulse response (centred on sample 0).
+
+            for (size_t bin = 0; bin <= halfSize; ++bin)
+            {
+                auto upper = band + 1 < numBands ? lowPass(bin, cutoffs[band]) : 1.0;
+                auto lower = band > 0 ? lowPass(bin, cutoffs[band - 1]) : 0.0;
+
+                _response[2 * bin] = (float)(upper - lower);
+                _response[2 * bin + 1] = 0.0f;
+            }
+
+            _kernelFft->performRealOnlyInverseTransform(_response.data());
+
+            // Centred in the kernel and windowed.
+
+            for (size_t i = 0; i < _kernelSize; ++i)
+            {
+                _kernel[i] = _response[(i + halfSize) % _kernelSize] * _window[i];
+            }
+
+            // Spectra of the partitions, zero-padded to two partitions.
+
+            for (size_t partition = 0; partition < numPartitions; ++partition)
+            {
+                FloatVectorOperations::copy(_frame.data(), _kernel.data() + partition * _partitionSize, (int)_partitionSize);
+                FloatVectorOperations::clear(_frame.data() + _partitionSize, (int)(3 * _partitionSize));
+
+                _partitionFft->performRealOnlyForwardTransform(_frame.data(), true);
+
+                split(_frame.data(), set.spectra.data() + (band * numPartitions + partition) * spectrumSize);
+            }
+        }
+    }
+
+    //------------------------------------------------------------------
+
+    // Sizes (set by prepare).
+
+    double _sampleRate{ 48000.0 };
+
+    size_t _kernelSize{ 0 };
+    size_t _partitionSize{ 0 };
+    size_t _numLanes{ 0 };
+
+    // Requests of the audio thread.
+
+    atomic <bool> _enabled{ false };
+    atomic <uint32> _requestedGeneration{ 0 };
+    atomic <size_t> _requestedNumBands{ 3 };
+    array <atomic <float>, maxNumCrossovers> _requestedCutoffs{};
+
+    // Finished sets.
+
+    array <Slot, 3> _slots;
+
+    // Building (only the thread that builds).
+
+    uint32 _builtGeneration{ 0 };
+
+    unique_ptr <FFT> _kernelFft;
+    unique_ptr <FFT> _partitionFft;
+
+    vector <float> _window;
+    vector <float> _response;
+    vector <float> _kernel;
+    vector <float> _frame;
+
+    // Message thread.
+
+    bool _isServed{ false };
+
+    SharedResourcePointer <VstServiceThread <VstLinearPhaseKernels>> _thread;
+
+    JUCE_DECLARE_NON_COPYABLE(VstLinearPhaseKernels)
+};
+
+//==============================================================================================
+// The crossover itself, with the interface of VstCrossover: the bands are written into one
+// block of numBands * numChannels channels (band b, channel c in the channel
+// b * numChannels + c), and a sidechain can be split in the same call.
+
+template <typename SampleType>
+class VstLinearPhaseCrossover
+{
+public:
+
+    using Lane = VstLinearPhaseKernels::Lane;
+    using KernelSet = VstLinearPhaseKernels::KernelSet;
+
+    static constexpr size_t maxNumBands = VstLinearPhaseKernels::maxNumBands;
+    static constexpr size_t maxNumCrossovers = VstLinearPhaseKernels::maxNumCrossovers;
+    static constexpr size_t numPartitions = VstLinearPhaseKernels::numPartitions;
+
+    // Functions of the crossover itself.
+
+    void prepare(const ProcessSpec& process_spec)
+    {
+        _numChannels = process_spec.numChannels;
+
+        _kernels.prepare(process_spec.sampleRate);
+        _kernels.request(_numBands, _cutoffs.data());
+
+        _active = nullptr;
+
+        auto partitionSize = _kernels.getPartitionSize();
+        auto spectrumSize = _kernels.getSpectrumSize();
+
+        _frames.assign(_numChannels * 2 * partitionSize, 0.0f);
+        _history.assign(_numChannels * numPartitions * spectrumSize, Lane::expand(0.0f));
+        _outputs.assign(_numChannels * maxNumBands * partitionSize, 0.0f);
+
+        _accumulator.assign(spectrumSize, Lane::expand(0.0f));
+        _scratch.assign(4 * partitionSize, 0.0f);
+        _fadeOutput.assign(partitionSize, 0.0f);
+
+        reset();
+    }
+
+    // Message thread: the thread stops building for this crossover.
+
+    void release()
+    {
+        _kernels.release();
+    }
+
+    // Message thread, before playing: the kernels of the current settings are built now, so the
+    // first block has them.
+
+    void buildKernels()
+    {
+        _kernelThread->serve(&_kernels);
+
+        uint32 generation = 0;
+
+        if (auto* newest = _kernels.acquire(_generation, generation))
+        {
+            if (_active != nullptr)
+                _kernels.retire(_active);
+
+            _active = newest;
+            _generation = generation;
+        }
+    }
+
+    // Kernels are only built while the crossover is in use.
+
+    void setEnabled(bool shouldBeEnabled) noexcept
+    {
+        _kernels.setEnabled(shouldBeEnabled);
+    }
+
+    int getLatencySamples() const noexcept
+    {
+        return (int)(_kernels.getKernelSize() / 2 + _kernels.getPartitionSize());
+    }
+
+    void reset()
+    {
+        fill(_frames.begin(), _frames.end(), 0.0f);
+        fill(_history.begin(), _history.end(), Lane::expand(0.0f));
+        fill(_outputs.begin(), _outputs.end(), 0.0f);
+
+        _fill = 0;
+        _head = 0;
+        _numProcessedChannels = _numChannels;
+    }
+
+    // Number of bands (no allocation, the outputs are cleared until its kernels arrive).
+
+    void setNumBands(size_t numBands) noexcept
+    {
+        jassert(numBands >= 2 && numBands <= maxNumBands);
+
+        _numBands = jlimit((size_t)2, maxNumBands, numBands);
+        _activeBands = AllBands();
+
+        fill(_outputs.begin(), _outputs.end(), 0.0f);
+
+        _kernels.request(_numBands, _cutoffs.data());
+    }
+
+    size_t getNumBands() const noexcept { return _numBands; }
+
+    // Bands to compute (bit 0 is the lowest band). A band that comes back starts from silence
+    // for the rest of the partition.
+
+    void setActiveBands(uint32 bandMask) noexcept
+    {
+        bandMask &= AllBands();
+
+        auto partitionSize = _kernels.getPartitionSize();
+
+        for (size_t band = 0; band < _numBands; ++band)
+        {
+            if ((bandMask & ~_activeBands & (1u << band)) == 0)
+                continue;
+
+            for (size_t channel = 0; channel < _numChannels; ++channel)
+            {
+                FloatVectorOperations::clear(Output(channel, band), (int)partitionSize);
+            }
+        }
+
+        _activeBands = bandMask;
+    }
+
+    uint32 getActiveBands() const noexcept { return _activeBands; }
+
+    // Cutoffs of the numBands - 1 crossovers, in ascending order. The new kernels arrive a few
+    // milliseconds later.
+
+    void setCutoffFrequencies(const float* cutoffs) noexcept
+    {
+        auto hasChanged = false;
+
+        for (size_t crossover = 0; crossover + 1 < _numBands; ++crossover)
+        {
+            jassert(cutoffs[crossover] > 0);
+            jassert(crossover == 0 || cutoffs[crossover] >= cutoffs[crossover - 1]);
+
+            hasChanged = hasChanged || cutoffs[crossover] != _cutoffs[crossover];
+            _cutoffs[crossover] = cutoffs[crossover];
+        }
+
+        if (hasChanged)
+        {
+            _kernels.request(_numBands, _cutoffs.data());
+        }
+    }
+
+    // Splitting of the input into the bands. The bands must not alias the input.
+
+    void process(const AudioBlock <const SampleType>& input, AudioBlock <SampleType>& bands) noexcept
+    {
+        auto numChannels = input.getNumChannels();
+
+        jassert(bands.getNumChannels() >= _numBands * numChannels && bands.getNumSamples() == input.getNumSamples());
+
+        Process(numChannels, input.getNumSamples(),
+                [&](size_t channel) { return input.getChannelPointer(channel); },
+                [&](size_t band, size_t channel) { return bands.getChannelPointer(band * numChannels + channel); });
+    }
+
+    // Splitting of the input and of a sidechain (same number of samples) in one pass; the
+    // channels of the sidechain follow the ones of the input.
+
+    void process(const AudioBlock <const SampleType>& input, const AudioBlock <const SampleType>& sidechain,
+                 AudioBlock <SampleType>& bands, AudioBlock <SampleType>& sidechainBands) noexcept
+    {
+        auto numChannels = input.getNumChannels();
+        auto numSidechainChannels = sidechain.getNumChannels();
+
+        jassert(bands.getNumChannels() >= _numBands * numChannels && bands.getNumSamples() == input.getNumSamples());
+        jassert(sidechainBands.getNumChannels() >= _numBands * numSidechainChannels);
+        jassert(sidechain.getNumSamples() == input.getNumSamples() && sidechainBands.getNumSamples() == input.getNumSamples());
+
+        Process(numChannels + numSidechainChannels, input.getNumSamples(),
+                [&](size_t channel)
+                {
+                    return channel < numChannels ? input.getChannelPointer(channel)
+                                                 : sidechain.getChannelPointer(channel - numChannels);
+                },
+                [&](size_t band, size_t channel)
+                {
+                    return channel < numChannels ? bands.getChannelPointer(band * numChannels + channel)
+                                                 : sidechainBands.getChannelPointer(band * numSidechainChannels + channel - numChannels);
+                });
+    }
+
+private:
+
+    // Channels 0 ... numChannels - 1: inputOf(channel) gives the input of a channel,
+    // outputOf(band, channel) its output in the band. The input goes into the current
+    // partition, the output comes from the last computed one.
+
+    template <typename InputOf, typename OutputOf>
+
+    void Process(size_t numChannels, size_t numSamples, InputOf&& inputOf, OutputOf&& outputOf) noexcept
+    {
+        jassert(numChannels <= _numChannels);
+
+        if (_activeBands == 0)
+            return;
+
+        // Channels that were not processed (a sidechain that was off) start from silence.
+
+        if (numChannels > _numProcessedChannels)
+        {
+            for (auto channel = _numProcessedChannels; channel < numChannels; ++channel)
+            {
+                ClearChannel(channel);
+            }
+        }
+
+        _numProcessedChannels = numChannels;
+
+        auto partitionSize = _kernels.getPartitionSize();
+
+        for (size_t done = 0; done < numSamples;)
+        {
+            auto count = jmin(numSamples - done, partitionSize - _fill);
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                const auto* input = inputOf(channel) + done;
+                auto* frame = Frame(channel) + partitionSize + _fill;
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    frame[i] = (float)input[i];
+                }
+
+                for (size_t band = 0; band < _numBands; ++band)
+                {
+                    if ((_activeBands & (1u << band)) == 0)
+                        continue;
+
+                    auto* output = outputOf(band, channel) + done;
+                    const auto* computed = Output(channel, band) + _fill;
+
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        output[i] = (SampleType)computed[i];
+                    }
+                }
+            }
+
+            _fill += count;
+            done += count;
+
+            if (_fill == partitionSize)
+            {
+                ProcessPartition(numChannels);
+                _fill = 0;
+            }
+        }
+    }
+
+    void ProcessPartition(size_t numChannels) noexcept
+    {
+        // A new set of kernels is taken at the start of a partition, the old one fades out.
+
+        uint32 generation = 0;
+        auto* newest = _kernels.acquire(_generation, generation);
+        auto* previous = _active;
+
+        if (newest != nullptr)
+        {
+            _active = newest;
+            _generation = generation;
+        }
+
+        auto partitionSize = _kernels.getPartitionSize();
+
+        _head = (_head + 1) % numPartitions;
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            // Spectrum of the last two partitions of the input; the current one becomes the last.
+
+            auto* frame = Frame(channel);
+
+            FloatVectorOperations::copy(_scratch.data(), frame, (int)(2 * partitionSize));
+            FloatVectorOperations::clear(_scratch.data() + 2 * partitionSize, (int)(2 * partitionSize));
+
+            _kernels.getPartitionFft().performRealOnlyForwardTransform(_scratch.data(), true);
+            _kernels.split(_scratch.data(), History(channel, _head));
+
+            FloatVectorOperations::copy(frame, frame + partitionSize, (int)partitionSize);
+
+            for (size_t band = 0; band < _numBands; ++band)
+            {
+                if ((_activeBands & (1u << band)) == 0)
+                    continue;
+
+                auto* output = Output(channel, band);
+
+                Convolve(channel, _active, band, output);
+
+                if (newest == nullptr)
+                    continue;
+
+                Convolve(channel, previous, band, _fadeOutput.data());
+
+                for (size_t i = 0; i < partitionSize; ++i)
+                {
+                    auto position = (float)(i + 1) / (float)partitionSize;
+
+                    output[i] = _fadeOutput[i] + (output[i] - _fadeOutput[i]) * position;
+                }
+            }
+        }
+
+        if (newest != nullptr && previous != nullptr)
+        {
+            _kernels.retire(previous);
+        }
+    }
+
+    // One partition of the output of a band: the ring of input spectra times the partitions
+    // of the kernel, accumulated, then the inverse FFT (the second half is the output).
+
+    void Convolve(size_t channel, const KernelSet* set, size_t band, float* output) noexcept
+    {
+        auto partitionSize = _kernels.getPartitionSize();
+
+        if (set == nullptr || set->numBands != _numBands)
+        {
+            FloatVectorOperations::clear(output, (int)partitionSize);
+            return;
+        }
+
+        auto numLanes = _kernels.getNumLanes();
+        auto spectrumSize = _kernels.getSpectrumSize();
+
+        auto* accumulator = _accumulator.data();
+        const auto* kernel = set->spectra.data() + band * numPartitions * spectrumSize;
+
+        fill(_accumulator.begin(), _accumulator.end(), Lane::expand(0.0f));
+
+        for (size_t partition = 0; partition < numPartitions; ++partition)
+        {
+            const auto* input = History(channel, (_head + numPartitions - partition) % numPartitions);
+            const auto* coefficients = kernel + partition * spectrumSize;
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                auto inputReal = input[lane];
+                auto inputImaginary = input[numLanes + lane];
+                auto kernelReal = coefficients[lane];
+                auto kernelImaginary = coefficients[numLanes + lane];
+
+                accumulator[lane] += inputReal * kernelReal - inputImaginary * kernelImaginary;
+                accumulator[numLanes + lane] += inputReal * kernelImaginary + inputImaginary * kernelReal;
+            }
+        }
+
+        _kernels.interleave(accumulator, _scratch.data());
+        _kernels.getPartitionFft().performRealOnlyInverseTransform(_scratch.data());
+
+        FloatVectorOperations::copy(output, _scratch.data() + partitionSize, (int)partitionSize);
+    }
+
+    void ClearChannel(size_t channel) noexcept
+    {
+        auto partitionSize = _kernels.getPartitionSize();
+
+        FloatVectorOperations::clear(Frame(channel), (int)(2 * partitionSize));
+
+        for (size_t partition = 0; partition < numPartitions; ++partition)
+        {
+            fill(History(channel, partition), History(channel, partition) + _kernels.getSpectrumSize(), Lane::expand(0.0f));
+        }
+
+        for (size_t band = 0; band < maxNumBands; ++band)
+        {
+            FloatVectorOperations::clear(Output(channel, band), (int)partitionSize);
+        }
+    }
+
+    uint32 AllBands() const noexcept { return (1u << _numBands) - 1; }
+
+    float* Frame(size_t channel) noexcept
+    {
+        return _frames.data() + channel * 2 * _kernels.getPartitionSize();
+    }
+
+    Lane* History(size_t channel, size_t partition) noexcept
+    {
+        return _history.data() + (channel * numPartitions + partition) * _kernels.getSpectrumSize();
+    }
+
+    float* Output(size_t channel, size_t band) noexcept
+    {
+        return _outputs.data() + (channel * maxNumBands + band) * _kernels.getPartitionSize();
+    }
+
+    //------------------------------------------------------------------
+
+    size_t _numChannels{ 0 };
+    size_t _numProcessedChannels{ 0 };
+
+    size_t _numBands{ 3 };
+    uint32 _activeBands{ 7 };
+
+    array <float, maxNumCrossovers> _cutoffs{ 400.0f, 2000.0f, 5000.0f, 8000.0f, 11000.0f, 14000.0f, 17000.0f };
+
+    VstLinearPhaseKernels _kernels;
+
+    const KernelSet* _active{ nullptr };
+    uint32 _generation{ 0 };
+
+    // Every channel: the last two partitions of the input, the ring of the spectra of the input
+    // (numPartitions of them, the newest at _head) and the last computed partition of each band.
+
+    vector <float> _frames;
+    vector <Lane> _history;
+    vector <float> _outputs;
+
+    size_t _fill{ 0 };
+    size_t _head{ 0 };
+
+    // Work buffers of the audio thread.
+
+    vector <Lane> _accumulator;
+    vector <float> _scratch;
+    vector <float> _fadeOutput;
+
+    SharedResourcePointer <VstServiceThread <VstLinearPhaseKernels>> _kernelThread;
+};
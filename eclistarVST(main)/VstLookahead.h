@@ -0,0 +1,265 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+using namespace dsp;
+using namespace std;
+
+//==============================================================================================
+// Lookahead of the band compressors.
+//
+// The audio of every band is delayed by the largest lookahead, and every band gets a key
+// signal for its detector: the peak of the samples of its own lookahead window, i.e. of the
+// audio that is coming next. The key is in the same layout as the bands (band b, channel c
+// is the channel b * numChannels + c) and is given to MultiBandCompressorSIMD, so the gain
+// reduction is already there when a transient reaches the audio path.
+//
+// Each channel has one delay line, a power-of-two ring buffer allocated in prepare(): the
+// audio is read from it at the full delay and the key at the delay less the lookahead of the
+// band. The window peak is a sliding maximum over a monotonic deque of positions in the
+// ring (decreasing values), so it costs O(1) per sample whatever the length of the window.
+//
+// Bands that are not processed (setActiveBands) are not written, their lines are cleared
+// when they come back. The samples are float or double (SampleType).
+
+template <typename SampleType>
+class VstLookahead
+{
+public:
+
+    static constexpr size_t maxNumBands = 8;
+
+    static constexpr double maxLookaheadSeconds = 0.02;
+
+    // Functions of the lookahead itself. The sample rate is the highest rate the samples can
+    // have (the oversampled one), numChannels counts the channels of all bands.
+
+    void prepare(const ProcessSpec& process_spec)
+    {
+        _maxDelay = (size_t)std::ceil(maxLookaheadSeconds * process_spec.sampleRate);
+        _size = (size_t)nextPowerOfTwo((int)_maxDelay + 1);
+        _mask = (uint32)(_size - 1);
+
+        _samples.assign(process_spec.numChannels * _size, (SampleType)0);
+        _queues.assign(process_spec.numChannels * _size, 0);
+        _queueFronts.assign(process_spec.numChannels, 0);
+        _queueBacks.assign(process_spec.numChannels, 0);
+
+        setDelay(jmin(_delay, _maxDelay));
+    }
+
+    void reset()
+    {
+        fill(_samples.begin(), _samples.end(), (SampleType)0);
+        fill(_queueFronts.begin(), _queueFronts.end(), 0);
+        fill(_queueBacks.begin(), _queueBacks.end(), 0);
+
+        _position = 0;
+    }
+
+    // Number of bands in the block (no allocation, the lines are cleared).
+
+    void setNumBands(size_t numBands) noexcept
+    {
+        jassert(numBands >= 1 && numBands <= maxNumBands);
+
+        _numBands = jlimit((size_t)1, maxNumBands, numBands);
+
+        reset();
+    }
+
+    // Delay of the audio in samples (the largest lookahead of the bands); the lines are cleared.
+
+    void setDelay(size_t delay) noexcept
+    {
+        jassert(delay <= _maxDelay);
+
+        _delay = jmin(delay, _maxDelay);
+
+        for (auto& lookahead : _lookaheads)
+        {
+            lookahead = jmin(lookahead, _delay);
+        }
+
+        reset();
+    }
+
+    size_t getDelay() const noexcept { return _delay; }
+
+    // Length of the window of a band in samples (at most the delay).
+
+    void setBandLookahead(size_t band, size_t lookahead) noexcept
+    {
+        jassert(band < maxNumBands);
+        jassert(lookahead <= _delay);
+
+        lookahead = jmin(lookahead, _delay);
+
+        if (_lookaheads[band] != lookahead)
+        {
+            _lookaheads[band] = lookahead;
+            _newWindows |= 1u << band;
+        }
+    }
+
+    // Bands to process (bit 0 is the first band).
+
+    void setActiveBands(uint32 bandMask) noexcept
+    {
+        _nextActiveBands = bandMask;
+    }
+
+    // The bands are delayed in place, the keys get the peaks of the windows.
+
+    void process(AudioBlock <SampleType>& bands, AudioBlock <SampleType>& keys) noexcept
+    {
+        processChannels(bands, keys, 0, bands.getNumChannels() / _numBands);
+        advance(bands.getNumSamples());
+    }
+
+    // The same in parts, for several threads: processChannels() for disjoint parts of the
+    // bands, then advance() once. The blocks hold the channels firstChannel ... of the bands
+    // (numChannels channels per band), the lines of other channels are not touched.
+
+    void processChannels(AudioBlock <SampleType>& bands, AudioBlock <SampleType>& keys,
+                         size_t firstChannel, size_t numChannels) noexcept
+    {
+        auto numSamples = bands.getNumSamples();
+
+        jassert((firstChannel + bands.getNumChannels()) * _size <= _samples.size());
+        jassert(keys.getNumChannels() >= bands.getNumChannels() && keys.getNumSamples() == numSamples);
+
+        // Bands that come back restart from silence. A band with a new window keeps its line,
+        // its deque is built again from the samples of the new window.
+
+        for (size_t i = 0; i < bands.getNumChannels(); ++i)
+        {
+            auto channel = firstChannel + i;
+            auto band = channel / numChannels;
+
+            if ((_nextActiveBands & (1u << band)) == 0)
+                continue;
+
+            if ((_activeBands & (1u << band)) == 0)
+            {
+                ClearChannel(channel);
+            }
+            else if ((_newWindows & (1u << band)) != 0)
+            {
+                FillQueue(channel, _lookaheads[band]);
+            }
+
+            ProcessChannel(channel, _lookaheads[band], bands.getChannelPointer(i),
+                           keys.getChannelPointer(i), numSamples);
+        }
+    }
+
+    void advance(size_t numSamples) noexcept
+    {
+        _activeBands = _nextActiveBands;
+        _newWindows = 0;
+        _position += (uint32)numSamples;
+    }
+
+private:
+
+    void ProcessChannel(size_t channel, size_t lookahead, SampleType* samples, SampleType* key, size_t numSamples) noexcept
+    {
+        auto* line = &_samples[channel * _size];
+        auto* queue = &_queues[channel * _size];
+
+        auto& front = _queueFronts[channel];
+        auto& back = _queueBacks[channel];
+
+        auto delay = (uint32)_delay;
+        auto window = (uint32)lookahead;
+        auto position = _position;
+
+        for (size_t i = 0; i < numSamples; ++i, ++position)
+        {
+            line[position & _mask] = samples[i];
+
+            // The newest sample of the window enters the deque: the smaller ones before it
+            // can never be the maximum again, and the oldest leaves with the window.
+
+            auto newest = position - (delay - window);
+
+            Push(line, queue, back, front, newest);
+
+            while (newest - queue[front & _mask] > window)
+            {
+                ++front;
+            }
+
+            key[i] = std::abs(line[queue[front & _mask] & _mask]);
+            samples[i] = line[(position - delay) & _mask];
+        }
+    }
+
+    void Push(const SampleType* line, uint32* queue, uint32& back, uint32 front, uint32 newest) const noexcept
+    {
+        auto value = std::abs(line[newest & _mask]);
+
+        while (back != front && std::abs(line[queue[(back - 1) & _mask] & _mask]) <= value)
+        {
+            --back;
+        }
+
+        queue[back++ & _mask] = newest;
+    }
+
+    // The deque of the window that ends before the next sample (still in the line).
+
+    void FillQueue(size_t channel, size_t lookahead) noexcept
+    {
+        auto* line = &_samples[channel * _size];
+        auto* queue = &_queues[channel * _size];
+
+        auto& front = _queueFronts[channel];
+        auto& back = _queueBacks[channel];
+
+        front = 0;
+        back = 0;
+
+        auto oldest = _position - (uint32)_delay;
+
+        for (auto newest = oldest; newest != oldest + (uint32)lookahead; ++newest)
+        {
+            Push(line, queue, back, front, newest);
+        }
+    }
+
+    void ClearChannel(size_t channel) noexcept
+    {
+        fill(_samples.begin() + (ptrdiff_t)(channel * _size), _samples.begin() + (ptrdiff_t)((channel + 1) * _size), (SampleType)0);
+
+        _queueFronts[channel] = 0;
+        _queueBacks[channel] = 0;
+    }
+
+    //------------------------------------------------------------------
+
+    size_t _numBands{ 3 };
+
+    size_t _maxDelay{ 0 };
+    size_t _delay{ 0 };
+
+    array <size_t, maxNumBands> _lookaheads{};
+
+    uint32 _activeBands{ 0 };
+    uint32 _nextActiveBands{ (1u << maxNumBands) - 1 };
+    uint32 _newWindows{ 0 };
+
+    // Delay lines and deques of all channels, _size values per channel.
+
+    size_t _size{ 1 };
+    uint32 _mask{ 0 };
+
+    uint32 _position{ 0 };
+
+    vector <SampleType> _samples;
+    vector <uint32> _queues;
+    vector <uint32> _queueFronts;
+    vector <uint32> _queueBacks;
+};
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+using namespace dsp;
+using namespace std;
+
+//==============================================================================================
+// Levels of the bands, from the audio thread to the editor.
+//
+// The audio thread adds the band buffers before and after the compressors (the block of
+// VstCrossover, band b, channel c in the channel b * numChannels + c) while they are still in
+// the cache: one SIMD pass per buffer gives the sum of squares and the peak. The gain reduction
+// is the one of the envelopes of the compressor at the end of each part.
+//
+// Every windowSeconds the sums of the window are pushed as one frame into a single-producer,
+// single-consumer FIFO (AbstractFifo over a fixed array of frames): no lock, no allocation,
+// and a full FIFO (editor closed or stalled) only drops the frame. The editor reads all frames
+// on its timer and combines them, so no peak is lost between two repaints.
+
+class VstMeteringBus
+{
+public:
+
+    static constexpr size_t maxNumBands = 8;
+
+    static constexpr int capacity = 32;
+
+    static constexpr double windowSeconds = 0.05;
+
+    // Levels of one band since the last read: RMS and peaks of all its channels (linear), and
+    // the largest gain reduction (dB, positive).
+
+    struct BandLevels
+    {
+        float inputRms{ 0.0f };
+        float outputRms{ 0.0f };
+
+        float inputPeak{ 0.0f };
+        float outputPeak{ 0.0f };
+
+        float gainReduction{ 0.0f };
+    };
+
+    using Levels = array <BandLevels, maxNumBands>;
+
+    // Audio side: the length of the window at the sample rate (called before playing).
+
+    void prepare(double sampleRate)
+    {
+        _windowSize = jmax((int64)1, (int64)(sampleRate * windowSeconds));
+        _current = {};
+    }
+
+    template <typename SampleType>
+
+    void addInput(const AudioBlock <SampleType>& bands, size_t numChannels, uint32 activeBands) noexcept
+    {
+        AddBands(bands, numChannels, activeBands, _current.inputSquares, _current.inputPeaks, _current.numInputValues);
+    }
+
+    template <typename SampleType>
+
+    void addOutput(const AudioBlock <SampleType>& bands, size_t numChannels, uint32 activeBands) noexcept
+    {
+        AddBands(bands, numChannels, activeBands, _current.outputSquares, _current.outputPeaks, _current.numOutputValues);
+    }
+
+    // Gain of the band (linear) at the end of a part.
+
+    void addGain(size_t band, float gain) noexcept
+    {
+        jassert(band < maxNumBands);
+
+        _current.minGains[band] = jmin(_current.minGains[band], gain);
+    }
+
+    // Samples of the part at the base rate; a full window is published.
+
+    void advance(size_t numSamples) noexcept
+    {
+        _current.numSamples += (int64)numSamples;
+
+        if (_current.numSamples < _windowSize)
+            return;
+
+        int start1, size1, start2, size2;
+        _fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 > 0)
+        {
+            _frames[(size_t)start1] = _current;
+            _fifo.finishedWrite(1);
+        }
+
+        _current = {};
+    }
+
+    // Editor side: the levels of all frames since the last read (false if there is none).
+
+    bool read(Levels& levels) noexcept
+    {
+        int start1, size1, start2, size2;
+        _fifo.prepareToRead(_fifo.getNumReady(), start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        Frame total;
+
+        for (auto i = 0; i < size1; ++i)
+        {
+            total.add(_frames[(size_t)(start1 + i)]);
+        }
+
+        for (auto i = 0; i < size2; ++i)
+        {
+            total.add(_frames[(size_t)(start2 + i)]);
+        }
+
+        _fifo.finishedRead(size1 + size2);
+
+        for (size_t band = 0; band < maxNumBands; ++band)
+        {
+            auto& level = levels[band];
+
+            level.inputRms = (float)std::sqrt(total.inputSquares[band] / jmax(1.0, total.numInputValues[band]));
+            level.outputRms = (float)std::sqrt(total.outputSquares[band] / jmax(1.0, total.numOutputValues[band]));
+            level.inputPeak = total.inputPeaks[band];
+            level.outputPeak = total.outputPeaks[band];
+            level.gainReduction = jmax(0.0f, -Decibels::gainToDecibels(total.minGains[band], -100.0f));
+        }
+
+        return true;
+    }
+
+private:
+
+    // Sums of one window.
+
+    struct Frame
+    {
+        array <double, maxNumBands> inputSquares{};
+        array <double, maxNumBands> outputSquares{};
+        array <double, maxNumBands> numInputValues{};
+        array <double, maxNumBands> numOutputValues{};
+
+        array <float, maxNumBands> inputPeaks{};
+        array <float, maxNumBands> outputPeaks{};
+        array <float, maxNumBands> minGains{};
+
+        int64 numSamples{ 0 };
+
+        Frame() noexcept
+        {
+            minGains.fill(1.0f);
+        }
+
+        void add(const Frame& other) noexcept
+        {
+            for (size_t band = 0; band < maxNumBands; ++band)
+            {
+                inputSquares[band] += other.inputSquares[band];
+                outputSquares[band] += other.outputSquares[band];
+                numInputValues[band] += other.numInputValues[band];
+                numOutputValues[band] += other.numOutputValues[band];
+
+                inputPeaks[band] = jmax(inputPeaks[band], other.inputPeaks[band]);
+                outputPeaks[band] = jmax(outputPeaks[band], other.outputPeaks[band]);
+                minGains[band] = jmin(minGains[band], other.minGains[band]);
+            }
+
+            numSamples += other.numSamples;
+        }
+    };
+
+    template <typename SampleType>
+
+    static void AddBands(const AudioBlock <SampleType>& bands, size_t numChannels, uint32 activeBands,
+                         array <double, maxNumBands>& squares, array <float, maxNumBands>& peaks,
+                         array <double, maxNumBands>& numValues) noexcept
+    {
+        auto numSamples = bands.getNumSamples();
+        auto numBands = jmin(maxNumBands, bands.getNumChannels() / numChannels);
+
+        for (size_t band = 0; band < numBands; ++band)
+        {
+            if ((activeBands & (1u << band)) == 0)
+                continue;
+
+            auto sum = (SampleType)0;
+            auto peak = (SampleType)0;
+
+            for (auto channel = band * numChannels; channel < (band + 1) * numChannels; ++channel)
+            {
+                AddSamples(bands.getChannelPointer(channel), numSamples, sum, peak);
+            }
+
+            squares[band] += (double)sum;
+            peaks[band] = jmax(peaks[band], (float)peak);
+            numValues[band] += (double)(numSamples * numChannels);
+        }
+    }
+
+    // Sum of squares and peak of the samples: whole registers from the first aligned sample,
+    // the samples before and after it one by one.
+
+    template <typename SampleType>
+
+    static void AddSamples(const SampleType* samples, size_t numSamples, SampleType& sum, SampleType& peak) noexcept
+    {
+        using Lane = SIMDRegister <SampleType>;
+
+        size_t i = 0;
+
+        for (; i < numSamples && !Lane::isSIMDAligned(samples + i); ++i)
+        {
+            sum += samples[i] * samples[i];
+            peak = jmax(peak, std::abs(samples[i]));
+        }
+
+        auto sums = Lane::expand((SampleType)0);
+        auto peaks = Lane::expand((SampleType)0);
+
+        for (; i + Lane::size() <= numSamples; i += Lane::size())
+        {
+            auto values = Lane::fromRawArray(samples + i);
+
+            sums += values * values;
+            peaks = Lane::max(peaks, Lane::abs(values));
+        }
+
+        alignas(sizeof(Lane)) SampleType lanes[Lane::size()];
+        peaks.copyToRawArray(lanes);
+
+        sum += sums.sum();
+
+        for (auto lane : lanes)
+        {
+            peak = jmax(peak, lane);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            sum += samples[i] * samples[i];
+            peak = jmax(peak, std::abs(samples[i]));
+        }
+    }
+
+    //------------------------------------------------------------------
+
+    int64 _windowSize{ 2400 };
+
+    Frame _current;
+
+    array <Frame, (size_t)capacity> _frames;
+    AbstractFifo _fifo{ capacity };
+};
@@ -0,0 +1,431 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+using namespace dsp;
+using namespace std;
+
+#if ! JUCE_USE_SIMD
+ #error "VstOversampler needs juce::dsp::SIMDRegister (SSE or NEON)."
+#endif
+
+//==============================================================================================
+// 2x, 4x or 8x oversampling with polyphase half-band IIR filters.
+//
+// Every 2x stage is a half-band low-pass made of two chains of first-order allpasses
+// working at the lower rate (the polyphase form of Valenzuela and Constantinides):
+//
+//      H(z) = (A0(z^2) + z^-1 A1(z^2)) / 2
+//
+// The upsampler runs both chains on every input sample and interleaves their outputs, the
+// downsampler runs one chain on the even and one on the odd samples and averages them, so
+// no sample is computed that is thrown away. The later stages of 4x and 8x see a signal
+// that only fills the lower part of their band, so they get a wider transition band and
+// fewer coefficients than the first one.
+//
+// The coefficients are designed in prepare() for every quality (attenuation of the images
+// and width of the transition band above the audio band); setFactor() only selects them.
+// Channels are laid out in the lanes of a SIMDRegister, as in VstCrossover.
+//
+// The filters are not linear phase: the latency is the group delay at low frequencies,
+// rounded to whole samples of the base rate.
+//
+// The factors and qualities are in VstOversamplerBase, so they are the same for the float
+// and the double oversampler.
+
+struct VstOversamplerBase
+{
+    static constexpr size_t maxNumStages = 3;
+    static constexpr size_t maxFactor = (size_t)1 << maxNumStages;
+
+    // Quality against CPU: the image rejection and the top of the flat band (at 44.1 kHz).
+
+    enum Quality
+    {
+        draftQuality,   // 70 dB, flat up to 17.6 kHz
+        normalQuality,  // 90 dB, flat up to 19.4 kHz
+        highQuality,    // 120 dB, flat up to 20.7 kHz
+
+        numQualities
+    };
+};
+
+template <typename SampleType>
+class VstOversampler : public VstOversamplerBase
+{
+public:
+
+    using Lane = SIMDRegister <SampleType>;
+
+    // Functions of the oversampler itself (numChannels and the block size of the base rate).
+
+    void prepare(const ProcessSpec& process_spec)
+    {
+        _numChannels = process_spec.numChannels;
+        _maxNumSamples = process_spec.maximumBlockSize;
+
+        for (size_t stage = 0; stage < maxNumStages; ++stage)
+        {
+            _buffers[stage].setSize((int)_numChannels, (int)(_maxNumSamples << (stage + 1)));
+        }
+
+        _states.resize(((_numChannels + Lane::size() - 1) / Lane::size()) * maxNumStages);
+
+        for (size_t quality = 0; quality < numQualities; ++quality)
+        {
+            for (size_t stage = 0; stage < maxNumStages; ++stage)
+            {
+                _designs[quality][stage] = Design::create((Quality)quality, stage);
+            }
+        }
+
+        setFactor(_factor, _quality);
+    }
+
+    void reset()
+    {
+        for (auto& state : _states)
+        {
+            state = {};
+        }
+    }
+
+    // Factor 1 (no oversampling), 2, 4 or 8. No allocation, the states are cleared.
+
+    void setFactor(size_t factor, Quality quality) noexcept
+    {
+        jassert(factor >= 1 && factor <= maxFactor && isPowerOfTwo(factor));
+        jassert(quality >= 0 && quality < numQualities);
+
+        _factor = jlimit((size_t)1, maxFactor, factor);
+        _quality = (Quality)jlimit(0, numQualities - 1, (int)quality);
+        _numStages = 0;
+
+        auto latency = 0.0;
+
+        while (((size_t)1 << _numStages) < _factor)
+        {
+            const auto& design = _designs[_quality][_numStages];
+
+            ++_numStages;
+
+            // Group delay of the upsampler and of the downsampler (one sample of the higher
+            // rate less, as it reads the odd sample first), in samples of the base rate.
+
+            latency += (2.0 * design.delay - 1.0) / (double)((size_t)1 << _numStages);
+        }
+
+        _latencySamples = _factor > 1 ? jmax(1, roundToInt(latency)) : 0;
+
+        reset();
+    }
+
+    size_t getFactor() const noexcept { return _factor; }
+    Quality getQuality() const noexcept { return _quality; }
+
+    int getLatencySamples() const noexcept { return _latencySamples; }
+
+    // The input at the base rate goes up to the oversampled rate. The returned block belongs
+    // to the oversampler and stays valid until processDown().
+    //
+    // The block may hold only the channels firstChannel ... of the prepared ones, if it starts
+    // on a group of Lane::size() channels: such blocks share no state, so different threads
+    // can resample different groups.
+
+    AudioBlock <SampleType> processUp(const AudioBlock <const SampleType>& input, size_t firstChannel = 0) noexcept
+    {
+        auto numSamples = input.getNumSamples();
+
+        jassert(firstChannel % Lane::size() == 0);
+        jassert(firstChannel + input.getNumChannels() <= _numChannels);
+        jassert(numSamples <= _maxNumSamples);
+        jassert(_numStages > 0);
+
+        auto current = input;
+        AudioBlock <SampleType> output;
+
+        for (size_t stage = 0; stage < _numStages; ++stage)
+        {
+            output = StageBlock(stage, firstChannel, input.getNumChannels(), numSamples);
+
+            ProcessStageUp(current, output, stage, firstChannel);
+            current = output;
+        }
+
+        return output;
+    }
+
+    // The oversampled block (after processUp) goes back down into the output.
+
+    void processDown(AudioBlock <SampleType>& output, size_t firstChannel = 0) noexcept
+    {
+        auto numChannels = output.getNumChannels();
+        auto numSamples = output.getNumSamples();
+
+        jassert(firstChannel % Lane::size() == 0);
+        jassert(firstChannel + numChannels <= _numChannels);
+        jassert(_numStages > 0);
+
+        for (auto stage = _numStages; stage-- > 0;)
+        {
+            auto input = StageBlock(stage, firstChannel, numChannels, numSamples);
+            auto lower = stage > 0 ? StageBlock(stage - 1, firstChannel, numChannels, numSamples) : output;
+
+            ProcessStageDown(AudioBlock <const SampleType>(input), lower, stage, firstChannel);
+        }
+    }
+
+private:
+
+    static constexpr size_t maxNumCoefficients = 12;
+
+    // Coefficients of one half-band filter and its group delay at low frequencies
+    // (in samples of the higher rate).
+
+    struct Design
+    {
+        Lane coefficients[maxNumCoefficients];
+        size_t numCoefficients{ 0 };
+
+        double delay{ 0.0 };
+
+        static Design create(Quality quality, size_t stage)
+        {
+            // Specification of the first stage; the next ones keep its audio band, which
+            // is a smaller part of their band (transition = 1/2 - 2 passband / 2^stage).
+
+            const double attenuations[] = { 70.0, 90.0, 120.0 };
+            const double transitions[] = { 0.1, 0.06, 0.03 };
+
+            auto passband = 0.25 - transitions[quality] / 2.0;
+            auto transition = 0.5 - 2.0 * passband / (double)((size_t)1 << stage);
+
+            double values[maxNumCoefficients];
+
+            Design design;
+            design.numCoefficients = ComputeCoefficients(attenuations[quality], transition, values);
+
+            double delays[2] = { 0.0, 1.0 };
+
+            for (size_t i = 0; i < design.numCoefficients; ++i)
+            {
+                design.coefficients[i] = Lane::expand((SampleType)values[i]);
+                delays[i % 2] += 2.0 * (1.0 - values[i]) / (1.0 + values[i]);
+            }
+
+            design.delay = (delays[0] + delays[1]) / 2.0;
+
+            return design;
+        }
+
+        // Design of the allpass coefficients for the attenuation (dB) and the normalized
+        // transition band (Laurent de Soras, "hiir", after Valenzuela and Constantinides).
+
+        static size_t ComputeCoefficients(double attenuation, double transition, double* values)
+        {
+            auto k = std::tan((1.0 - transition * 2.0) * MathConstants <double>::pi / 4.0);
+            k *= k;
+
+            auto kksqrt = std::pow(1.0 - k * k, 0.25);
+            auto e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+            auto e4 = e * e * e * e;
+            auto q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+
+            auto attenuationPower = std::pow(10.0, -attenuation / 10.0);
+            auto a = attenuationPower / (1.0 - attenuationPower);
+            auto order = jmax(3, (int)std::ceil(std::log(a * a / 16.0) / std::log(q)) | 1);
+
+            auto numCoefficients = jmin(maxNumCoefficients, (size_t)(order - 1) / 2);
+
+            for (size_t i = 0; i < numCoefficients; ++i)
+            {
+                auto c = (double)(i + 1);
+                auto num = 0.0;
+                auto den = 0.5;
+
+                for (int j = 0; j < 32; ++j)
+                {
+                    num += std::pow(q, j * (j + 1)) * std::sin((j * 2 + 1) * c * MathConstants <double>::pi / order)
+                         * (j % 2 == 0 ? 1.0 : -1.0);
+                }
+
+                for (int j = 1; j < 32; ++j)
+                {
+                    den += std::pow(q, j * j) * std::cos(j * 2 * c * MathConstants <double>::pi / order)
+                         * (j % 2 == 0 ? 1.0 : -1.0);
+                }
+
+                auto ww = num * std::pow(q, 0.25) / den;
+                auto wwsq = ww * ww;
+                auto x = std::sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+
+                values[i] = (1.0 - x) / (1.0 + x);
+            }
+
+            return numCoefficients;
+        }
+    };
+
+    // States of the allpasses of one stage for a group of channels.
+
+    struct State
+    {
+        Lane upX[maxNumCoefficients];
+        Lane upY[maxNumCoefficients];
+
+        Lane downX[maxNumCoefficients];
+        Lane downY[maxNumCoefficients];
+    };
+
+    // Both chains on a pair of samples: even coefficients on "even", odd ones on "odd".
+
+    static void ProcessChains(const Design& design, Lane* x, Lane* y, Lane& even, Lane& odd) noexcept
+    {
+        for (size_t i = 0; i < design.numCoefficients; i += 2)
+        {
+            auto evenOut = (even - y[i]) * design.coefficients[i] + x[i];
+            x[i] = even;
+            y[i] = evenOut;
+            even = evenOut;
+
+            if (i + 1 < design.numCoefficients)
+            {
+                auto oddOut = (odd - y[i + 1]) * design.coefficients[i + 1] + x[i + 1];
+                x[i + 1] = odd;
+                y[i + 1] = oddOut;
+                odd = oddOut;
+            }
+        }
+    }
+
+    AudioBlock <SampleType> StageBlock(size_t stage, size_t firstChannel, size_t numChannels, size_t numSamples) noexcept
+    {
+        return AudioBlock <SampleType>(_buffers[stage])
+            .getSubsetChannelBlock(firstChannel, numChannels)
+            .getSubBlock(0, numSamples << (stage + 1));
+    }
+
+    void ProcessStageUp(const AudioBlock <const SampleType>& input, AudioBlock <SampleType>& output, size_t stage, size_t firstChannel) noexcept
+    {
+        const auto& design = _designs[_quality][stage];
+        auto numChannels = input.getNumChannels();
+        auto numSamples = input.getNumSamples();
+
+        for (size_t first = 0; first < numChannels; first += Lane::size())
+        {
+            auto& state = _states[((firstChannel + first) / Lane::size()) * maxNumStages + stage];
+            auto numLanes = jmin(Lane::size(), numChannels - first);
+
+            const SampleType* inputs[Lane::size()] = {};
+            SampleType* outputs[Lane::size()] = {};
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                inputs[lane] = input.getChannelPointer(first + lane);
+                outputs[lane] = output.getChannelPointer(first + lane);
+            }
+
+            alignas(sizeof(Lane)) SampleType frame[Lane::size()] = {};
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    frame[lane] = inputs[lane][i];
+                }
+
+                auto even = Lane::fromRawArray(frame);
+                auto odd = even;
+
+                ProcessChains(design, state.upX, state.upY, even, odd);
+
+                even.copyToRawArray(frame);
+
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    outputs[lane][2 * i] = frame[lane];
+                }
+
+                odd.copyToRawArray(frame);
+
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    outputs[lane][2 * i + 1] = frame[lane];
+                }
+            }
+        }
+    }
+
+    void ProcessStageDown(const AudioBlock <const SampleType>& input, AudioBlock <SampleType>& output, size_t stage, size_t firstChannel) noexcept
+    {
+        const auto& design = _designs[_quality][stage];
+        auto numChannels = output.getNumChannels();
+        auto numSamples = output.getNumSamples();
+        auto half = Lane::expand((SampleType)0.5);
+
+        for (size_t first = 0; first < numChannels; first += Lane::size())
+        {
+            auto& state = _states[((firstChannel + first) / Lane::size()) * maxNumStages + stage];
+            auto numLanes = jmin(Lane::size(), numChannels - first);
+
+            const SampleType* inputs[Lane::size()] = {};
+            SampleType* outputs[Lane::size()] = {};
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                inputs[lane] = input.getChannelPointer(first + lane);
+                outputs[lane] = output.getChannelPointer(first + lane);
+            }
+
+            alignas(sizeof(Lane)) SampleType frame[Lane::size()] = {};
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    frame[lane] = inputs[lane][2 * i + 1];
+                }
+
+                auto even = Lane::fromRawArray(frame);
+
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    frame[lane] = inputs[lane][2 * i];
+                }
+
+                auto odd = Lane::fromRawArray(frame);
+
+                ProcessChains(design, state.downX, state.downY, even, odd);
+
+                ((even + odd) * half).copyToRawArray(frame);
+
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    outputs[lane][i] = frame[lane];
+                }
+            }
+        }
+    }
+
+    //------------------------------------------------------------------
+
+    size_t _numChannels{ 0 };
+    size_t _maxNumSamples{ 0 };
+
+    size_t _factor{ 1 };
+    Quality _quality{ normalQuality };
+    size_t _numStages{ 0 };
+
+    int _latencySamples{ 0 };
+
+    Design _designs[numQualities][maxNumStages];
+
+    // Buffers of the stages (stage s runs at 2^(s + 1) times the base rate).
+
+    AudioBuffer <SampleType> _buffers[maxNumStages];
+
+    // States of every stage, maxNumStages per group of channels.
+
+    vector <State> _states;
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CompressorParameters.h"
+
+using namespace juce;
+using namespace std;
+
+//==============================================================================================
+// Compact binary preset.
+//
+// The state of the plugin is the plain value of every parameter, in the order of
+// NamesOfParameters, after a small header (all little endian):
+//
+//   uint32  magic "ECLP"
+//   uint16  version of the layout
+//   uint16  number of parameters
+//   float   values[number of parameters]
+//
+// Every version has a fixed layout, so a preset is read straight into an array without a
+// name lookup. New parameters are only appended to NamesOfParameters, so a preset of an older
+// build has the first of them, and the others get their default values. The older ValueTree
+// blobs (they start with the type name of the tree, never with the magic) are still loaded by
+// the processor through the APVTS.
+
+struct VstPreset
+{
+    using NamesOfParameters = compressor_parameters::NamesOfParameters;
+
+    static constexpr size_t numOfParameters = compressor_parameters::numOfParameters;
+
+    static constexpr uint32 magic = 0x504c4345; // "ECLP"
+    static constexpr uint16 version = 1;
+
+    static constexpr size_t headerSize = 8;
+    static constexpr size_t sizeInBytes = headerSize + numOfParameters * sizeof(float);
+
+    array <float, numOfParameters> values{};
+
+    // Parameters in the preset (fewer in the presets of older builds).
+
+    size_t numValues{ numOfParameters };
+
+    float operator[](NamesOfParameters name) const noexcept { return values[(size_t)name]; }
+
+    // Only the header is checked: a blob without the magic is a ValueTree.
+
+    static bool isPreset(const void* data, size_t size) noexcept
+    {
+        return data != nullptr && size >= headerSize
+            && ByteOrder::littleEndianInt(data) == magic;
+    }
+
+    // Reads the preset without allocation; false (and the values untouched) if the data is not
+    // a preset of this layout.
+
+    bool read(const void* data, size_t size) noexcept
+    {
+        if (!isPreset(data, size))
+            return false;
+
+        auto* bytes = static_cast<const uint8*>(data);
+        auto newNumValues = (size_t)ByteOrder::littleEndianShort(bytes + 6);
+
+        if (ByteOrder::littleEndianShort(bytes + 4) != version
+            || newNumValues == 0 || newNumValues > numOfParameters
+            || size < headerSize + newNumValues * sizeof(float))
+            return false;
+
+        array <float, numOfParameters> newValues{};
+
+        for (size_t i = 0; i < newNumValues; ++i)
+        {
+            auto bits = ByteOrder::littleEndianInt(bytes + headerSize + i * sizeof(float));
+            memcpy(&newValues[i], &bits, sizeof(float));
+
+            if (!isfinite(newValues[i]))
+                return false;
+        }
+
+        values = newValues;
+        numValues = newNumValues;
+
+        return true;
+    }
+
+    void write(MemoryBlock& destinationData) const
+    {
+        MemoryOutputStream stream(destinationData, false);
+
+        stream.writeInt((int)magic);
+        stream.writeShort((short)version);
+        stream.writeShort((short)numOfParameters);
+
+        for (auto value : values)
+        {
+            stream.writeFloat(value);
+        }
+    }
+};
+
+//==============================================================================================
+// The parameters of the APVTS in the order of NamesOfParameters.
+//
+// The parameter objects are looked up by their IDs once. A preset is applied by setting the
+// parameters directly (as a host does), and only those whose value changes: the state of the
+// APVTS is not rebuilt, and the listeners of the other parameters are not called. The tree
+// of the APVTS follows the parameters on its own timer. Parameters that the preset does not
+// have get their default values.
+
+class VstPresetParameters
+{
+public:
+
+    using NamesOfParameters = compressor_parameters::NamesOfParameters;
+
+    static constexpr size_t numOfParameters = compressor_parameters::numOfParameters;
+
+    explicit VstPresetParameters(AudioProcessorValueTreeState& apvts)
+    {
+        const auto& parameters = compressor_parameters::GetParameters();
+
+        for (size_t i = 0; i < numOfParameters; ++i)
+        {
+            _parameters[i] = apvts.getParameter(parameters.at((NamesOfParameters)i));
+
+            jassert(_parameters[i] != nullptr);
+        }
+    }
+
+    VstPreset capture() const
+    {
+        VstPreset preset;
+
+        for (size_t i = 0; i < numOfParameters; ++i)
+        {
+            preset.values[i] = _parameters[i]->convertFrom0to1(_parameters[i]->getValue());
+        }
+
+        return preset;
+    }
+
+    // Returns the number of parameters that changed.
+
+    int apply(const VstPreset& preset)
+    {
+        auto numChanged = 0;
+
+        for (size_t i = 0; i < numOfParameters; ++i)
+        {
+            auto* parameter = _parameters[i];
+            auto value = i < preset.numValues ? parameter->convertTo0to1(preset.values[i])
+                                              : parameter->getDefaultValue();
+
+            if (value != parameter->getValue())
+            {
+                parameter->setValueNotifyingHost(value);
+                ++numChanged;
+            }
+        }
+
+        return numChanged;
+    }
+
+private:
+
+    array <RangedAudioParameter*, numOfParameters> _parameters{};
+
+    JUCE_DECLARE_NON_COPYABLE(VstPresetParameters)
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+using namespace std;
+
+//==============================================================================================
+// Background thread of one kind of client, shared by all instances in the process
+// (SharedResourcePointer <VstServiceThread <Client>>). It serves its clients every
+// Client::serviceIntervalMs and sleeps while it has none.
+//
+// The client declares serviceThreadName and serviceIntervalMs, and two private functions for
+// the thread (which is its friend): Restart() when it is added, and Serve() on every visit.
+// Both are called with the lock of the thread held, so a client is never served while it is
+// added or removed, and it is not visited any more once remove() has returned.
+
+template <typename Client>
+
+class VstServiceThread : public Thread
+{
+public:
+
+    VstServiceThread() : Thread(Client::serviceThreadName)
+    {
+        startThread();
+    }
+
+    ~VstServiceThread() override
+    {
+        stopThread(1000);
+    }
+
+    // Message thread: a client is served from add() until remove() returns.
+
+    void add(Client* client)
+    {
+        {
+            const ScopedLock lock(_lock);
+
+            client->Restart();
+            _clients.addIfNotAlreadyThere(client);
+        }
+
+        notify();
+    }
+
+    void remove(Client* client)
+    {
+        const ScopedLock lock(_lock);
+
+        _clients.removeFirstMatchingValue(client);
+    }
+
+    // Message thread: serves a client now, on the calling thread (e.g. before playing).
+
+    void serve(Client* client)
+    {
+        const ScopedLock lock(_lock);
+
+        client->Serve();
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            auto isIdle = false;
+
+            {
+                const ScopedLock lock(_lock);
+
+                for (auto* client : _clients)
+                {
+                    client->Serve();
+                }
+
+                isIdle = _clients.isEmpty();
+            }
+
+            wait(isIdle ? -1 : Client::serviceIntervalMs);
+        }
+    }
+
+private:
+
+    CriticalSection _lock;
+    Array <Client*> _clients;
+
+    JUCE_DECLARE_NON_COPYABLE(VstServiceThread)
+};
@@ -0,0 +1,432 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "VstServiceThread.h"
+#include "VstTripleBuffer.h"
+
+using namespace juce;
+using namespace dsp;
+using namespace std;
+
+//==============================================================================================
+// Spectra of the input and the output of the processor, for the editor.
+//
+// The audio thread only copies every block (its first maxNumChannels channels) into a
+// single-producer, single-consumer ring of its tap, and only while an editor is open. A full
+// ring (analysis stalled) drops the block. Nothing else is done on the audio thread.
+//
+// The FFTs run on one background thread shared by all instances of the plugin in the process
+// (VstServiceThread), which visits every enabled analyzer every serviceIntervalMs. The FFT,
+// the window and the work buffers are shared as well (VstAnalyzerWorkspace), only that
+// thread uses them. A tap with at least hopSize new samples gets one frame
+// of the last fftSize samples: Hann window, power spectrum summed over the channels, and the
+// maximum of the bins around each of numPoints log-spaced frequencies (interpolated where the
+// points are closer than the bins). All of them are vector operations. Levels fall back at
+// fallDecibelsPerSecond.
+//
+// The finished spectra go to the editor through a triple buffer (VstTripleBuffer), so neither
+// side waits and the editor always gets the latest one.
+
+//==============================================================================================
+// Buffers of one frame, one set per process (SharedResourcePointer) for all analyzers: only
+// the thread of the analyzers uses them.
+
+struct VstAnalyzerWorkspace
+{
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    FFT fft{ fftOrder };
+
+    vector <float> window = vector <float>((size_t)fftSize);
+    vector <float> frame = vector <float>(2 * (size_t)fftSize);
+    vector <float> power = vector <float>((size_t)numBins);
+
+    VstAnalyzerWorkspace()
+    {
+        WindowingFunction <float>::fillWindowingTables(window.data(), (size_t)fftSize,
+                                                       WindowingFunction <float>::hann, false);
+    }
+};
+
+//==============================================================================================
+
+class VstSpectrumAnalyzer
+{
+public:
+
+    static constexpr int fftSize = VstAnalyzerWorkspace::fftSize;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int ringSize = 4 * fftSize;
+
+    static constexpr int maxNumChannels = 2;
+
+    static constexpr size_t numPoints = 256;
+
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+
+    static constexpr float minDecibels = -96.0f;
+    static constexpr float fallDecibelsPerSecond = 36.0f;
+
+    // The thread of the analyzers (VstServiceThread).
+
+    static constexpr const char* serviceThreadName = "Eclistar analyzer";
+    static constexpr int serviceIntervalMs = 15;
+
+    enum Tap
+    {
+        inputTap,
+        outputTap,
+
+        numTaps
+    };
+
+    // Levels (dB) of both taps at the points.
+
+    struct Spectrum
+    {
+        array <array <float, numPoints>, numTaps> levels;
+
+        Spectrum() noexcept
+        {
+            for (auto& tapLevels : levels)
+            {
+                tapLevels.fill(minDecibels);
+            }
+        }
+    };
+
+    static float getFrequency(size_t point) noexcept
+    {
+        return minFrequency * std::pow(maxFrequency / minFrequency, (float)point / (float)(numPoints - 1));
+    }
+
+    VstSpectrumAnalyzer()
+    {
+        for (auto& tap : _taps)
+        {
+            for (size_t channel = 0; channel < (size_t)maxNumChannels; ++channel)
+            {
+                tap.ring[channel].resize((size_t)ringSize);
+                tap.history[channel].resize((size_t)fftSize);
+            }
+        }
+    }
+
+    ~VstSpectrumAnalyzer()
+    {
+        setEnabled(false);
+    }
+
+    // Audio side: the sample rate (called before playing) and the blocks of a tap.
+
+    void prepare(double sampleRate)
+    {
+        _sampleRate.store(sampleRate, memory_order_relaxed);
+    }
+
+    bool isEnabled() const noexcept
+    {
+        return _enabled.load(memory_order_relaxed);
+    }
+
+    template <typename SampleType>
+
+    void push(Tap tapIndex, const AudioBuffer <SampleType>& buffer) noexcept
+    {
+        if (!isEnabled())
+            return;
+
+        auto& tap = _taps[(size_t)tapIndex];
+        auto numChannels = jmin(maxNumChannels, buffer.getNumChannels());
+        auto numSamples = buffer.getNumSamples();
+
+        if (numChannels == 0 || numSamples > tap.fifo.getFreeSpace())
+            return;
+
+        int start1, size1, start2, size2;
+        tap.fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            auto* ring = tap.ring[(size_t)channel].data();
+            auto* samples = buffer.getReadPointer(channel);
+
+            CopySamples(ring + start1, samples, size1);
+            CopySamples(ring + start2, samples + size1, size2);
+        }
+
+        tap.numChannels.store(numChannels, memory_order_relaxed);
+        tap.fifo.finishedWrite(size1 + size2);
+    }
+
+    // Message thread: the editor enables the analyzer while it is open, and reads the latest
+    // spectrum on its timer (false if there is no new one).
+
+    void setEnabled(bool shouldBeEnabled)
+    {
+        if (shouldBeEnabled == _isServed)
+            return;
+
+        _isServed = shouldBeEnabled;
+
+        if (shouldBeEnabled)
+        {
+            _thread->add(this);
+            _enabled.store(true, memory_order_relaxed);
+        }
+        else
+        {
+            _enabled.store(false, memory_order_relaxed);
+            _thread->remove(this);
+        }
+    }
+
+    bool read(Spectrum& spectrum) noexcept
+    {
+        return _spectra.read(spectrum);
+    }
+
+private:
+
+    friend class VstServiceThread <VstSpectrumAnalyzer>;
+
+    struct TapState
+    {
+        // Written by the audio thread.
+
+        AbstractFifo fifo{ ringSize };
+        array <vector <float>, (size_t)maxNumChannels> ring;
+        atomic <int> numChannels{ 0 };
+
+        // Analysis: the last fftSize samples and the levels at the points.
+
+        array <vector <float>, (size_t)maxNumChannels> history;
+        array <float, numPoints> levels{};
+        int numNewSamples{ 0 };
+    };
+
+    template <typename SampleType>
+
+    static void CopySamples(float* destination, const SampleType* source, int numSamples) noexcept
+    {
+        if constexpr (is_same <SampleType, float>::value)
+        {
+            FloatVectorOperations::copy(destination, source, numSamples);
+        }
+        else
+        {
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                destination[i] = (float)source[i];
+            }
+        }
+    }
+
+    // Background side, with the lock of the thread held.
+
+    void Restart()
+    {
+        for (auto& tap : _taps)
+        {
+            auto numReady = tap.fifo.getNumReady();
+
+            int start1, size1, start2, size2;
+            tap.fifo.prepareToRead(numReady, start1, size1, start2, size2);
+            tap.fifo.finishedRead(size1 + size2);
+
+            for (auto& history : tap.history)
+            {
+                fill(history.begin(), history.end(), 0.0f);
+            }
+
+            tap.levels.fill(minDecibels);
+            tap.numNewSamples = 0;
+        }
+    }
+
+    void Serve()
+    {
+        Analyse(_workspace.get());
+    }
+
+    void Analyse(VstAnalyzerWorkspace& workspace)
+    {
+        auto sampleRate = _sampleRate.load(memory_order_relaxed);
+
+        if (sampleRate != _mappedRate)
+        {
+            MapPoints(sampleRate);
+        }
+
+        auto hasNewFrame = false;
+
+        for (auto& tap : _taps)
+        {
+            ReadRing(tap);
+
+            if (tap.numNewSamples >= hopSize)
+            {
+                AnalyseFrame(tap, workspace);
+                hasNewFrame = true;
+            }
+        }
+
+        if (!hasNewFrame)
+            return;
+
+        auto& spectrum = _spectra.getBack();
+
+        for (size_t tap = 0; tap < numTaps; ++tap)
+        {
+            spectrum.levels[tap] = _taps[tap].levels;
+        }
+
+        _spectra.publish();
+    }
+
+    // New samples are appended to the history (only the last fftSize of them are kept).
+
+    void ReadRing(TapState& tap)
+    {
+        auto numReady = tap.fifo.getNumReady();
+
+        if (numReady == 0)
+            return;
+
+        int start1, size1, start2, size2;
+        tap.fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+        auto numChannels = tap.numChannels.load(memory_order_relaxed);
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            auto& history = tap.history[(size_t)channel];
+            const auto* ring = tap.ring[(size_t)channel].data();
+
+            auto Append = [&history](const float* samples, int numSamples)
+            {
+                if (numSamples >= fftSize)
+                {
+                    FloatVectorOperations::copy(history.data(), samples + numSamples - fftSize, fftSize);
+                    return;
+                }
+
+                memmove(history.data(), history.data() + numSamples, sizeof(float) * (size_t)(fftSize - numSamples));
+                FloatVectorOperations::copy(history.data() + fftSize - numSamples, samples, numSamples);
+            };
+
+            Append(ring + start1, size1);
+            Append(ring + start2, size2);
+        }
+
+        tap.fifo.finishedRead(size1 + size2);
+        tap.numNewSamples += size1 + size2;
+    }
+
+    void AnalyseFrame(TapState& tap, VstAnalyzerWorkspace& workspace)
+    {
+        constexpr auto numBins = VstAnalyzerWorkspace::numBins;
+
+        auto* frame = workspace.frame.data();
+        auto* power = workspace.power.data();
+
+        auto numChannels = jmax(1, tap.numChannels.load(memory_order_relaxed));
+
+        FloatVectorOperations::clear(power, numBins);
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            FloatVectorOperations::multiply(frame, tap.history[(size_t)channel].data(), workspace.window.data(), fftSize);
+            FloatVectorOperations::clear(frame + fftSize, fftSize);
+
+            workspace.fft.performFrequencyOnlyForwardTransform(frame, true);
+
+            FloatVectorOperations::multiply(frame, frame, numBins);
+            FloatVectorOperations::add(power, frame, numBins);
+        }
+
+        // A sine of amplitude 1 gives fftSize / 4 in its bin (Hann window), so it reads 0 dB.
+
+        auto scale = 1.0f / ((float)numChannels * square((float)fftSize / 4.0f));
+        auto fall = fallDecibelsPerSecond * (float)tap.numNewSamples / (float)jmax(1.0, _mappedRate);
+
+        for (size_t point = 0; point < numPoints; ++point)
+        {
+            auto first = _firstBins[point];
+            auto last = _lastBins[point];
+
+            auto value = last > first
+                ? FloatVectorOperations::findMaximum(power + first, last - first + 1)
+                : jmap(_fractions[point], power[first], power[jmin(first + 1, numBins - 1)]);
+
+            auto decibels = jmax(minDecibels, 10.0f * std::log10(value * scale + 1.0e-12f));
+
+            tap.levels[point] = jmax(decibels, tap.levels[point] - fall);
+        }
+
+        tap.numNewSamples = 0;
+    }
+
+    // Bins around every point: from the middle between it and the previous point to the middle
+    // between it and the next one.
+
+    void MapPoints(double sampleRate)
+    {
+        constexpr auto numBins = VstAnalyzerWorkspace::numBins;
+
+        _mappedRate = sampleRate;
+
+        auto binOf = [sampleRate](float frequency)
+        {
+            return (float)((double)frequency * (double)fftSize / jmax(1.0, sampleRate));
+        };
+
+        for (size_t point = 0; point < numPoints; ++point)
+        {
+            auto bin = binOf(getFrequency(point));
+            auto lower = binOf(std::sqrt(getFrequency(point) * getFrequency(point == 0 ? 0 : point - 1)));
+            auto upper = binOf(std::sqrt(getFrequency(point) * getFrequency(jmin(numPoints - 1, point + 1))));
+
+            _firstBins[point] = jlimit(0, numBins - 1, (int)std::ceil(lower));
+            _lastBins[point] = jlimit(0, numBins - 1, (int)std::floor(upper));
+
+            if (_lastBins[point] <= _firstBins[point])
+            {
+                _firstBins[point] = _lastBins[point] = jlimit(0, numBins - 1, (int)bin);
+                _fractions[point] = jlimit(0.0f, 1.0f, bin - (float)_firstBins[point]);
+            }
+        }
+    }
+
+    //------------------------------------------------------------------
+
+    atomic <bool> _enabled{ false };
+    atomic <double> _sampleRate{ 48000.0 };
+
+    array <TapState, numTaps> _taps;
+
+    // Analysis.
+
+    double _mappedRate{ 0.0 };
+
+    array <int, numPoints> _firstBins{};
+    array <int, numPoints> _lastBins{};
+    array <float, numPoints> _fractions{};
+
+    // Spectra: the analysis writes the back one, the editor reads the front one.
+
+    VstTripleBuffer <Spectrum> _spectra;
+
+    SharedResourcePointer <VstAnalyzerWorkspace> _workspace;
+
+    // Message thread.
+
+    bool _isServed{ false };
+
+    SharedResourcePointer <VstServiceThread <VstSpectrumAnalyzer>> _thread;
+
+    JUCE_DECLARE_NON_COPYABLE(VstSpectrumAnalyzer)
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+using namespace std;
+
+//==============================================================================================
+// Triple buffer from one writing thread to one reading thread. The writer fills the back value
+// and publishes it, the reader takes the newest published one. Neither side waits, and the
+// reader always gets the latest value.
+//
+// The middle index holds the value between the two sides, with the flag of a new value in it.
+
+template <typename ValueType>
+
+class VstTripleBuffer
+{
+public:
+
+    VstTripleBuffer() = default;
+
+    // Writer: the value to fill, then publish() makes it the newest one.
+
+    ValueType& getBack() noexcept
+    {
+        return _values[(size_t)_back];
+    }
+
+    void publish() noexcept
+    {
+        _back = _middle.exchange(_back | isNew, memory_order_acq_rel) & indexMask;
+    }
+
+    // Reader: the newest value (false if there is no new one since the last read).
+
+    bool read(ValueType& value) noexcept
+    {
+        if ((_middle.load(memory_order_acquire) & isNew) == 0)
+            return false;
+
+        _front = _middle.exchange(_front, memory_order_acq_rel) & indexMask;
+        value = _values[(size_t)_front];
+
+        return true;
+    }
+
+private:
+
+    static constexpr int indexMask = 3;
+    static constexpr int isNew = 4;
+
+    array <ValueType, 3> _values;
+
+    atomic <int> _middle{ 1 };
+    int _front{ 0 };
+    int _back{ 2 };
+
+    JUCE_DECLARE_NON_COPYABLE(VstTripleBuffer)
+};
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <thread>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+#if JUCE_LINUX
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#endif
+
+using namespace juce;
+using namespace std;
+
+//==============================================================================================
+// Small pool of worker threads for the audio thread.
+//
+// run() hands a job of numTasks independent tasks to the workers, takes part in it itself and
+// returns when all tasks are done. Nothing is allocated or locked there: the function is called
+// through a pointer, and the tasks are claimed with a compare-and-swap on one atomic word that
+// holds the number of the job, the number of its tasks and the next free task. A worker that is
+// late for a job can't claim a task of the next one, as the number of the job has changed.
+//
+// Between jobs the workers spin for spinSeconds (so the next block finds them awake), then park.
+// Only a parked worker is woken by run(): with blocks coming in quickly this never happens,
+// after a pause it costs one wake-up. The wake-up takes no mutex (a futex on Linux, a dispatch
+// semaphore on Apple systems, an event elsewhere), but it still enters the kernel, so the pool
+// is meant for offline rendering, where the blocks follow each other without pauses.
+//
+// Worker i is pinned to the CPU i + 1 (the audio thread usually runs on the first ones), and
+// runs without denormals, as the audio thread does. There are at most as many workers as other
+// CPUs, so no two of them share one. start() and stop() create and join the threads, so they
+// are called outside of the audio thread (prepareToPlay, releaseResources).
+
+class VstWorkerPool
+{
+public:
+
+    static constexpr size_t maxNumWorkers = 15;
+
+    static constexpr double spinSeconds = 0.001;
+
+    VstWorkerPool() = default;
+
+    ~VstWorkerPool()
+    {
+        stop();
+    }
+
+    // Number of threads besides the calling one (0 runs everything on the calling thread).
+
+    void start(size_t numWorkers)
+    {
+        numWorkers = jmin(numWorkers, maxNumWorkers, (size_t)jmax(0, SystemStats::getNumCpus() - 1));
+
+        if (numWorkers == _workers.size())
+            return;
+
+        stop();
+
+        _shouldExit.store(false);
+
+        for (size_t i = 0; i < numWorkers; ++i)
+        {
+            _workers.push_back(make_unique <Worker>());
+        }
+
+        for (size_t i = 0; i < numWorkers; ++i)
+        {
+            _workers[i]->handle = thread([this, i] { RunWorker(i); });
+        }
+    }
+
+    void stop()
+    {
+        _shouldExit.store(true);
+
+        for (auto& worker : _workers)
+        {
+            worker->wakeUp.signal();
+            worker->handle.join();
+        }
+
+        _workers.clear();
+    }
+
+    size_t getNumWorkers() const noexcept { return _workers.size(); }
+
+    // Calls function(task) for every task 0 ... numTasks - 1 on the workers and the calling
+    // thread, and returns when all of them have returned. The tasks must be independent.
+
+    template <typename Function>
+
+    void run(size_t numTasks, Function& function) noexcept
+    {
+        jassert(numTasks <= maxNumTasks);
+
+        if (_workers.empty() || numTasks < 2)
+        {
+            for (size_t task = 0; task < numTasks; ++task)
+            {
+                function(task);
+            }
+
+            return;
+        }
+
+        // The previous job is over (no worker is inside one of its tasks), so the job can
+        // be written before its number is published.
+
+        _context = &function;
+        _invoke = [](void* context, size_t task) { (*static_cast <Function*>(context))(task); };
+
+        _numPending.store(numTasks, memory_order_relaxed);
+
+        auto job = ++_job;
+
+        _tasks.store(((uint64)job << 32) | ((uint64)numTasks << 16));
+
+        for (auto& worker : _workers)
+        {
+            if (worker->isParked.load())
+                worker->wakeUp.signal();
+        }
+
+        RunTasks(job);
+
+        while (_numPending.load(memory_order_acquire) != 0)
+        {
+            Pause();
+        }
+    }
+
+private:
+
+    static constexpr size_t maxNumTasks = 0xffff;
+
+    // Wake-up of a parked worker: signal() takes no mutex, and enters the kernel only to wake
+    // a thread that waits. A signal before the wait makes the wait return at once.
+
+    class WakeUp
+    {
+    public:
+
+#if JUCE_LINUX
+        WakeUp() = default;
+
+        void signal() noexcept
+        {
+            if (_isSignalled.exchange(1) == 0)
+                syscall(SYS_futex, &_isSignalled, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+
+        void wait(int timeOutMs) noexcept
+        {
+            if (_isSignalled.load() == 0)
+            {
+                timespec timeOut{ timeOutMs / 1000, (long)(timeOutMs % 1000) * 1000000 };
+                syscall(SYS_futex, &_isSignalled, FUTEX_WAIT_PRIVATE, 0, &timeOut, nullptr, 0);
+            }
+
+            _isSignalled.store(0);
+        }
+
+    private:
+
+        static_assert(sizeof(atomic <uint32>) == sizeof(uint32), "The futex is a plain 32-bit word.");
+
+        atomic <uint32> _isSignalled{ 0 };
+
+#elif JUCE_MAC || JUCE_IOS
+        WakeUp() : _semaphore(dispatch_semaphore_create(0)) {}
+        ~WakeUp() { dispatch_release(_semaphore); }
+
+        void signal() noexcept
+        {
+            if (!_isSignalled.exchange(true))
+                dispatch_semaphore_signal(_semaphore);
+        }
+
+        void wait(int timeOutMs) noexcept
+        {
+            dispatch_semaphore_wait(_semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)timeOutMs * 1000000));
+            _isSignalled.store(false);
+        }
+
+    private:
+
+        dispatch_semaphore_t _semaphore;
+        atomic <bool> _isSignalled{ false };
+
+#else
+        WakeUp() = default;
+
+        void signal() noexcept { _event.signal(); }
+        void wait(int timeOutMs) noexcept { _event.wait(timeOutMs); }
+
+    private:
+
+        WaitableEvent _event;
+#endif
+
+        JUCE_DECLARE_NON_COPYABLE(WakeUp)
+    };
+
+    struct Worker
+    {
+        thread handle;
+        WakeUp wakeUp;
+        atomic <bool> isParked{ false };
+    };
+
+    static void Pause() noexcept
+    {
+#if JUCE_INTEL
+        _mm_pause();
+#elif JUCE_ARM && (defined(__GNUC__) || defined(__clang__))
+        __asm__ __volatile__("yield");
+#endif
+    }
+
+    uint32 CurrentJob() const noexcept
+    {
+        return (uint32)(_tasks.load() >> 32);
+    }
+
+    // Claims the next task of the job (false when the job has no free task left or is over).
+
+    bool ClaimTask(uint32 job, size_t& task) noexcept
+    {
+        auto tasks = _tasks.load(memory_order_acquire);
+
+        for (;;)
+        {
+            auto next = (size_t)(tasks & 0xffff);
+
+            if ((uint32)(tasks >> 32) != job || next >= (size_t)((tasks >> 16) & 0xffff))
+                return false;
+
+            if (_tasks.compare_exchange_weak(tasks, tasks + 1, memory_order_acq_rel, memory_order_acquire))
+            {
+                task = next;
+                return true;
+            }
+        }
+    }
+
+    void RunTasks(uint32 job) noexcept
+    {
+        size_t task = 0;
+
+        while (ClaimTask(job, task))
+        {
+            _invoke(_context, task);
+            _numPending.fetch_sub(1, memory_order_release);
+        }
+    }
+
+    void RunWorker(size_t index)
+    {
+        Thread::setCurrentThreadAffinityMask(1u << ((index + 1) % (size_t)jmin(32, SystemStats::getNumCpus())));
+
+        ScopedNoDenormals noDenormals;
+
+        auto& worker = *_workers[index];
+        auto spinTicks = (int64)(spinSeconds * (double)Time::getHighResolutionTicksPerSecond());
+        auto job = CurrentJob();
+
+        while (!_shouldExit.load())
+        {
+            // Spin on the number of the job, then park until the next one.
+
+            auto spinEnd = Time::getHighResolutionTicks() + spinTicks;
+
+            while (CurrentJob() == job && !_shouldExit.load())
+            {
+                if (Time::getHighResolutionTicks() < spinEnd)
+                {
+                    for (int i = 0; i < 64; ++i)
+                    {
+                        Pause();
+                    }
+
+                    continue;
+                }
+
+                worker.isParked.store(true);
+
+                if (CurrentJob() == job && !_shouldExit.load())
+                    worker.wakeUp.wait(100);
+
+                worker.isParked.store(false);
+
+                spinEnd = Time::getHighResolutionTicks() + spinTicks;
+            }
+
+            job = CurrentJob();
+
+            RunTasks(job);
+        }
+    }
+
+    //------------------------------------------------------------------
+
+    vector <unique_ptr <Worker>> _workers;
+
+    atomic <bool> _shouldExit{ false };
+
+    // The job: number (upper 32 bits), number of tasks and next free task (16 bits each).
+
+    atomic <uint64> _tasks{ 0 };
+    atomic <size_t> _numPending{ 0 };
+
+    uint32 _job{ 0 };
+
+    void* _context{ nullptr };
+    void (*_invoke)(void*, size_t){ nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE(VstWorkerPool)
+};
@@ -0,0 +1,385 @@
+#include <JuceHeader.h>
+#include "../eclistarVST(main)/PluginProcessor.h"
+#include "RealtimeSafety.h"
+
+#include <iostream>
+
+using namespace compressor_parameters;
+
+//==============================================================================================
+// Real-time safety validator (Linux): runs EclistarVSTAudioProcessor through randomized
+// parameter sweeps, block sizes, bus layouts and precisions, with processBlock under the
+// tracer of RealtimeSafety.h. Any allocation, blocking lock or system call on the audio thread
+// is printed with its call stack and the configuration of the block; the exit code is 1 then.
+//
+// Every configuration is a fresh processor: a layout (1 to 16 channels, the sidechain off,
+// mono or with the channels of the input), a precision, a sample rate and a maximum block
+// size, random parameters and random optional features (metering, spectrum analyzer, block
+// tracing, fused engine, parallel processing, scalar compressors, control rate). Its blocks
+// have random sizes (down to 0 samples, and sometimes more than announced in prepareToPlay)
+// and alternate noise, sine and silence, so the sleep is entered and left. Between the blocks
+// the message thread changes random parameters (the topology too: bands, oversampling, linear
+// phase, lookahead), loads a state, reads the meters and the spectrum, or prepares the
+// processor again, as a host does.
+//
+// The processor runs in real time, so the parallel processing (offline rendering only) must
+// leave its blocks on the audio thread even while it is on.
+//
+// A listener stands in for the wrapper of a host (HostListener): it takes a lock for every
+// notification, as the wrappers do, so a change of the latency or of the display reported
+// from processBlock (updateHostDisplay, setLatencySamples) is a violation with its stack. The
+// notifications of the message thread are not traced.
+
+namespace
+{
+    const char* const usage =
+        "Usage: eclistarValidate [options]\n"
+        "\n"
+        "  --seed <number>         seed of the first configuration (default: 1)\n"
+        "  --configurations <n>    number of random configurations (default: 100)\n"
+        "  --blocks <n>            blocks per configuration (default: 400)\n"
+        "  --abort                 stop at the first violation (for a debugger or a core dump)\n";
+
+    struct ValidateOptions
+    {
+        int64 seed{ 1 };
+        int numConfigurations{ 100 };
+        int numBlocks{ 400 };
+        bool abortOnViolation{ false };
+    };
+
+    bool ParseOptions(const StringArray& arguments, ValidateOptions& options)
+    {
+        for (int i = 0; i < arguments.size(); ++i)
+        {
+            const auto& argument = arguments[i];
+            auto hasValue = i + 1 < arguments.size();
+
+            if (argument == "--seed" && hasValue)
+                options.seed = arguments[++i].getLargeIntValue();
+            else if (argument == "--configurations" && hasValue)
+                options.numConfigurations = arguments[++i].getIntValue();
+            else if (argument == "--blocks" && hasValue)
+                options.numBlocks = arguments[++i].getIntValue();
+            else if (argument == "--abort")
+                options.abortOnViolation = true;
+            else
+                return false;
+        }
+
+        return options.numConfigurations > 0 && options.numBlocks > 0;
+    }
+
+    //------------------------------------------------------------------
+    // Random configuration of one processor.
+
+    struct Configuration
+    {
+        int64 seed{ 0 };
+
+        AudioProcessor::BusesLayout layout;
+        AudioProcessor::ProcessingPrecision precision{ AudioProcessor::singlePrecision };
+
+        double sampleRate{ 48000.0 };
+        int maxBlockSize{ 512 };
+
+        String toString() const
+        {
+            auto sidechain = layout.getChannelSet(true, 1);
+
+            return "seed " + String(seed) + ", " + String(layout.getMainInputChannelSet().size()) + " channels"
+                 + (sidechain.isDisabled() ? String(" without sidechain") : ", sidechain of " + String(sidechain.size()))
+                 + ", " + (precision == AudioProcessor::doublePrecision ? "double" : "float")
+                 + ", " + String(sampleRate, 0) + " Hz, blocks of up to " + String(maxBlockSize);
+        }
+    };
+
+    template <typename Element, size_t size>
+
+    const Element& Choose(Random& random, const Element (&elements)[size])
+    {
+        return elements[random.nextInt((int)size)];
+    }
+
+    Configuration MakeConfiguration(int64 seed)
+    {
+        Random random(seed);
+        Configuration configuration;
+
+        configuration.seed = seed;
+
+        const int channelCounts[] = { 1, 2, 2, 2, 3, 4, 6, 8, 12, 16 };
+        auto numChannels = Choose(random, channelCounts);
+        auto channelSet = AudioChannelSet::canonicalChannelSet(numChannels);
+
+        if (channelSet.isDisabled())
+            channelSet = AudioChannelSet::discreteChannels(numChannels);
+
+        // The sidechain is off, mono, or has the channels of the input.
+
+        auto sidechainKind = random.nextInt(3);
+        auto sidechain = sidechainKind == 0 ? AudioChannelSet::disabled()
+                       : sidechainKind == 1 ? AudioChannelSet::mono()
+                                            : channelSet;
+
+        configuration.layout.inputBuses.add(channelSet);
+        configuration.layout.inputBuses.add(sidechain);
+        configuration.layout.outputBuses.add(channelSet);
+
+        configuration.precision = random.nextBool() ? AudioProcessor::doublePrecision : AudioProcessor::singlePrecision;
+
+        const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+        const int blockSizes[] = { 16, 32, 64, 128, 256, 441, 480, 512, 1024, 2048, 4096 };
+
+        configuration.sampleRate = Choose(random, sampleRates);
+        configuration.maxBlockSize = Choose(random, blockSizes);
+
+        return configuration;
+    }
+
+    //------------------------------------------------------------------
+    // The host side of the notifications of the processor.
+
+    struct HostListener : public AudioProcessorListener
+    {
+        void audioProcessorParameterChanged(AudioProcessor*, int, float) override
+        {
+            const ScopedLock lock(hostLock);
+        }
+
+        void audioProcessorChanged(AudioProcessor*, const ChangeDetails&) override
+        {
+            const ScopedLock lock(hostLock);
+        }
+
+        CriticalSection hostLock;
+    };
+
+    //------------------------------------------------------------------
+    // Message thread: random values of some parameters, and the optional features.
+
+    void ChangeParameters(EclistarVSTAudioProcessor& processor, Random& random, int numChanges)
+    {
+        const auto& parameters = processor.getParameters();
+
+        for (int i = 0; i < numChanges; ++i)
+        {
+            parameters[random.nextInt(parameters.size())]->setValueNotifyingHost(random.nextFloat());
+        }
+    }
+
+    void ChangeFeatures(EclistarVSTAudioProcessor& processor, Random& random)
+    {
+        processor.setMeteringEnabled(random.nextBool());
+        processor.getSpectrumAnalyzer().setEnabled(random.nextBool());
+        processor.setTracingEnabled(random.nextBool());
+        processor.setFusedProcessing(random.nextBool(), 16 << random.nextInt(4));
+        processor.setParallelProcessing(random.nextBool(), 1 + random.nextInt(3), 64);
+        processor.setScalarCompression(random.nextInt(4) == 0);
+        processor.setControlRate(1 << random.nextInt(8));
+    }
+
+    // The editor side: the meters, the spectrum and the trace report are read, so their
+    // FIFOs do not stay full.
+
+    void ReadDisplays(EclistarVSTAudioProcessor& processor)
+    {
+        VstMeteringBus::Levels levels;
+        processor.getMeteringBus().read(levels);
+
+        VstSpectrumAnalyzer::Spectrum spectrum;
+        processor.getSpectrumAnalyzer().read(spectrum);
+
+        VstBlockTracer::Report report;
+        processor.getBlockTracer().read(report);
+    }
+
+    //------------------------------------------------------------------
+    // Audio thread: the input of a block (main bus and sidechain) and its processing.
+
+    template <typename SampleType>
+
+    void FillBlock(AudioBuffer <SampleType>& buffer, Random& random, int signal, double& phase, double increment)
+    {
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            auto value = signal == 0 ? (SampleType)(random.nextFloat() * 2.0f - 1.0f)
+                       : signal == 1 ? (SampleType)(0.5 * std::sin(phase))
+                                     : (SampleType)0;
+
+            phase += increment;
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            {
+                buffer.setSample(channel, i, value);
+            }
+        }
+    }
+
+    // Runs one configuration; returns the number of violations in its blocks.
+
+    template <typename SampleType>
+
+    int RunConfiguration(EclistarVSTAudioProcessor& processor, const Configuration& configuration,
+                         const ValidateOptions& options, Random& random)
+    {
+        auto numChannels = jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+
+        // Room for blocks of up to twice the announced size, allocated before the audio starts.
+
+        AudioBuffer <SampleType> buffer(numChannels, 2 * configuration.maxBlockSize);
+        MidiBuffer midiMessages;
+        MemoryBlock state;
+
+        auto numViolations = 0;
+        auto signal = 0;
+        auto phase = 0.0;
+        auto increment = MathConstants <double>::twoPi * 1000.0 / configuration.sampleRate;
+
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            // Message thread, between the blocks.
+
+            auto event = random.nextInt(100);
+
+            if (event < 10)
+                ChangeParameters(processor, random, 1 + random.nextInt(3));
+            else if (event < 12)
+                ChangeFeatures(processor, random);
+            else if (event < 13)
+                processor.getStateInformation(state);
+            else if (event < 14 && state.getSize() > 0)
+                processor.setStateInformation(state.getData(), (int)state.getSize());
+            else if (event < 15)
+                processor.prepareToPlay(configuration.sampleRate, configuration.maxBlockSize);
+
+            if (random.nextInt(8) == 0)
+                ReadDisplays(processor);
+
+            // Background threads (kernels of the linear phase, analyzer, tracer) catch up.
+
+            if (random.nextInt(50) == 0)
+                Thread::sleep(1);
+
+            // The size of the block: mostly up to the announced maximum, sometimes empty or
+            // larger than announced (processed in parts).
+
+            auto sizeKind = random.nextInt(20);
+            auto numSamples = sizeKind == 0 ? 0
+                            : sizeKind == 1 ? configuration.maxBlockSize + 1 + random.nextInt(configuration.maxBlockSize)
+                            : sizeKind < 10 ? configuration.maxBlockSize
+                                            : 1 + random.nextInt(configuration.maxBlockSize);
+
+            if (random.nextInt(40) == 0)
+                signal = random.nextInt(3);
+
+            buffer.setSize(numChannels, numSamples, false, false, true);
+            FillBlock(buffer, random, signal, phase, increment);
+
+            auto violationsBefore = realtime_safety::getNumberOfViolations();
+
+            {
+                realtime_safety::ScopedAudioThread audioThread;
+
+                processor.processBlock(buffer, midiMessages);
+            }
+
+            auto violations = realtime_safety::getNumberOfViolations() - violationsBefore;
+
+            if (violations > 0)
+            {
+                numViolations += violations;
+
+                std::cerr << "    in block " << block << " of " << numSamples << " samples, "
+                          << configuration.toString() << "\n";
+            }
+        }
+
+        return numViolations;
+    }
+
+    int ValidateConfiguration(const Configuration& configuration, const ValidateOptions& options)
+    {
+        Random random(configuration.seed);
+
+        // The processor is created, laid out and prepared on the message thread.
+
+        auto processor = make_unique <EclistarVSTAudioProcessor>();
+        HostListener hostListener;
+
+        processor->addListener(&hostListener);
+
+        if (!processor->setBusesLayout(configuration.layout))
+        {
+            std::cerr << "Layout not supported: " << configuration.toString() << "\n";
+            processor->removeListener(&hostListener);
+            return 0;
+        }
+
+        processor->setProcessingPrecision(configuration.precision);
+
+        ChangeParameters(*processor, random, (int)processor->getParameters().size());
+        ChangeFeatures(*processor, random);
+
+        processor->prepareToPlay(configuration.sampleRate, configuration.maxBlockSize);
+
+        auto numViolations = configuration.precision == AudioProcessor::doublePrecision
+                           ? RunConfiguration <double>(*processor, configuration, options, random)
+                           : RunConfiguration <float>(*processor, configuration, options, random);
+
+        processor->releaseResources();
+        processor->removeListener(&hostListener);
+
+        return numViolations;
+    }
+}
+
+//==============================================================================================
+
+int main(int argc, char* argv[])
+{
+    // The message manager is needed by the parameters of the processor (APVTS timer).
+
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ValidateOptions options;
+    StringArray arguments;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        arguments.add(CharPointer_UTF8(argv[i]));
+    }
+
+    if (!ParseOptions(arguments, options))
+    {
+        std::cerr << usage;
+        return 1;
+    }
+
+    realtime_safety::initialise();
+    realtime_safety::setAbortOnViolation(options.abortOnViolation);
+
+    auto numFailedConfigurations = 0;
+
+    for (int i = 0; i < options.numConfigurations; ++i)
+    {
+        auto configuration = MakeConfiguration(options.seed + i);
+
+        if (ValidateConfiguration(configuration, options) > 0)
+            ++numFailedConfigurations;
+    }
+
+    using realtime_safety::getNumberOfViolations;
+
+    std::cout << options.numConfigurations << " configurations of " << options.numBlocks << " blocks: "
+              << getNumberOfViolations(realtime_safety::allocation) << " allocations, "
+              << getNumberOfViolations(realtime_safety::lock) << " locks, "
+              << getNumberOfViolations(realtime_safety::systemCall) << " system calls on the audio thread";
+
+    if (numFailedConfigurations > 0)
+        std::cout << " (in " << numFailedConfigurations << " configurations, rerun one with --seed <its seed> --configurations 1)";
+
+    std::cout << "\n";
+
+    return getNumberOfViolations() > 0 ? 1 : 0;
+}
@@ -0,0 +1,419 @@
+#include "RealtimeSafety.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+//==============================================================================================
+// The allocator of glibc under its own names: the replaced functions forward to them, so the
+// allocation functions never need dlsym (which allocates itself).
+
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void __libc_free(void* pointer);
+    void* __libc_memalign(size_t alignment, size_t size);
+}
+
+//==============================================================================================
+// State of the tracer.
+
+namespace realtime_safety
+{
+    namespace
+    {
+        std::atomic<int> numberOfViolations[numViolations]{};
+        std::atomic<bool> abortOnViolation{ false };
+
+        thread_local int audioThreadDepth = 0;
+        thread_local bool isReporting = false;
+
+        const char* const violationNames[numViolations] = { "allocation", "lock", "system call" };
+
+        // Call stacks already printed (hashes of their return addresses), so a violation in a
+        // loop is printed once. Only the audio thread writes them.
+
+        constexpr int maxNumStacks = 256;
+        constexpr int maxNumFrames = 48;
+
+        uint64_t printedStacks[maxNumStacks]{};
+        int numPrintedStacks = 0;
+
+        bool IsNewStack(void* const* frames, int numFrames) noexcept
+        {
+            uint64_t hash = 14695981039346656037ull;
+
+            for (int i = 0; i < numFrames; ++i)
+            {
+                hash = (hash ^ (uint64_t)(uintptr_t)frames[i]) * 1099511628211ull;
+            }
+
+            for (int i = 0; i < numPrintedStacks; ++i)
+            {
+                if (printedStacks[i] == hash)
+                    return false;
+            }
+
+            if (numPrintedStacks < maxNumStacks)
+            {
+                printedStacks[numPrintedStacks++] = hash;
+            }
+
+            return true;
+        }
+
+        // Reporting writes to stderr, which goes through the replaced write(), so the tracer is
+        // switched off meanwhile. snprintf and backtrace_symbols_fd do not allocate.
+
+        void Check(Violation kind, const char* function) noexcept
+        {
+            if (audioThreadDepth == 0 || isReporting)
+                return;
+
+            isReporting = true;
+            numberOfViolations[kind].fetch_add(1, std::memory_order_relaxed);
+
+            void* frames[maxNumFrames];
+            auto numFrames = backtrace(frames, maxNumFrames);
+
+            if (IsNewStack(frames, numFrames))
+            {
+                char header[256];
+                auto length = snprintf(header, sizeof(header),
+                                       "\n*** Real-time violation on the audio thread: %s (%s)\n",
+                                       violationNames[kind], function);
+
+                if (write(STDERR_FILENO, header, (size_t)length) < 0)
+                {
+                    // Nothing else can report it.
+                }
+
+                backtrace_symbols_fd(frames + 1, numFrames - 1, STDERR_FILENO);
+            }
+
+            if (abortOnViolation.load(std::memory_order_relaxed))
+                abort();
+
+            isReporting = false;
+        }
+
+        // Functions of the C library behind the replaced ones, looked up on the first call
+        // (initialise() looks them all up before the audio thread starts).
+
+        template <typename Function>
+
+        Function Next(std::atomic<Function>& cached, const char* name) noexcept
+        {
+            auto function = cached.load(std::memory_order_relaxed);
+
+            if (function == nullptr)
+            {
+                function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+                cached.store(function, std::memory_order_relaxed);
+            }
+
+            return function;
+        }
+
+        std::atomic<int (*)(pthread_mutex_t*)> nextMutexLock{ nullptr };
+        std::atomic<int (*)(pthread_mutex_t*, const struct timespec*)> nextMutexTimedLock{ nullptr };
+        std::atomic<int (*)(pthread_rwlock_t*)> nextReadLock{ nullptr };
+        std::atomic<int (*)(pthread_rwlock_t*)> nextWriteLock{ nullptr };
+
+        std::atomic<ssize_t (*)(int, void*, size_t)> nextRead{ nullptr };
+        std::atomic<ssize_t (*)(int, const void*, size_t)> nextWrite{ nullptr };
+        std::atomic<int (*)(const char*, int, ...)> nextOpen{ nullptr };
+        std::atomic<int (*)(int, const char*, int, ...)> nextOpenAt{ nullptr };
+        std::atomic<int (*)(int)> nextClose{ nullptr };
+        std::atomic<int (*)(const struct timespec*, struct timespec*)> nextNanoSleep{ nullptr };
+        std::atomic<int (*)(clockid_t, int, const struct timespec*, struct timespec*)> nextClockNanoSleep{ nullptr };
+        std::atomic<int (*)(useconds_t)> nextMicroSleep{ nullptr };
+        std::atomic<int (*)()> nextYield{ nullptr };
+        std::atomic<int (*)(struct pollfd*, nfds_t, int)> nextPoll{ nullptr };
+        std::atomic<void* (*)(void*, size_t, int, int, int, off_t)> nextMemoryMap{ nullptr };
+        std::atomic<int (*)(void*, size_t)> nextMemoryUnmap{ nullptr };
+        std::atomic<long (*)(long, ...)> nextSystemCall{ nullptr };
+    }
+
+    ScopedAudioThread::ScopedAudioThread() noexcept
+    {
+        ++audioThreadDepth;
+    }
+
+    ScopedAudioThread::~ScopedAudioThread() noexcept
+    {
+        --audioThreadDepth;
+    }
+
+    void initialise()
+    {
+        Next(nextMutexLock, "pthread_mutex_lock");
+        Next(nextMutexTimedLock, "pthread_mutex_timedlock");
+        Next(nextReadLock, "pthread_rwlock_rdlock");
+        Next(nextWriteLock, "pthread_rwlock_wrlock");
+
+        Next(nextRead, "read");
+        Next(nextWrite, "write");
+        Next(nextOpen, "open");
+        Next(nextOpenAt, "openat");
+        Next(nextClose, "close");
+        Next(nextNanoSleep, "nanosleep");
+        Next(nextClockNanoSleep, "clock_nanosleep");
+        Next(nextMicroSleep, "usleep");
+        Next(nextYield, "sched_yield");
+        Next(nextPoll, "poll");
+        Next(nextMemoryMap, "mmap");
+        Next(nextMemoryUnmap, "munmap");
+        Next(nextSystemCall, "syscall");
+
+        // The first backtrace() loads the unwinder.
+
+        void* frames[maxNumFrames];
+        backtrace(frames, maxNumFrames);
+    }
+
+    int getNumberOfViolations(Violation kind) noexcept
+    {
+        return numberOfViolations[kind].load(std::memory_order_relaxed);
+    }
+
+    int getNumberOfViolations() noexcept
+    {
+        auto total = 0;
+
+        for (auto& count : numberOfViolations)
+        {
+            total += count.load(std::memory_order_relaxed);
+        }
+
+        return total;
+    }
+
+    void setAbortOnViolation(bool shouldAbort) noexcept
+    {
+        abortOnViolation.store(shouldAbort, std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================================
+// Replaced functions. Everything that the executable or its libraries call through these
+// names ends up here (operator new and the containers of the standard library included).
+
+using namespace realtime_safety;
+
+extern "C"
+{
+    //------------------------------------------------------------------
+    // Allocation.
+
+    void* malloc(size_t size) noexcept
+    {
+        Check(allocation, "malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        Check(allocation, "calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) noexcept
+    {
+        Check(allocation, "realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer) noexcept
+    {
+        if (pointer != nullptr)
+            Check(allocation, "free");
+
+        __libc_free(pointer);
+    }
+
+    int posix_memalign(void** pointer, size_t alignment, size_t size) noexcept
+    {
+        Check(allocation, "posix_memalign");
+
+        if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment % sizeof(void*) != 0)
+            return EINVAL;
+
+        auto* memory = __libc_memalign(alignment, size);
+
+        if (memory == nullptr)
+            return ENOMEM;
+
+        *pointer = memory;
+        return 0;
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        Check(allocation, "aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) noexcept
+    {
+        Check(allocation, "memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* valloc(size_t size) noexcept
+    {
+        Check(allocation, "valloc");
+        return __libc_memalign((size_t)sysconf(_SC_PAGESIZE), size);
+    }
+
+    //------------------------------------------------------------------
+    // Locks that may block (the try-locks and the unlocks do not wait, they are allowed).
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        Check(lock, "pthread_mutex_lock");
+        return Next(nextMutexLock, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_mutex_timedlock(pthread_mutex_t* mutex, const struct timespec* timeout) noexcept
+    {
+        Check(lock, "pthread_mutex_timedlock");
+        return Next(nextMutexTimedLock, "pthread_mutex_timedlock")(mutex, timeout);
+    }
+
+    int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock) noexcept
+    {
+        Check(lock, "pthread_rwlock_rdlock");
+        return Next(nextReadLock, "pthread_rwlock_rdlock")(rwlock);
+    }
+
+    int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock) noexcept
+    {
+        Check(lock, "pthread_rwlock_wrlock");
+        return Next(nextWriteLock, "pthread_rwlock_wrlock")(rwlock);
+    }
+
+    //------------------------------------------------------------------
+    // System calls: files and pipes, sleeps, memory mappings and the raw syscall() (futexes).
+    // clock_gettime is not one of them: it is served by the vDSO without entering the kernel.
+
+    ssize_t read(int file, void* data, size_t size)
+    {
+        Check(systemCall, "read");
+        return Next(nextRead, "read")(file, data, size);
+    }
+
+    ssize_t write(int file, const void* data, size_t size)
+    {
+        Check(systemCall, "write");
+        return Next(nextWrite, "write")(file, data, size);
+    }
+
+    int open(const char* path, int flags, ...)
+    {
+        Check(systemCall, "open");
+
+        va_list arguments;
+        va_start(arguments, flags);
+        auto mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg(arguments, mode_t) : (mode_t)0;
+        va_end(arguments);
+
+        return Next(nextOpen, "open")(path, flags, mode);
+    }
+
+    int openat(int directory, const char* path, int flags, ...)
+    {
+        Check(systemCall, "openat");
+
+        va_list arguments;
+        va_start(arguments, flags);
+        auto mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg(arguments, mode_t) : (mode_t)0;
+        va_end(arguments);
+
+        return Next(nextOpenAt, "openat")(directory, path, flags, mode);
+    }
+
+    int close(int file)
+    {
+        Check(systemCall, "close");
+        return Next(nextClose, "close")(file);
+    }
+
+    int nanosleep(const struct timespec* duration, struct timespec* remaining)
+    {
+        Check(systemCall, "nanosleep");
+        return Next(nextNanoSleep, "nanosleep")(duration, remaining);
+    }
+
+    int clock_nanosleep(clockid_t clock, int flags, const struct timespec* duration, struct timespec* remaining)
+    {
+        Check(systemCall, "clock_nanosleep");
+        return Next(nextClockNanoSleep, "clock_nanosleep")(clock, flags, duration, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        Check(systemCall, "usleep");
+        return Next(nextMicroSleep, "usleep")(microseconds);
+    }
+
+    int sched_yield() noexcept
+    {
+        Check(systemCall, "sched_yield");
+        return Next(nextYield, "sched_yield")();
+    }
+
+    int poll(struct pollfd* files, nfds_t numFiles, int timeout)
+    {
+        Check(systemCall, "poll");
+        return Next(nextPoll, "poll")(files, numFiles, timeout);
+    }
+
+    void* mmap(void* address, size_t size, int protection, int flags, int file, off_t offset) noexcept
+    {
+        Check(systemCall, "mmap");
+        return Next(nextMemoryMap, "mmap")(address, size, protection, flags, file, offset);
+    }
+
+    int munmap(void* address, size_t size) noexcept
+    {
+        Check(systemCall, "munmap");
+        return Next(nextMemoryUnmap, "munmap")(address, size);
+    }
+
+    // The arguments of a system call are passed in registers, six at most.
+
+    long syscall(long number, ...) noexcept
+    {
+        Check(systemCall, "syscall");
+
+        va_list arguments;
+        va_start(arguments, number);
+
+        long values[6];
+
+        for (auto& value : values)
+        {
+            value = va_arg(arguments, long);
+        }
+
+        va_end(arguments);
+
+        return Next(nextSystemCall, "syscall")(number, values[0], values[1], values[2], values[3], values[4], values[5]);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+//==============================================================================================
+// Real-time safety tracer of the validator (Linux only).
+//
+// The validator defines the allocation functions of the C library (malloc, free and the
+// others), the blocking pthread functions and the wrappers of the system calls that may block
+// or enter the kernel; every call is forwarded to the C library. While a ScopedAudioThread is
+// alive on the calling thread, each of these calls is also a violation: it is counted by kind
+// and, the first time its call stack is seen, printed to stderr with the stack.
+
+namespace realtime_safety
+{
+    enum Violation
+    {
+        allocation,
+        lock,
+        systemCall,
+
+        numViolations
+    };
+
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread() noexcept;
+    };
+
+    // Looks up the functions of the C library and loads the unwinder of backtrace() (both
+    // allocate), so it is called once before the first audio block.
+
+    void initialise();
+
+    // Number of violations since the start of the process, of one kind or all together.
+
+    int getNumberOfViolations(Violation kind) noexcept;
+    int getNumberOfViolations() noexcept;
+
+    // Stops the process at the first violation (for a debugger or a core dump).
+
+    void setAbortOnViolation(bool shouldAbort) noexcept;
+}